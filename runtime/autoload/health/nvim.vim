@@ -146,6 +146,31 @@ function! s:check_performance() abort
   endif
 endfunction
 
+function! s:check_latency() abort
+  call health#report_start('Latency')
+
+  let stats = nvim__latency(v:false)
+  if empty(stats)
+    call health#report_info('No samples collected yet.')
+    return
+  endif
+  for phase in ['key', 'input', 'vgetc', 'execute', 'redraw', 'flush', 'rpc']
+    if has_key(stats, phase)
+      let s = stats[phase]
+      call health#report_info(printf(
+            \ '%-8s %8d samples, median %.1f ms, p99 %.1f ms, max %.1f ms',
+            \ phase.':', s.count, s.p50 / 1000.0, s.p99 / 1000.0,
+            \ s.max / 1000.0))
+    endif
+  endfor
+  if has_key(stats, 'key') && stats.key.p99 > 100000
+    call health#report_warn(
+          \ 'Slow response to input: 1% of keys took more than 100 ms.',
+          \ ['Find out what is slow with `:call nvim__trace_start(0)`, reproduce the delay, then `:call nvim__trace_dump("trace.json")` and load the file in https://ui.perfetto.dev',
+          \  'See also `:help :profile`'])
+  endif
+endfunction
+
 function! s:get_tmux_option(option) abort
   let cmd = 'tmux show-option -qvg '.a:option  " try global scope
   let out = system(cmd)
@@ -268,6 +293,7 @@ endfunction
 function! health#nvim#check() abort
   call s:check_config()
   call s:check_performance()
+  call s:check_latency()
   call s:check_rplugin_manifest()
   call s:check_terminal()
   call s:check_tmux()
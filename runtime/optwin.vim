@@ -989,6 +989,8 @@ call <SID>OptionG("ffs", &ffs)
 call append("$", "\t(local to buffer)")
 call append("$", "write\twriting files is allowed")
 call <SID>BinOptionG("write", &write)
+call append("$", "writebackground\twrite files in the background with :write")
+call <SID>BinOptionG("wbg", &wbg)
 call append("$", "writebackup\twrite a backup file before overwriting a file")
 call <SID>BinOptionG("wb", &wb)
 call append("$", "backup\tkeep a backup after overwriting a file")
@@ -1023,6 +1025,8 @@ call <SID>OptionG("dir", &dir)
 call append("$", "swapfile\tuse a swap file for this buffer")
 call append("$", "\t(local to buffer)")
 call <SID>BinOptionL("swf")
+call append("$", "swapcache\tmaximum memory in Kbyte used for the text of all buffers")
+call append("$", " \tset swc=" . &swc)
 call append("$", "updatecount\tnumber of characters typed to cause a swap file update")
 call append("$", " \tset uc=" . &uc)
 call append("$", "updatetime\ttime in msec after which the swap file will be updated")
@@ -1115,6 +1119,8 @@ if has("quickfix")
   call append("$", "makeencoding\tencoding of the \":make\" and \":grep\" output")
   call append("$", "\t(global or local to buffer)")
   call <SID>OptionG("menc", &menc)
+  call append("$", "vimgrepprefetch\tnumber of files \":vimgrep\" reads in advance")
+  call append("$", " \tset vgp=" . &vgp)
 endif
 
 
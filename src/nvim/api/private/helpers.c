@@ -1045,25 +1045,30 @@ fail_with_message:
 bool buf_collect_lines(buf_T *buf, size_t n, int64_t start, bool replace_nl,
                        Array *l, Error *err)
 {
-  for (size_t i = 0; i < n; i++) {
-    int64_t lnum = start + (int64_t)i;
-
-    if (lnum >= MAXLNUM) {
-      if (err != NULL) {
-        api_set_error(err, kErrorTypeValidation, "Line index is too high");
-      }
-      return false;
+  if (n > 0 && start + (int64_t)n - 1 >= MAXLNUM) {
+    if (err != NULL) {
+      api_set_error(err, kErrorTypeValidation, "Line index is too high");
     }
+    return false;
+  }
 
-    const char *bufstr = (char *)ml_get_buf(buf, (linenr_T)lnum, false);
-    Object str = STRING_OBJ(cstr_to_string(bufstr));
-
-    if (replace_nl) {
-      // Vim represents NULs as NLs, but this may confuse clients.
-      strchrsub(str.data.string.data, '\n', '\0');
+  const linenr_T end = (linenr_T)(start + (int64_t)n - 1);
+  linenr_T lnum = (linenr_T)start;
+  size_t i = 0;
+  while (lnum <= end) {
+    // Get all the lines of a data block at once.
+    char_u *lines[ML_GET_BLOCK_MAX];
+    size_t lens[ML_GET_BLOCK_MAX];
+    const int count = ml_get_block(buf, lnum, end, ML_GET_BLOCK_MAX,
+                                   lines, lens);
+    for (int j = 0; j < count; j++, lnum++, i++) {
+      String str = cbuf_to_string((char *)lines[j], lens[j]);
+      if (replace_nl) {
+        // Vim represents NULs as NLs, but this may confuse clients.
+        memchrsub(str.data, '\n', '\0', str.size);
+      }
+      l->items[i] = STRING_OBJ(str);
     }
-
-    l->items[i] = str;
   }
 
   return true;
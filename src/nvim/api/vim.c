@@ -23,12 +23,15 @@
 #include "nvim/buffer.h"
 #include "nvim/context.h"
 #include "nvim/file_search.h"
+#include "nvim/hashtab.h"
 #include "nvim/highlight.h"
+#include "nvim/latency.h"
 #include "nvim/window.h"
 #include "nvim/types.h"
 #include "nvim/ex_cmds2.h"
 #include "nvim/ex_docmd.h"
 #include "nvim/screen.h"
+#include "nvim/memfile.h"
 #include "nvim/memline.h"
 #include "nvim/mark.h"
 #include "nvim/memory.h"
@@ -45,6 +48,7 @@
 #include "nvim/state.h"
 #include "nvim/decoration.h"
 #include "nvim/syntax.h"
+#include "nvim/trace.h"
 #include "nvim/getchar.h"
 #include "nvim/os/input.h"
 #include "nvim/os/process.h"
@@ -2738,10 +2742,89 @@ Dictionary nvim__stats(void)
   Dictionary rv = ARRAY_DICT_INIT;
   PUT(rv, "fsync", INTEGER_OBJ(g_stats.fsync));
   PUT(rv, "redraw", INTEGER_OBJ(g_stats.redraw));
+  PUT(rv, "regexp_cache_hit", INTEGER_OBJ(g_stats.regexp_cache_hit));
+  PUT(rv, "regexp_cache_miss", INTEGER_OBJ(g_stats.regexp_cache_miss));
+  PUT(rv, "memfile_cache_hit", INTEGER_OBJ(g_stats.memfile_cache_hit));
+  PUT(rv, "memfile_cache_miss", INTEGER_OBJ(g_stats.memfile_cache_miss));
+  PUT(rv, "memfile_cache_evict", INTEGER_OBJ(g_stats.memfile_cache_evict));
+  PUT(rv, "memfile_cache_bytes", INTEGER_OBJ((Integer)mf_cache_size()));
+  PUT(rv, "memfile_async_write", INTEGER_OBJ((Integer)mf_writer_count()));
+  size_t intern_hit;
+  size_t intern_miss;
+  const size_t intern_keys = hash_intern_stats(&intern_hit, &intern_miss);
+  PUT(rv, "intern_keys", INTEGER_OBJ((Integer)intern_keys));
+  PUT(rv, "intern_hit", INTEGER_OBJ((Integer)intern_hit));
+  PUT(rv, "intern_miss", INTEGER_OBJ((Integer)intern_miss));
   PUT(rv, "lua_refcount", INTEGER_OBJ(nlua_refcount));
   return rv;
 }
 
+/// Gets latency statistics of the main loop. Samples are always collected,
+/// for these phases:
+///   - "key"      From input arriving until the UI flush after reading it
+///   - "input"    Queueing input
+///   - "vgetc"    Getting a key, not counting the time waiting for it
+///   - "execute"  Executing a key (Normal mode command, Insert mode key, ...)
+///   - "redraw"   Updating the screen
+///   - "flush"    Sending the screen updates to the UIs
+///   - "rpc"      Handling an RPC request or notification
+///
+/// Also shown by |:checkhealth| (in the "nvim" section).
+///
+/// @param reset  Discard the samples collected so far.
+/// @return Map of phase names to maps with "count" and "min", "max", "mean",
+///         "p50", "p90", "p99" and "p999" times in microseconds. Phases
+///         without samples are left out.
+Dictionary nvim__latency(Boolean reset)
+{
+  Dictionary rv = latency_stats();
+  if (reset) {
+    latency_reset();
+  }
+  return rv;
+}
+
+/// Starts recording a trace of sourcing, autocommands, redraws, RPC requests
+/// and other internal spans. See |nvim__trace_dump()|.
+///
+/// Restarting discards the spans recorded so far.
+///
+/// @param size  Number of spans to keep, older ones are overwritten. Zero for
+///              the default.
+/// @param[out] err Error details, if any
+void nvim__trace_start(Integer size, Error *err)
+{
+  if (size < 0 || size > INT32_MAX) {
+    api_set_error(err, kErrorTypeValidation, "Invalid size");
+    return;
+  }
+  trace_start(size > 0 ? (size_t)size : TRACE_DEFAULT_SIZE);
+}
+
+/// Stops recording a trace and discards it.
+void nvim__trace_stop(void)
+{
+  trace_stop();
+}
+
+/// Writes the spans recorded since |nvim__trace_start()| in the Chrome
+/// trace-event format, for chrome://tracing or https://ui.perfetto.dev.
+///
+/// Recording continues.
+///
+/// @param path  File to write.
+/// @param[out] err Error details, if any
+/// @return Number of spans written.
+Integer nvim__trace_dump(String path, Error *err)
+{
+  int64_t count = trace_dump(path.data);
+  if (count < 0) {
+    api_set_error(err, kErrorTypeException, "Failed to open %s", path.data);
+    return 0;
+  }
+  return count;
+}
+
 /// Gets a list of dictionaries representing attached UIs.
 ///
 /// @return Array of UI dictionaries, each with these keys:
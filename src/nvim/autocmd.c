@@ -21,6 +21,7 @@
 #include "nvim/regexp.h"
 #include "nvim/search.h"
 #include "nvim/state.h"
+#include "nvim/trace.h"
 #include "nvim/ui_compositor.h"
 #include "nvim/vim.h"
 
@@ -1628,8 +1629,10 @@ static bool apply_autocmds_group(event_T event,
     }
 
     // Execute the autocmd. The `getnextac` callback handles iteration.
+    const TraceSpan trace_span = trace_begin();
     do_cmdline(NULL, getnextac, (void *)&patcmd,
                DOCMD_NOWAIT | DOCMD_VERBOSE | DOCMD_REPEAT);
+    trace_end(trace_span, "autocmd", event_nr2name(event), (char *)fname);
 
     if (nesting == 1) {
       // restore cursor and topline, unless they were changed
@@ -1888,6 +1891,24 @@ char_u *getnextac(int c, void *cookie, int indent, bool do_concat)
 bool has_autocmd(event_T event,
                  char_u *sfname,
                  buf_T *buf) FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  return has_autocmd_skip(event, sfname, buf, AUGROUP_ERROR);
+}
+
+/// Like has_autocmd(), but ignores the autocommands in augroup "group".
+bool has_autocmd_except(event_T event, char_u *sfname, buf_T *buf,
+                        const char *group)
+  FUNC_ATTR_WARN_UNUSED_RESULT FUNC_ATTR_NONNULL_ARG(2, 4)
+{
+  return has_autocmd_skip(event, sfname, buf,
+                          au_find_group((const char_u *)group));
+}
+
+/// Implementation of has_autocmd(), ignoring autocommands in group
+/// "skip_group" (AUGROUP_ERROR to ignore none).
+static bool has_autocmd_skip(event_T event, char_u *sfname, buf_T *buf,
+                             int skip_group)
+  FUNC_ATTR_WARN_UNUSED_RESULT
 {
   AutoPat *ap;
   char_u *fname;
@@ -1909,6 +1930,7 @@ bool has_autocmd(event_T event,
 
   for (ap = first_autopat[(int)event]; ap != NULL; ap = ap->next) {
     if (ap->pat != NULL && ap->cmds != NULL
+        && ap->group != skip_group
         && (ap->buflocal_nr == 0
             ? match_file_pat(
                 NULL,
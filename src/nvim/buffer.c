@@ -682,6 +682,9 @@ void buf_freeall(buf_T *buf, int flags)
   win_T *the_curwin = curwin;
   tabpage_T *the_curtab = curtab;
 
+  // The text may still be needed for 'writebackground'.
+  buf_write_bg_wait(buf, false);
+
   // Make sure the buffer isn't closed by autocommands.
   buf->b_locked++;
 
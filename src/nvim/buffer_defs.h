@@ -420,6 +420,8 @@ typedef struct {
 typedef struct {
   hashtab_T b_keywtab;                  // syntax keywords hash table
   hashtab_T b_keywtab_ic;               // idem, ignore case
+  keywindex_T *b_keywindex;             // b_keywtab and b_keywtab_ic indexed
+                                        // for matching, NULL when outdated
   int b_syn_error;                      // TRUE when error occurred in HL
   bool b_syn_slow;                      // true when 'redrawtime' reached
   int b_syn_ic;                         // ignore case for :syn cmds
@@ -454,6 +456,10 @@ typedef struct {
   // b_sst_first        pointer to first used entry in b_sst_array[] or NULL
   // b_sst_firstfree    pointer to first free entry in b_sst_array[] or NULL
   // b_sst_freecount    number of free entries in b_sst_array[]
+  // b_sst_index        used entries sorted on line number, for binary search
+  // b_sst_index_len    number of entries in b_sst_index[]
+  // b_sst_idle_lnum    lines before this one were parsed in the background,
+  //                    see syntax_idle_schedule()
   // b_sst_check_lnum   entries after this lnum need to be checked for
   //                    validity (MAXLNUM means no check needed)
   synstate_T  *b_sst_array;
@@ -461,6 +467,9 @@ typedef struct {
   synstate_T  *b_sst_first;
   synstate_T  *b_sst_firstfree;
   int b_sst_freecount;
+  synstate_T  **b_sst_index;
+  int b_sst_index_len;
+  linenr_T b_sst_idle_lnum;
   linenr_T b_sst_check_lnum;
   disptick_T b_sst_lasttick;    // last display tick
 
@@ -559,6 +568,8 @@ struct file_buffer {
 
   bool b_saving;                /* Set to true if we are in the middle of
                                    saving the buffer. */
+  bool b_write_bg;              ///< Being written in the background, see
+                                ///< 'writebackground'.
 
   /*
    * Changes to a buffer require updating of the display.  To minimize the
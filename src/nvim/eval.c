@@ -49,6 +49,7 @@
 #include "nvim/search.h"
 #include "nvim/sign.h"
 #include "nvim/syntax.h"
+#include "nvim/trace.h"
 #include "nvim/ui.h"
 #include "nvim/undo.h"
 #include "nvim/version.h"
@@ -4780,6 +4781,7 @@ bool garbage_collect(bool testing)
 {
   bool abort = false;
 #define ABORTING(func) abort = abort || func
+  const TraceSpan trace_span = trace_begin();
 
   if (!testing) {
     // Only do this once.
@@ -4949,6 +4951,7 @@ bool garbage_collect(bool testing)
         "Not enough memory to set references, garbage collection aborted!"));
   }
 #undef ABORTING
+  trace_end(trace_span, "vim", "garbage_collect", NULL);
   return did_free;
 }
 
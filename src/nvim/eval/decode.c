@@ -13,6 +13,7 @@
 #include "nvim/macros.h"
 #include "nvim/message.h"
 #include "nvim/globals.h"
+#include "nvim/hashtab.h"
 #include "nvim/charset.h"  // vim_str2nr
 #include "nvim/lib/kvec.h"
 #include "nvim/vim.h"  // OK, FAIL
@@ -35,13 +36,18 @@ typedef struct {
   bool didcomma;           ///< True if previous token was comma.
   bool didcolon;           ///< True if previous token was colon.
   typval_T val;            ///< Actual value.
+  const char_u *ikey;      ///< Interned copy of the value if it is a key of
+                           ///< a regular dictionary, may be NULL.
 } ValuesStackItem;
 
 /// Vector containing values not yet saved in any container
-typedef kvec_t(ValuesStackItem) ValuesStack;
+///
+/// Initial array is big enough for typical nesting depth, so decoding does not
+/// need to allocate the stack at all.
+typedef kvec_withinit_t(ValuesStackItem, 16) ValuesStack;
 
 /// Vector containing containers, each next container is located inside previous
-typedef kvec_t(ContainerStackItem) ContainerStack;
+typedef kvec_withinit_t(ContainerStackItem, 16) ContainerStack;
 
 #ifdef INCLUDE_GENERATED_DECLARATIONS
 # include "eval/decode.c.generated.h"
@@ -107,7 +113,7 @@ static inline int json_decoder_pop(ValuesStackItem obj,
   FUNC_ATTR_NONNULL_ALL
 {
   if (kv_size(*container_stack) == 0) {
-    kv_push(*stack, obj);
+    kvi_push(*stack, obj);
     return OK;
   }
   ContainerStackItem last_container = kv_last(*container_stack);
@@ -142,13 +148,24 @@ static inline int json_decoder_pop(ValuesStackItem obj,
       assert(!(key.is_special_string
                || key.val.vval.v_string == NULL
                || *key.val.vval.v_string == NUL));
-      dictitem_T *const obj_di = tv_dict_item_alloc(
-          (const char *)key.val.vval.v_string);
-      tv_clear(&key.val);
-      if (tv_dict_add(last_container.container.vval.v_dict, obj_di)
-          == FAIL) {
-        abort();
+      dictitem_T *obj_di;
+      if (key.ikey != NULL) {
+        // Interned key already carries its hash and length, so adding does
+        // not need to hash the key again.
+        obj_di = tv_dict_item_alloc_len((const char *)key.ikey,
+                                        hash_intern_len(key.ikey));
+        if (tv_dict_add_interned(last_container.container.vval.v_dict,
+                                 obj_di, key.ikey) == FAIL) {
+          abort();
+        }
+      } else {
+        obj_di = tv_dict_item_alloc((const char *)key.val.vval.v_string);
+        if (tv_dict_add(last_container.container.vval.v_dict, obj_di)
+            == FAIL) {
+          abort();
+        }
       }
+      tv_clear(&key.val);
       obj_di->di_tv = obj.val;
     } else {
       list_T *const kv_pair = tv_list_alloc(2);
@@ -169,13 +186,25 @@ static inline int json_decoder_pop(ValuesStackItem obj,
       tv_clear(&obj.val);
       return FAIL;
     }
+    if (last_container.special_val == NULL
+        && !obj.is_special_string
+        && obj.val.vval.v_string != NULL
+        && *obj.val.vval.v_string != NUL) {
+      // Keys are usually repeated across many dictionaries (e.g. arrays of
+      // objects), interning them computes their hash only once.
+      obj.ikey = hash_intern((const char *)obj.val.vval.v_string,
+                             STRLEN(obj.val.vval.v_string));
+    }
     // Handle empty key and key represented as special dictionary
     if (last_container.special_val == NULL
         && (obj.is_special_string
             || obj.val.vval.v_string == NULL
             || *obj.val.vval.v_string == NUL
-            || tv_dict_find(last_container.container.vval.v_dict,
-                            (const char *)obj.val.vval.v_string, -1))) {
+            || (obj.ikey != NULL
+                ? tv_dict_find_interned(last_container.container.vval.v_dict,
+                                        obj.ikey)
+                : tv_dict_find(last_container.container.vval.v_dict,
+                               (const char *)obj.val.vval.v_string, -1)))) {
       tv_clear(&obj.val);
 
       // Restart
@@ -191,19 +220,25 @@ static inline int json_decoder_pop(ValuesStackItem obj,
       *next_map_special = true;
       return OK;
     }
-    kv_push(*stack, obj);
+    kvi_push(*stack, obj);
   }
   return OK;
 }
 
 #define LENP(p, e) \
     ((int) ((e) - (p))), (p)
+/// Check whether byte may appear in JSON string as-is and is a complete
+/// character: printable ASCII except for quote and backslash.
+#define JSON_IS_PLAIN_BYTE(c) \
+    ((uint8_t)(c) >= 0x20 && (uint8_t)(c) < 0x80 \
+     && (c) != '"' && (c) != '\\')
 #define OBJ(obj_tv, is_sp_string, didcomma_, didcolon_) \
   ((ValuesStackItem) { \
     .is_special_string = (is_sp_string), \
     .val = (obj_tv), \
     .didcomma = (didcomma_), \
     .didcolon = (didcolon_), \
+    .ikey = NULL, \
   })
 
 #define POP(obj_tv, is_sp_string) \
@@ -328,8 +363,18 @@ static inline int parse_json_string(const char *const buf, const size_t buf_len,
   size_t len = 0;
   const char *const s = ++p;
   int ret = OK;
+  bool has_escapes = false;
   while (p < e && *p != '"') {
-    if (*p == '\\') {
+    if (JSON_IS_PLAIN_BYTE(*p)) {
+      // Skip over the whole run of printable ASCII: it needs neither UTF-8
+      // validation nor unescaping.
+      const char *const run_start = p;
+      do {
+        p++;
+      } while (p < e && JSON_IS_PLAIN_BYTE(*p));
+      len += (size_t)(p - run_start);
+    } else if (*p == '\\') {
+      has_escapes = true;
       p++;
       if (p == e) {
         emsgf(_("E474: Unfinished escape sequence: %.*s"),
@@ -414,6 +459,17 @@ static inline int parse_json_string(const char *const buf, const size_t buf_len,
     }), false);
     goto parse_json_string_ret;
   }
+  if (!has_escapes) {
+    // Without escapes string is copied as-is, and it cannot contain NUL:
+    // control characters were rejected above.
+    assert(len == (size_t)(p - s));
+    POP(((typval_T) {
+      .v_type = VAR_STRING,
+      .v_lock = VAR_UNLOCKED,
+      .vval = { .v_string = (char_u *)xmemdupz(s, len) },
+    }), false);
+    goto parse_json_string_ret;
+  }
   char *str = xmalloc(len + 1);
   int fst_in_pair = 0;
   char *str_end = str;
@@ -670,8 +726,10 @@ int json_decode_string(const char *const buf, const size_t buf_len,
     return FAIL;
   }
   int ret = OK;
-  ValuesStack stack = KV_INITIAL_VALUE;
-  ContainerStack container_stack = KV_INITIAL_VALUE;
+  ValuesStack stack;
+  kvi_init(stack);
+  ContainerStack container_stack;
+  kvi_init(container_stack);
   rettv->v_type = VAR_UNKNOWN;
   bool didcomma = false;
   bool didcolon = false;
@@ -856,13 +914,13 @@ json_decode_string_cycle_start:
           .v_lock = VAR_UNLOCKED,
           .vval = { .v_list = list },
         };
-        kv_push(container_stack, ((ContainerStackItem) {
+        kvi_push(container_stack, ((ContainerStackItem) {
           .stack_index = kv_size(stack),
           .s = p,
           .container = tv,
           .special_val = NULL,
         }));
-        kv_push(stack, OBJ(tv, false, didcomma, didcolon));
+        kvi_push(stack, OBJ(tv, false, didcomma, didcolon));
         break;
       }
       case '{': {
@@ -880,13 +938,13 @@ json_decode_string_cycle_start:
             .vval = { .v_dict = dict },
           };
         }
-        kv_push(container_stack, ((ContainerStackItem) {
+        kvi_push(container_stack, ((ContainerStackItem) {
           .stack_index = kv_size(stack),
           .s = p,
           .container = tv,
           .special_val = val_list,
         }));
-        kv_push(stack, OBJ(tv, false, didcomma, didcolon));
+        kvi_push(stack, OBJ(tv, false, didcomma, didcolon));
         break;
       }
       default: {
@@ -927,13 +985,14 @@ json_decode_string_fail:
     tv_clear(&(kv_pop(stack).val));
   }
 json_decode_string_ret:
-  kv_destroy(stack);
-  kv_destroy(container_stack);
+  kvi_destroy(stack);
+  kvi_destroy(container_stack);
   return ret;
 }
 
 #undef LENP
 #undef POP
+#undef JSON_IS_PLAIN_BYTE
 
 #undef OBJ
 
@@ -1079,7 +1138,12 @@ int msgpack_to_vim(const msgpack_object mobj, typval_T *const rettv)
         memcpy(&di->di_key[0], mobj.via.map.ptr[i].key.via.str.ptr,
                mobj.via.map.ptr[i].key.via.str.size);
         di->di_tv.v_type = VAR_UNKNOWN;
-        if (tv_dict_add(dict, di) == FAIL) {
+        const char_u *const ikey = hash_intern(
+            mobj.via.map.ptr[i].key.via.str.ptr,
+            mobj.via.map.ptr[i].key.via.str.size);
+        if ((ikey != NULL
+             ? tv_dict_add_interned(dict, di, ikey)
+             : tv_dict_add(dict, di)) == FAIL) {
           // Duplicate key: fallback to generic map
           tv_clear(rettv);
           xfree(di);
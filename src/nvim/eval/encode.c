@@ -564,6 +564,33 @@ static const char escapes[][3] = {
 
 static const char xdigits[] = "0123456789ABCDEF";
 
+/// Bytes which are copied to JSON strings as-is
+///
+/// This is printable ASCII except for '"' and '\\'. Other bytes need either
+/// escaping or UTF-8 validation.
+static const bool json_raw_ascii[256] = {
+  [0x20] =
+  1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0x20: '"' is escaped
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0x30
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0x40
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1,  // 0x50: '\\' is escaped
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  // 0x60
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0,  // 0x70: DEL is checked
+                                                   // by utf_printable()
+};
+
+/// Get length of the run of json_raw_ascii bytes at the start of the string
+static inline size_t json_raw_ascii_len(const char *const buf,
+                                        const size_t len)
+  FUNC_ATTR_NONNULL_ALL FUNC_ATTR_PURE FUNC_ATTR_ALWAYS_INLINE
+{
+  size_t i = 0;
+  while (i < len && json_raw_ascii[(uint8_t)buf[i]]) {
+    i++;
+  }
+  return i;
+}
+
 /// Convert given string to JSON string
 ///
 /// @param[out]  gap  Garray where result will be saved.
@@ -582,7 +609,17 @@ static inline int convert_to_json_string(garray_T *const gap,
   } else {
     size_t utf_len = len;
     char *tofree = NULL;
-    size_t str_len = 0;
+    // Most strings (keys, identifiers, paths) are plain ASCII: copy them
+    // without decoding characters.
+    const size_t raw_prefix_len = json_raw_ascii_len(utf_buf, utf_len);
+    if (raw_prefix_len == utf_len) {
+      ga_grow(gap, (int)utf_len + 2);
+      ga_append(gap, '"');
+      ga_concat_len(gap, utf_buf, utf_len);
+      ga_append(gap, '"');
+      return OK;
+    }
+    size_t str_len = raw_prefix_len;
     // Encode character as \uNNNN if
     // 1. It is an ASCII control character (0x0 .. 0x1F; 0x7F not
     //    utf_printable and thus not checked specially).
@@ -591,7 +628,13 @@ static inline int convert_to_json_string(garray_T *const gap,
     // Neovim.
 #define ENCODE_RAW(ch) \
     (ch >= 0x20 && utf_printable(ch))
-    for (size_t i = 0; i < utf_len;) {
+    for (size_t i = raw_prefix_len; i < utf_len;) {
+      if (json_raw_ascii[(uint8_t)utf_buf[i]]) {
+        const size_t run_len = json_raw_ascii_len(utf_buf + i, utf_len - i);
+        str_len += run_len;
+        i += run_len;
+        continue;
+      }
       const int ch = utf_ptr2char(utf_buf + i);
       const size_t shift = (ch == 0? 1: utf_ptr2len(utf_buf + i));
       assert(shift > 0);
@@ -631,9 +674,15 @@ static inline int convert_to_json_string(garray_T *const gap,
         }
       }
     }
+    ga_grow(gap, (int) str_len + 2);
     ga_append(gap, '"');
-    ga_grow(gap, (int) str_len);
     for (size_t i = 0; i < utf_len;) {
+      if (json_raw_ascii[(uint8_t)utf_buf[i]]) {
+        const size_t run_len = json_raw_ascii_len(utf_buf + i, utf_len - i);
+        ga_concat_len(gap, utf_buf + i, run_len);
+        i += run_len;
+        continue;
+      }
       const int ch = utf_ptr2char(utf_buf + i);
       const size_t shift = (ch == 0? 1: utf_char2len(ch));
       assert(shift > 0);
@@ -846,6 +895,100 @@ char *encode_tv2echo(typval_T *tv, size_t *len)
   return (char *) ga.ga_data;
 }
 
+/// Number of values json_size_estimate() looks at
+#define JSON_ESTIMATE_BUDGET 4096
+
+/// Largest estimate, also the most json_encode() preallocates
+#define JSON_ESTIMATE_MAX (4 * 1024 * 1024)
+
+/// Add sizes for json_size_estimate(), saturating at JSON_ESTIMATE_MAX
+static inline size_t json_size_add(const size_t a, const size_t b)
+  FUNC_ATTR_CONST FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  return MIN(a + b, JSON_ESTIMATE_MAX);
+}
+
+/// Estimate length of the JSON representation of the value
+///
+/// Used to preallocate json_encode() result, so that encoding large values
+/// does not keep reallocating the output. Only a limited number of values is
+/// inspected, which also protects against recursive containers: size of the
+/// rest of a list is extrapolated from the items seen, unless an item could
+/// not be inspected completely.
+///
+/// @param[in]  tv  Value to estimate.
+/// @param[in,out]  budget  Number of values which may still be inspected.
+///
+/// @return Estimated length in bytes, at most JSON_ESTIMATE_MAX.
+static size_t json_size_estimate(const typval_T *const tv,
+                                 size_t *const budget)
+  FUNC_ATTR_NONNULL_ALL FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  if (*budget == 0) {
+    return 0;
+  }
+  (*budget)--;
+  switch (tv->v_type) {
+    case VAR_STRING: {
+      return MIN(tv_strlen(tv) + 2, JSON_ESTIMATE_MAX);
+    }
+    case VAR_NUMBER: {
+      return 8;
+    }
+    case VAR_FLOAT: {
+      return 20;
+    }
+    case VAR_BOOL:
+    case VAR_SPECIAL: {
+      return 5;
+    }
+    case VAR_LIST: {
+      const list_T *const l = tv->vval.v_list;
+      size_t size = 2;
+      int seen = 0;
+      bool partial = false;
+      TV_LIST_ITER_CONST(l, li, {
+        if (*budget == 0) {
+          break;
+        }
+        const typval_T *const item = TV_LIST_ITEM_TV(li);
+        size = json_size_add(size, json_size_estimate(item, budget) + 2);
+        seen++;
+        if (*budget == 0
+            && (item->v_type == VAR_LIST || item->v_type == VAR_DICT)) {
+          partial = true;  // the item may not have been inspected completely
+        }
+      });
+      const int len = tv_list_len(l);
+      if (!partial && seen > 0 && seen < len) {
+        const size_t item_size = (size - 2) / (size_t)seen;
+        const size_t rest = (size_t)(len - seen);
+        size = (item_size > 0 && rest > JSON_ESTIMATE_MAX / item_size)
+            ? JSON_ESTIMATE_MAX
+            : json_size_add(size, item_size * rest);
+      }
+      return size;
+    }
+    case VAR_DICT: {
+      size_t size = 2;
+      if (tv->vval.v_dict == NULL) {
+        return size;
+      }
+      TV_DICT_ITER(tv->vval.v_dict, di, {
+        if (*budget == 0) {
+          break;
+        }
+        size = json_size_add(size, STRLEN(di->di_key) + 4
+                             + json_size_estimate(&di->di_tv, budget));
+      });
+      return size;
+    }
+    default: {
+      return 0;
+    }
+  }
+}
+
 /// Return a string with the string representation of a variable.
 /// Puts quotes around strings, so that they can be parsed back by eval().
 ///
@@ -858,6 +1001,11 @@ char *encode_tv2json(typval_T *tv, size_t *len)
 {
   garray_T ga;
   ga_init(&ga, (int)sizeof(char), 80);
+  size_t budget = JSON_ESTIMATE_BUDGET;
+  const size_t estimate = json_size_estimate(tv, &budget);
+  if (estimate > 80) {
+    ga_grow(&ga, (int)estimate);
+  }
   const int evj_ret = encode_vim_to_json(&ga, tv,
                                          N_("encode_tv2json() argument"));
   if (!evj_ret) {
@@ -50,6 +50,7 @@
 #include "nvim/popupmnu.h"
 #include "nvim/quickfix.h"
 #include "nvim/regexp.h"
+#include "nvim/runtime.h"
 #include "nvim/screen.h"
 #include "nvim/search.h"
 #include "nvim/sha256.h"
@@ -1552,7 +1553,9 @@ static void f_delete(typval_T *argvars, typval_T *rettv, FunPtr fptr)
     rettv->vval.v_number = delete_recursive(name);
   } else {
     emsgf(_(e_invexpr2), flags);
+    return;
   }
+  runtime_index_invalidate(name);
 }
 
 // dictwatcheradd(dict, key, funcref) function
@@ -6268,11 +6271,13 @@ static void f_mkdir(typval_T *argvars, typval_T *rettv, FunPtr fptr)
         return;
       } else {
         rettv->vval.v_number = OK;
+        runtime_index_invalidate(dir);
         return;
       }
     }
   }
   rettv->vval.v_number = vim_mkdir_emsg(dir, prot);
+  runtime_index_invalidate(dir);
 }
 
 /// "mode()" function
@@ -7151,9 +7156,12 @@ static void f_rename(typval_T *argvars, typval_T *rettv, FunPtr fptr)
     rettv->vval.v_number = -1;
   } else {
     char buf[NUMBUFLEN];
-    rettv->vval.v_number = vim_rename(
-        (const char_u *)tv_get_string(&argvars[0]),
-        (const char_u *)tv_get_string_buf(&argvars[1], buf));
+    const char *const from = tv_get_string(&argvars[0]);
+    const char *const to = tv_get_string_buf(&argvars[1], buf);
+    rettv->vval.v_number = vim_rename((const char_u *)from,
+                                      (const char_u *)to);
+    runtime_index_invalidate(from);
+    runtime_index_invalidate(to);
   }
 }
 
@@ -11635,6 +11643,7 @@ static void f_writefile(typval_T *argvars, typval_T *rettv, FunPtr fptr)
       emsgf(_("E80: Error when closing file %s: %s"),
             fname, os_strerror(error));
     }
+    runtime_index_invalidate(fname);
   }
 }
 /*
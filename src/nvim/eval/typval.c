@@ -1556,6 +1556,26 @@ dictitem_T *tv_dict_find(const dict_T *const d, const char *const key,
   return TV_DICT_HI2DI(hi);
 }
 
+/// Find item in dictionary using a key returned by hash_intern()
+///
+/// @param[in]  d  Dictionary to check.
+/// @param[in]  ikey  Interned key.
+///
+/// @return found item or NULL if nothing was found.
+dictitem_T *tv_dict_find_interned(const dict_T *const d,
+                                  const char_u *const ikey)
+  FUNC_ATTR_NONNULL_ARG(2) FUNC_ATTR_PURE FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  if (d == NULL) {
+    return NULL;
+  }
+  hashitem_T *const hi = hash_find_interned(&d->dv_hashtab, ikey);
+  if (HASHITEM_EMPTY(hi)) {
+    return NULL;
+  }
+  return TV_DICT_HI2DI(hi);
+}
+
 /// Get a typval item from a dictionary and copy it into "rettv".
 ///
 /// @param[in]  d  Dictionary to check.
@@ -1735,6 +1755,26 @@ int tv_dict_add(dict_T *const d, dictitem_T *const item)
   return hash_add(&d->dv_hashtab, item->di_key);
 }
 
+/// Add item to dictionary, reusing the hash of an interned key
+///
+/// @param[out]  d  Dictionary to add to.
+/// @param[in]  item  Item to add, its key must be equal to ikey.
+/// @param[in]  ikey  Key returned by hash_intern().
+///
+/// @return FAIL if key already exists.
+int tv_dict_add_interned(dict_T *const d, dictitem_T *const item,
+                         const char_u *const ikey)
+  FUNC_ATTR_NONNULL_ALL
+{
+  hashitem_T *const hi = hash_find_interned(&d->dv_hashtab, ikey);
+  if (!HASHITEM_EMPTY(hi)) {
+    internal_error("tv_dict_add_interned()");
+    return FAIL;
+  }
+  hash_add_item(&d->dv_hashtab, hi, item->di_key, hash_intern_hash(ikey));
+  return OK;
+}
+
 /// Add a list entry to dictionary
 ///
 /// @param[out]  d  Dictionary to add entry to.
@@ -3559,13 +3559,28 @@ static buf_T *do_sub(exarg_T *eap, proftime_T timeout,
   // If preview: limit to max('cmdwinheight', viewport).
   linenr_T line2 = eap->line2;
 
+  // In a big buffer first find the lines without a match on worker threads.
+  // Lines below "lnum" are not changed by substituting, only moved by the
+  // lines inserted or deleted above them.  Not when an expression or a Lua
+  // callback could change them.
+  uint8_t *found = NULL;
+  const linenr_T found_line2 = line2;
+  if (!subflags.do_ask && !preview && !(sub[0] == '\\' && sub[1] == '=')
+      && kv_size(curbuf->update_callbacks) == 0) {
+    found = vim_regexec_par(&regmatch, curbuf, eap->line1, line2);
+  }
+
   for (linenr_T lnum = eap->line1;
        lnum <= line2 && !got_quit && !aborting()
        && (!preview || preview_lines.lines_needed <= (linenr_T)p_cwh
            || lnum <= curwin->w_botline);
        lnum++) {
-    long nmatch = vim_regexec_multi(&regmatch, curwin, curbuf, lnum,
-                                    (colnr_T)0, NULL, NULL);
+    long nmatch = 0;
+    if (found == NULL
+        || found[lnum - (line2 - found_line2) - eap->line1] != kRegParNoMatch) {
+      nmatch = vim_regexec_multi(&regmatch, curwin, curbuf, lnum,
+                                 (colnr_T)0, NULL, NULL);
+    }
     if (nmatch) {
       colnr_T copycol;
       colnr_T matchcol;
@@ -4236,6 +4251,7 @@ skip:
       got_quit = true;
     }
   }
+  xfree(found);
 
   curbuf->deleted_bytes2 = 0;
 
@@ -4490,16 +4506,24 @@ void ex_global(exarg_T *eap)
     }
   } else {
     // pass 1: set marks for each (not) matching line
+    // In a big buffer most lines are matched on worker threads.
+    uint8_t *const found = vim_regexec_par(&regmatch, curbuf, eap->line1,
+                                           eap->line2);
     for (lnum = eap->line1; lnum <= eap->line2 && !got_int; lnum++) {
       // a match on this line?
-      match = vim_regexec_multi(&regmatch, curwin, curbuf, lnum,
-                                (colnr_T)0, NULL, NULL);
+      if (found != NULL && found[lnum - eap->line1] != kRegParUnknown) {
+        match = found[lnum - eap->line1] == kRegParMatch;
+      } else {
+        match = vim_regexec_multi(&regmatch, curwin, curbuf, lnum,
+                                  (colnr_T)0, NULL, NULL);
+      }
       if ((type == 'g' && match) || (type == 'v' && !match)) {
         ml_setmarked(lnum);
         ndone++;
       }
       line_breakcheck();
     }
+    xfree(found);
 
     // pass 2: execute the command for each line that has been marked
     if (got_int) {
@@ -45,6 +45,7 @@
 #include "nvim/regexp.h"
 #include "nvim/screen.h"
 #include "nvim/strings.h"
+#include "nvim/trace.h"
 #include "nvim/undo.h"
 #include "nvim/version.h"
 #include "nvim/window.h"
@@ -54,6 +55,7 @@
 #include "nvim/os/fs_defs.h"
 #include "nvim/api/private/helpers.h"
 #include "nvim/api/private/defs.h"
+#include "nvim/lib/kvec.h"
 #include "nvim/lua/executor.h"
 
 
@@ -93,12 +95,36 @@ typedef struct sn_prl_S {
   proftime_T sn_prl_self;       ///< time spent in a line itself
 } sn_prl_T;
 
+/// File read in advance by source_prefetch().
+typedef struct {
+  uv_work_t work;      ///< Reads the file on a worker thread.
+  char *fname;         ///< Full file name.
+  FileInfo info;       ///< File info taken before reading the file.
+  char *data;          ///< File contents, allocated with malloc().
+  size_t len;          ///< Number of bytes in "data".
+  bool ok;             ///< Whether the whole file was read.
+  bool done;           ///< Whether the worker has finished.
+  uint64_t read_time;  ///< Time the worker took to read the file, in ns.
+} SourcePrefetch;
+
+/// Files larger than this are not read in advance.
+#define SOURCE_PREFETCH_MAX_SIZE (4 * 1024 * 1024)
+
+/// Loop used to wait for source_prefetch() workers.
+static uv_loop_t prefetch_loop;
+static bool prefetch_loop_initialized = false;
+
+/// Files being read in advance, not yet taken by do_source().
+static kvec_t(SourcePrefetch *) prefetched = KV_INITIAL_VALUE;
+
 /// Structure used to store info for each sourced file.
 /// It is shared between do_source() and getsourceline().
 /// This is required, because it needs to be handed to do_cmdline() and
 /// sourcing can be done recursively.
 struct source_cookie {
   FILE *fp;                     ///< opened file for sourcing
+  SourcePrefetch *prefetch;     ///< if not NULL: contents used instead of fp
+  size_t prefetch_off;          ///< offset of the next line in prefetch
   char_u *nextline;             ///< if not NULL: line that was read ahead
   linenr_T sourcing_lnum;       ///< line number of the source file
   int finished;                 ///< ":finish" used
@@ -1344,6 +1370,7 @@ bool check_changed(buf_T *buf, int flags)
 {
   int forceit = (flags & CCGD_FORCEIT);
   bufref_T bufref;
+  buf_write_bg_wait(buf, false);  // 'modified' is reset when the write is done
   set_bufref(&bufref, buf);
 
   if (!forceit
@@ -1507,6 +1534,9 @@ bool check_changed_any(bool hidden, bool unload)
   size_t bufcount = 0;
   int         *bufnrs;
 
+  // 'modified' is reset when writing in the background is done.
+  buf_write_bg_wait(NULL, false);
+
   // Make a list of all buffers, with the most important ones first.
   FOR_ALL_BUFFERS(buf) {
     bufcount++;
@@ -2712,6 +2742,145 @@ static FILE *fopen_noinh_readbin(char *filename)
   return fdopen(fd_tmp, READBIN);
 }
 
+static void source_prefetch_work(uv_work_t *req)
+{
+  SourcePrefetch *const sp = req->data;
+  const uint64_t start = uv_hrtime();
+  const TraceSpan span = trace_begin();
+  // Runs on a worker thread: only use thread-safe functions here.
+  FILE *const fp = fopen(sp->fname, READBIN);
+  if (fp == NULL) {
+    return;
+  }
+  // Ask for one byte more than expected to find out if the file has grown.
+  const size_t size = (size_t)os_fileinfo_size(&sp->info);
+  sp->data = malloc(size + 1);
+  if (sp->data != NULL) {
+    sp->len = fread(sp->data, 1, size + 1, fp);
+    sp->ok = sp->len == size && !ferror(fp);
+  }
+  fclose(fp);
+  sp->read_time = uv_hrtime() - start;
+  trace_end(span, "io", "prefetch", sp->fname);
+}
+
+static void source_prefetch_after_work(uv_work_t *req, int status)
+{
+  ((SourcePrefetch *)req->data)->done = true;
+}
+
+/// Wait for the worker of "sp" and free it.
+static void source_prefetch_free(SourcePrefetch *sp)
+{
+  if (sp == NULL) {
+    return;
+  }
+  while (!sp->done) {
+    uv_run(&prefetch_loop, UV_RUN_ONCE);
+  }
+  free(sp->data);
+  xfree(sp->fname);
+  xfree(sp);
+}
+
+/// Start reading files in the background
+///
+/// Files are read on the libuv thread pool, do_source() then takes their
+/// contents from memory instead of reading them.  Used at startup, when
+/// many plugin files are sourced one after another.  Call
+/// source_prefetch_clear() when done sourcing.
+///
+/// @param  files  File names, as given to do_source().
+/// @param  count  Number of files.
+void source_prefetch(char_u **files, int count)
+{
+  if (count <= 0) {
+    return;
+  }
+  if (!prefetch_loop_initialized) {
+    if (uv_loop_init(&prefetch_loop) != 0) {
+      return;
+    }
+    prefetch_loop_initialized = true;
+  }
+  for (int i = 0; i < count; i++) {
+    char *const fname = fix_fname((char *)files[i]);
+    bool found = false;
+    for (size_t j = 0; j < kv_size(prefetched); j++) {
+      if (strcmp(kv_A(prefetched, j)->fname, fname) == 0) {
+        found = true;
+        break;
+      }
+    }
+    SourcePrefetch *const sp = xcalloc(1, sizeof(*sp));
+    sp->fname = fname;
+    if (found || !os_fileinfo(fname, &sp->info)
+        || os_fileinfo_size(&sp->info) > SOURCE_PREFETCH_MAX_SIZE) {
+      xfree(fname);
+      xfree(sp);
+      continue;
+    }
+    sp->work.data = sp;
+    if (uv_queue_work(&prefetch_loop, &sp->work, source_prefetch_work,
+                      source_prefetch_after_work) != 0) {
+      xfree(fname);
+      xfree(sp);
+      continue;
+    }
+    kv_push(prefetched, sp);
+  }
+}
+
+/// Take contents of a file read by source_prefetch()
+///
+/// Waits for the file to be read.
+///
+/// @param[in]  fname  Full file name.
+///
+/// @return NULL if the file was not prefetched, could not be read or has
+///         changed since.
+static SourcePrefetch *source_prefetch_take(const char *fname)
+{
+  SourcePrefetch *sp = NULL;
+  for (size_t i = 0; i < kv_size(prefetched); i++) {
+    if (strcmp(kv_A(prefetched, i)->fname, fname) == 0) {
+      sp = kv_A(prefetched, i);
+      kv_A(prefetched, i) = kv_pop(prefetched);
+      break;
+    }
+  }
+  if (sp == NULL) {
+    return NULL;
+  }
+  while (!sp->done) {
+    uv_run(&prefetch_loop, UV_RUN_ONCE);
+  }
+  // An earlier script (or a SourcePre autocommand) may have changed it.
+  FileInfo info;
+  if (!sp->ok || !os_fileinfo(fname, &info)
+      || info.stat.st_size != sp->info.stat.st_size
+      || info.stat.st_mtim.tv_sec != sp->info.stat.st_mtim.tv_sec
+      || info.stat.st_mtim.tv_nsec != sp->info.stat.st_mtim.tv_nsec) {
+    source_prefetch_free(sp);
+    return NULL;
+  }
+  return sp;
+}
+
+/// Free files read by source_prefetch() which were not sourced
+void source_prefetch_clear(void)
+{
+  while (kv_size(prefetched)) {
+    source_prefetch_free(kv_pop(prefetched));
+  }
+  kv_destroy(prefetched);
+  kv_init(prefetched);
+  if (prefetch_loop_initialized) {
+    uv_loop_close(&prefetch_loop);
+    prefetch_loop_initialized = false;
+  }
+}
+
 typedef struct {
   char_u *buf;
   size_t offset;
@@ -2809,6 +2978,7 @@ int do_source(char_u *fname, int check_other, int is_vimrc)
   scriptitem_T            *si = NULL;
   proftime_T wait_start;
   bool trigger_source_post = false;
+  uint64_t parse_time = 0;
 
   p = expand_env_save(fname);
   if (p == NULL) {
@@ -2839,8 +3009,16 @@ int do_source(char_u *fname, int check_other, int is_vimrc)
   // Apply SourcePre autocommands, they may get the file.
   apply_autocmds(EVENT_SOURCEPRE, fname_exp, fname_exp, false, curbuf);
 
-  cookie.fp = fopen_noinh_readbin((char *)fname_exp);
-  if (cookie.fp == NULL && check_other) {
+  // Use contents read in advance if possible, see source_prefetch().
+  const uint64_t wait_start_ns = os_hrtime();
+  cookie.prefetch = source_prefetch_take((char *)fname_exp);
+  const uint64_t wait_time = os_hrtime() - wait_start_ns;
+  cookie.prefetch_off = 0;
+  cookie.fp = NULL;
+  if (cookie.prefetch == NULL) {
+    cookie.fp = fopen_noinh_readbin((char *)fname_exp);
+  }
+  if (cookie.fp == NULL && cookie.prefetch == NULL && check_other) {
     // Try again, replacing file name ".vimrc" by "_vimrc" or vice versa,
     // and ".exrc" by "_exrc" or vice versa.
     p = path_tail(fname_exp);
@@ -2851,7 +3029,7 @@ int do_source(char_u *fname, int check_other, int is_vimrc)
     }
   }
 
-  if (cookie.fp == NULL) {
+  if (cookie.fp == NULL && cookie.prefetch == NULL) {
     if (p_verbose > 0) {
       verbose_enter();
       if (sourcing_name == NULL) {
@@ -2917,6 +3095,7 @@ int do_source(char_u *fname, int check_other, int is_vimrc)
   if (l_time_fd != NULL) {
     time_push(&rel_time, &start_time);
   }
+  const TraceSpan trace_span = trace_begin();
 
   const int l_do_profiling = do_profiling;
   if (l_do_profiling == PROF_YES) {
@@ -3011,7 +3190,12 @@ int do_source(char_u *fname, int check_other, int is_vimrc)
     current_sctx.sc_lnum = 0;
     sourcing_lnum = 0;
     // Source the file as lua
-    nlua_exec_file((const char *)fname);
+    if (cookie.prefetch != NULL) {
+      nlua_exec_file_contents((const char *)fname, cookie.prefetch->data,
+                              cookie.prefetch->len, &parse_time);
+    } else {
+      nlua_exec_file((const char *)fname);
+    }
     current_sctx = current_sctx_backup;
     sourcing_lnum = sourcing_lnum_backup;
   } else {
@@ -3050,8 +3234,20 @@ int do_source(char_u *fname, int check_other, int is_vimrc)
   if (l_time_fd != NULL) {
     vim_snprintf((char *)IObuff, IOSIZE, "sourcing %s", fname);
     time_msg((char *)IObuff, &start_time);
+    if (cookie.prefetch != NULL) {
+      int len = vim_snprintf((char *)IObuff, IOSIZE,
+                             "read in background %.3f, waited %.3f",
+                             (double)cookie.prefetch->read_time / 1e6,
+                             (double)wait_time / 1e6);
+      if (parse_time > 0) {
+        vim_snprintf((char *)IObuff + len, IOSIZE - (size_t)len,
+                     ", parsed %.3f", (double)parse_time / 1e6);
+      }
+      time_msg_detail((char *)IObuff);
+    }
     time_pop(rel_time);
   }
+  trace_end(trace_span, "vim", "source", (const char *)fname_exp);
 
   if (!got_int) {
     trigger_source_post = true;
@@ -3069,7 +3265,10 @@ int do_source(char_u *fname, int check_other, int is_vimrc)
   if (l_do_profiling == PROF_YES) {
     prof_child_exit(&wait_start);    // leaving a child now
   }
-  fclose(cookie.fp);
+  if (cookie.fp != NULL) {
+    fclose(cookie.fp);
+  }
+  source_prefetch_free(cookie.prefetch);
   xfree(cookie.nextline);
   xfree(firstline);
   convert_setup(&cookie.conv, NULL, NULL);
@@ -3276,6 +3475,28 @@ char_u *getsourceline(int c, void *cookie, int indent, bool do_concat)
   return line;
 }
 
+/// Like fgets(), reads from the sourced file or from its prefetched contents.
+static char *source_fgets(char *s, int size, struct source_cookie *sp)
+{
+  if (sp->fp != NULL) {
+    return fgets(s, size, sp->fp);
+  }
+  const SourcePrefetch *const pf = sp->prefetch;
+  if (size <= 1 || sp->prefetch_off >= pf->len) {
+    return NULL;
+  }
+  const char *const start = pf->data + sp->prefetch_off;
+  size_t n = MIN(pf->len - sp->prefetch_off, (size_t)size - 1);
+  const char *const nl = memchr(start, '\n', n);
+  if (nl != NULL) {
+    n = (size_t)(nl - start) + 1;
+  }
+  memcpy(s, start, n);
+  s[n] = NUL;
+  sp->prefetch_off += n;
+  return s;
+}
+
 static char_u *get_one_sourceline(struct source_cookie *sp)
 {
   garray_T ga;
@@ -3299,8 +3520,8 @@ static char_u *get_one_sourceline(struct source_cookie *sp)
 
 retry:
     errno = 0;
-    if (fgets((char *)buf + ga.ga_len, ga.ga_maxlen - ga.ga_len,
-              sp->fp) == NULL) {
+    if (source_fgets((char *)buf + ga.ga_len, ga.ga_maxlen - ga.ga_len,
+                     sp) == NULL) {
       if (errno == EINTR) {
         goto retry;
       }
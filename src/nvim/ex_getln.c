@@ -55,6 +55,7 @@
 #include "nvim/regexp.h"
 #include "nvim/screen.h"
 #include "nvim/search.h"
+#include "nvim/shada.h"
 #include "nvim/sign.h"
 #include "nvim/strings.h"
 #include "nvim/state.h"
@@ -662,6 +663,7 @@ static void finish_incsearch_highlighting(int gotesc, incsearch_state_T *s,
 /// getcmdline or getcmdline_prompt, instead of calling this directly.
 static uint8_t *command_line_enter(int firstc, long count, int indent)
 {
+  shada_load_history();
   // can be invoked recursively, identify each level
   static int cmdline_level = 0;
   cmdline_level++;
@@ -6011,6 +6013,8 @@ add_to_history (
 {
   histentry_T *hisptr;
 
+  shada_load_history();
+
   if (hislen == 0 || histype == HIST_INVALID) {  // no history
     return;
   }
@@ -6061,6 +6065,7 @@ add_to_history (
  */
 int get_history_idx(int histype)
 {
+  shada_load_history();
   if (hislen == 0 || histype < 0 || histype >= HIST_COUNT
       || hisidx[histype] < 0)
     return -1;
@@ -6199,6 +6204,7 @@ static int calc_hist_idx(int histype, int num)
  */
 char_u *get_history_entry(int histype, int idx)
 {
+  shada_load_history();
   idx = calc_hist_idx(histype, idx);
   if (idx >= 0)
     return history[histype][idx].hisstr;
@@ -6214,6 +6220,7 @@ char_u *get_history_entry(int histype, int idx)
 ///         values, FAIL otherwise.
 int clr_history(const int histype)
 {
+  shada_load_history();
   if (hislen != 0 && histype >= 0 && histype < HIST_COUNT) {
     histentry_T *hisptr = history[histype];
     for (int i = hislen; i--; hisptr++) {
@@ -6239,6 +6246,8 @@ int del_history_entry(int histype, char_u *str)
   int last;
   bool found = false;
 
+  shada_load_history();
+
   regmatch.regprog = NULL;
   regmatch.rm_ic = FALSE;       /* always match case */
   if (hislen != 0
@@ -6282,6 +6291,8 @@ int del_history_idx(int histype, int idx)
 {
   int i, j;
 
+  shada_load_history();
+
   i = calc_hist_idx(histype, idx);
   if (i < 0)
     return FALSE;
@@ -6359,6 +6370,8 @@ void ex_history(exarg_T *eap)
   char_u      *end;
   char_u      *arg = eap->arg;
 
+  shada_load_history();
+
   if (hislen == 0) {
     MSG(_("'history' option is zero"));
     return;
@@ -6474,6 +6487,8 @@ static int open_cmdwin(void)
   int save_exmode = exmode_active;
   int save_cmdmsg_rl = cmdmsg_rl;
 
+  shada_load_history();
+
   /* Can't do this recursively.  Can't do it when typing a password. */
   if (cmdwin_type != 0
       || cmdline_star > 0
@@ -6768,6 +6783,7 @@ const void *hist_iter(const void *const iter, const uint8_t history_type,
                       const bool zero, histentry_T *const hist)
   FUNC_ATTR_WARN_UNUSED_RESULT FUNC_ATTR_NONNULL_ARG(4)
 {
+  shada_load_history();
   *hist = (histentry_T) {
     .hisstr = NULL
   };
@@ -6821,6 +6837,7 @@ histentry_T *hist_get_array(const uint8_t history_type, int **const new_hisidx,
                             int **const new_hisnum)
   FUNC_ATTR_WARN_UNUSED_RESULT FUNC_ATTR_NONNULL_ALL
 {
+  shada_load_history();
   init_history();
   *new_hisidx = &(hisidx[history_type]);
   *new_hisnum = &(hisnum[history_type]);
@@ -30,6 +30,7 @@
 #include "nvim/getchar.h"
 #include "nvim/hashtab.h"
 #include "nvim/iconv.h"
+#include "nvim/lib/kvec.h"
 #include "nvim/mbyte.h"
 #include "nvim/memfile.h"
 #include "nvim/memline.h"
@@ -37,6 +38,7 @@
 #include "nvim/message.h"
 #include "nvim/misc1.h"
 #include "nvim/garray.h"
+#include "nvim/main.h"
 #include "nvim/move.h"
 #include "nvim/normal.h"
 #include "nvim/option.h"
@@ -44,11 +46,13 @@
 #include "nvim/path.h"
 #include "nvim/quickfix.h"
 #include "nvim/regexp.h"
+#include "nvim/runtime.h"
 #include "nvim/screen.h"
 #include "nvim/search.h"
 #include "nvim/sha256.h"
 #include "nvim/state.h"
 #include "nvim/strings.h"
+#include "nvim/trace.h"
 #include "nvim/ui.h"
 #include "nvim/ui_compositor.h"
 #include "nvim/types.h"
@@ -110,6 +114,37 @@ struct bw_info {
 # endif
 };
 
+/// Size of the pieces of text written by a ":write" in the background.
+#define BWB_CHUNK_SIZE (1024 * 1024)
+
+/// ":write" done in the background, see buf_write_bg_start().
+typedef struct buf_write_job {
+  uv_work_t work;               ///< Writes the file on a worker thread.
+  struct buf_write_job *next;   ///< Next job in "bwb_jobs".
+  bufref_T bufref;              ///< Buffer being written.
+  char *fname;                  ///< Full name of the file.
+  char *sfname;                 ///< Name of the file for messages.
+  char *tmpname;                ///< File written and renamed to "fname".
+  int fd;                       ///< File descriptor of "tmpname".
+  kvec_t(char *) chunks;        ///< Text, BWB_CHUNK_SIZE bytes per chunk.
+  size_t len;                   ///< Number of bytes in the last chunk.
+  bool fsync;                   ///< Sync the file before renaming it.
+  int error;                    ///< libuv error code of the worker, or 0.
+  bool done;                    ///< Whether the worker has finished.
+  bool completed;               ///< Done but BufWritePost not executed yet.
+  varnumber_T changedtick;      ///< b:changedtick of the text written.
+  linenr_T nlines;              ///< Number of lines written.
+  long nchars;                  ///< Number of bytes written.
+  bool newfile;                 ///< The file did not exist.
+  bool no_eol;                  ///< No end-of-line written for the last line.
+  int fileformat;               ///< EOL_UNIX, EOL_DOS or EOL_MAC.
+  bool write_undo_file;         ///< Write the undo file when done.
+  char_u hash[UNDO_HASH_SIZE];  ///< Hash of the text, for the undo file.
+} BufWriteJob;
+
+/// Jobs started by buf_write_bg_start() which were not finished yet.
+static BufWriteJob *bwb_jobs = NULL;
+
 #ifdef INCLUDE_GENERATED_DECLARATIONS
 # include "fileio.c.generated.h"
 #endif
@@ -2206,6 +2241,18 @@ buf_write(
 
   if (fname == NULL || *fname == NUL)   /* safety check */
     return FAIL;
+
+  // Finish writing this buffer in the background first, the files are
+  // written in the order of the commands.  Autocommands may delete the
+  // buffer.
+  if (bwb_jobs != NULL) {
+    bufref_T bufref;
+    set_bufref(&bufref, buf);
+    buf_write_bg_wait(buf, true);
+    if (!bufref_valid(&bufref)) {
+      return FAIL;
+    }
+  }
   if (buf->b_ml.ml_mfp == NULL) {
     /* This can happen during startup when there is a stray "w" in the
      * vimrc file. */
@@ -2553,6 +2600,26 @@ buf_write(
     acl = mch_get_acl(fname);
 #endif
 
+  // Write the file in the background when possible, see 'writebackground'.
+  if (p_wbg && eap != NULL
+      && (eap->cmdidx == CMD_write || eap->cmdidx == CMD_update)
+      && eap->force_enc == 0 && reset_changed && whole && overwriting
+      && !append && !filtering && !exiting && !device && !file_readonly
+      && !p_bk && *p_pm == NUL && !(bkc & BKC_YES)
+      && !need_conversion(buf->b_p_fenc)
+#ifdef HAVE_ACL
+      && acl == NULL
+#endif
+      && buf_write_bg_start(buf, ffname, fname, &file_info_old, newfile,
+                            perm, eap)) {
+    --no_wait_return;
+    msg_scroll = msg_save;
+    if (buffer != smallbuf) {
+      xfree(buffer);
+    }
+    return OK;
+  }
+
   /*
    * If 'backupskip' is not empty, don't make a backup for some files.
    */
@@ -3175,74 +3242,84 @@ restore_backup:
     fileformat = get_fileformat_force(buf, eap);
     s = buffer;
     len = 0;
-    for (lnum = start; lnum <= end; lnum++) {
-      // The next while loop is done once for each character written.
-      // Keep it fast!
-      ptr = ml_get_buf(buf, lnum, false) - 1;
-      if (write_undo_file) {
-        sha256_update(&sha_ctx, ptr + 1, (uint32_t)(STRLEN(ptr + 1) + 1));
-      }
-      while ((c = *++ptr) != NUL) {
-        if (c == NL) {
-          *s = NUL;                       // replace newlines with NULs
-        } else if (c == CAR && fileformat == EOL_MAC) {
-          *s = NL;                        // Mac: replace CRs with NLs
-        } else {
-          *s = c;
+    lnum = start;
+    while (lnum <= end) {
+      // Keep it fast!  Get all the lines of a data block at once, copy the
+      // text with memcpy() and translate it in place, memchr() finds the
+      // few characters to translate.
+      char_u *lines[ML_GET_BLOCK_MAX];
+      size_t lens[ML_GET_BLOCK_MAX];
+      const int count = ml_get_block(buf, lnum, end, ML_GET_BLOCK_MAX,
+                                     lines, lens);
+      for (int i = 0; i < count; i++, lnum++) {
+        ptr = lines[i];
+        if (write_undo_file) {
+          sha256_update(&sha_ctx, ptr, (uint32_t)(lens[i] + 1));
         }
-        s++;
-        if (++len != bufsize) {
-          continue;
+        for (size_t todo = lens[i]; todo > 0;) {
+          const size_t n = MIN(todo, (size_t)(bufsize - len));
+          memcpy(s, ptr, n);
+          memchrsub(s, NL, NUL, n);         // replace newlines with NULs
+          if (fileformat == EOL_MAC) {
+            memchrsub(s, CAR, NL, n);       // Mac: replace CRs with NLs
+          }
+          s += n;
+          ptr += n;
+          todo -= n;
+          len += (int)n;
+          if (len != bufsize) {
+            continue;
+          }
+          if (buf_write_bytes(&write_info) == FAIL) {
+            end = 0;                        // write error: break loop
+            break;
+          }
+          nchars += bufsize;
+          s = buffer;
+          len = 0;
+          write_info.bw_start_lnum = lnum;
         }
-        if (buf_write_bytes(&write_info) == FAIL) {
-          end = 0;                        // write error: break loop
+        // write failed or last line has no EOL: stop here
+        if (end == 0
+            || (lnum == end
+                && (write_bin || !buf->b_p_fixeol)
+                && (lnum == buf->b_no_eol_lnum
+                    || (lnum == buf->b_ml.ml_line_count && !buf->b_p_eol)))) {
+          lnum++;                           // written the line, count it
+          no_eol = true;
           break;
         }
-        nchars += bufsize;
-        s = buffer;
-        len = 0;
-        write_info.bw_start_lnum = lnum;
-      }
-      // write failed or last line has no EOL: stop here
-      if (end == 0
-          || (lnum == end
-              && (write_bin || !buf->b_p_fixeol)
-              && (lnum == buf->b_no_eol_lnum
-                  || (lnum == buf->b_ml.ml_line_count && !buf->b_p_eol)))) {
-        lnum++;                           // written the line, count it
-        no_eol = true;
-        break;
-      }
-      if (fileformat == EOL_UNIX) {
-        *s++ = NL;
-      } else {
-        *s++ = CAR;                       // EOL_MAC or EOL_DOS: write CR
-        if (fileformat == EOL_DOS) {      // write CR-NL
-          if (++len == bufsize) {
-            if (buf_write_bytes(&write_info) == FAIL) {
-              end = 0;                    // write error: break loop
-              break;
+        if (fileformat == EOL_UNIX) {
+          *s++ = NL;
+        } else {
+          *s++ = CAR;                       // EOL_MAC or EOL_DOS: write CR
+          if (fileformat == EOL_DOS) {      // write CR-NL
+            if (++len == bufsize) {
+              if (buf_write_bytes(&write_info) == FAIL) {
+                end = 0;                    // write error: break loop
+                break;
+              }
+              nchars += bufsize;
+              s = buffer;
+              len = 0;
             }
-            nchars += bufsize;
-            s = buffer;
-            len = 0;
+            *s++ = NL;
           }
-          *s++ = NL;
-        }
-      }
-      if (++len == bufsize) {
-        if (buf_write_bytes(&write_info) == FAIL) {
-          end = 0;  // Write error: break loop.
-          break;
         }
-        nchars += bufsize;
-        s = buffer;
-        len = 0;
+        if (++len == bufsize) {
+          if (buf_write_bytes(&write_info) == FAIL) {
+            end = 0;  // Write error: break loop.
+            break;
+          }
+          nchars += bufsize;
+          s = buffer;
+          len = 0;
 
-        os_breakcheck();
-        if (got_int) {
-          end = 0;  // Interrupted, break loop.
-          break;
+          os_breakcheck();
+          if (got_int) {
+            end = 0;  // Interrupted, break loop.
+            break;
+          }
         }
       }
     }
@@ -3523,6 +3600,8 @@ restore_backup:
     EMSG(_("E207: Can't delete backup file"));
   }
 
+  runtime_index_invalidate((char *)fname);
+
   goto nofail;
 
   /*
@@ -3641,6 +3720,377 @@ nofail:
 #undef SET_ERRMSG_NUM
 }
 
+/// Start writing all lines of "buf" to "ffname" in the background, for
+/// ":write" with 'writebackground'.
+///
+/// The text is copied into large chunks here, because the memline can only
+/// be used on the main thread.  A worker writes it to a new file in the same
+/// directory, syncs it and renames it over "ffname".  The buffer can't be
+/// changed until buf_write_bg_complete() is called.
+///
+/// @param  fname  Name of the file for messages.
+/// @param  file_info_old  Information of the existing file, unused when
+///                        "newfile" is true.
+///
+/// @return  false when the file must be written the usual way.
+static bool buf_write_bg_start(buf_T *buf, char_u *ffname, char_u *fname,
+                               const FileInfo *file_info_old, bool newfile,
+                               long perm, exarg_T *eap)
+  FUNC_ATTR_NONNULL_ARG(1, 2, 3, 4, 7)
+{
+  // Renaming the new file would break a link.
+  if (!newfile) {
+    FileInfo file_info;
+    if (os_fileinfo_hardlinks(file_info_old) > 1
+        || !os_fileinfo_link((char *)ffname, &file_info)
+        || !os_fileinfo_id_equal(&file_info, file_info_old)) {
+      return false;
+    }
+  }
+
+  // Create the new file next to the original one, so that it can be renamed.
+  const size_t len = STRLEN(ffname) + 32;
+  char *const tmpname = xmalloc(len);
+  const size_t dirlen = (size_t)(path_tail(ffname) - ffname);
+  int fd = -1;
+  for (int i = 4913; i < 4913 + 100 * 123; i += 123) {
+    memcpy(tmpname, ffname, dirlen);
+    snprintf(tmpname + dirlen, len - dirlen, ".%s.%d~", path_tail(ffname), i);
+    fd = os_open(tmpname, O_CREAT | O_WRONLY | O_EXCL | O_NOFOLLOW,
+                 perm < 0 ? 0666 : (int)(perm & 0777));
+    if (fd != UV_EEXIST) {
+      break;
+    }
+  }
+  if (fd < 0) {
+    xfree(tmpname);
+    return false;
+  }
+  if (!newfile) {
+    // Give the new file the owner, group and permissions of the original
+    // file, write the usual way when that is not possible.
+    FileInfo file_info;
+#ifdef UNIX
+    os_fchown(fd, file_info_old->stat.st_uid, file_info_old->stat.st_gid);
+#endif
+    (void)os_setperm(tmpname, (int)perm);
+    if (!os_fileinfo_fd(fd, &file_info)
+#ifdef UNIX
+        || file_info.stat.st_uid != file_info_old->stat.st_uid
+        || file_info.stat.st_gid != file_info_old->stat.st_gid
+#endif
+        || (long)file_info.stat.st_mode != perm) {
+      os_close(fd);
+      os_remove(tmpname);
+      xfree(tmpname);
+      return false;
+    }
+  }
+
+  BufWriteJob *const job = xcalloc(1, sizeof(*job));
+  set_bufref(&job->bufref, buf);
+  job->fname = xstrdup((char *)ffname);
+  job->sfname = xstrdup((char *)fname);
+  job->tmpname = tmpname;
+  job->fd = fd;
+  job->fsync = p_fs;
+  job->newfile = newfile;
+  job->fileformat = get_fileformat_force(buf, eap);
+  job->write_undo_file = buf->b_p_udf;
+  kv_init(job->chunks);
+
+  const bool write_bin = eap->force_bin != 0 ? eap->force_bin == FORCE_BIN
+                                             : buf->b_p_bin;
+  char_u bom[5];
+  const int bomlen = buf->b_p_bomb && !write_bin
+                     ? make_bom(bom, buf->b_p_fenc) : 0;
+  buf_write_bg_append(job, (char *)bom, (size_t)bomlen, false);
+
+  context_sha256_T sha_ctx;
+  if (job->write_undo_file) {
+    sha256_start(&sha_ctx);
+  }
+  const char *const eol = job->fileformat == EOL_UNIX ? "\n"
+                          : job->fileformat == EOL_MAC ? "\r" : "\r\n";
+  const linenr_T end = (buf->b_ml.ml_flags & ML_EMPTY)
+                       ? 0 : buf->b_ml.ml_line_count;
+  linenr_T lnum = 1;
+  while (lnum <= end) {
+    char_u *lines[ML_GET_BLOCK_MAX];
+    size_t lens[ML_GET_BLOCK_MAX];
+    const int count = ml_get_block(buf, lnum, end, ML_GET_BLOCK_MAX,
+                                   lines, lens);
+    for (int i = 0; i < count; i++, lnum++) {
+      if (job->write_undo_file) {
+        sha256_update(&sha_ctx, lines[i], (uint32_t)(lens[i] + 1));
+      }
+      buf_write_bg_append(job, (char *)lines[i], lens[i], true);
+      // last line has no EOL: stop here
+      if (lnum == end
+          && (write_bin || !buf->b_p_fixeol)
+          && (lnum == buf->b_no_eol_lnum || !buf->b_p_eol)) {
+        job->no_eol = true;
+      } else {
+        buf_write_bg_append(job, eol, strlen(eol), false);
+      }
+    }
+  }
+  if (job->write_undo_file) {
+    sha256_finish(&sha_ctx, job->hash);
+  }
+  job->nlines = end;
+  job->changedtick = buf_get_changedtick(buf);
+
+  job->work.data = job;
+  if (uv_queue_work(&main_loop.uv, &job->work, buf_write_bg_work,
+                    buf_write_bg_after_work) != 0) {
+    os_close(fd);
+    os_remove(tmpname);
+    buf_write_bg_free(job);
+    return false;
+  }
+  job->next = bwb_jobs;
+  bwb_jobs = job;
+  buf->b_write_bg = true;
+  // Don't warn for the file being replaced while writing it.
+  buf->b_saving = true;
+  return true;
+}
+
+/// Append "len" bytes at "p" to the text written by "job".
+///
+/// @param  text  "p" is text of a line: NLs are written as NULs and, for
+///               'fileformat' "mac", CRs as NLs.
+static void buf_write_bg_append(BufWriteJob *job, const char *p, size_t len,
+                                bool text)
+{
+  while (len > 0) {
+    if (kv_size(job->chunks) == 0 || job->len == BWB_CHUNK_SIZE) {
+      kv_push(job->chunks, xmalloc(BWB_CHUNK_SIZE));
+      job->len = 0;
+    }
+    const size_t n = MIN(len, BWB_CHUNK_SIZE - job->len);
+    char *const dst = kv_last(job->chunks) + job->len;
+    memcpy(dst, p, n);
+    if (text) {
+      memchrsub(dst, NL, NUL, n);
+      if (job->fileformat == EOL_MAC) {
+        memchrsub(dst, CAR, NL, n);
+      }
+    }
+    job->len += n;
+    job->nchars += (long)n;
+    p += n;
+    len -= n;
+  }
+}
+
+static void buf_write_bg_work(uv_work_t *req)
+{
+  BufWriteJob *const job = req->data;
+  const TraceSpan span = trace_begin();
+  // Runs on a worker thread: only use thread-safe functions here.
+  uv_loop_t loop;
+  if (uv_loop_init(&loop) != 0) {
+    abort();
+  }
+  uv_fs_t fs;
+  int r = 0;
+  for (size_t i = 0; r >= 0 && i < kv_size(job->chunks); i++) {
+    const size_t size = i + 1 == kv_size(job->chunks) ? job->len
+                                                      : BWB_CHUNK_SIZE;
+    size_t written = 0;
+    while (written < size) {
+      uv_buf_t buf = uv_buf_init(kv_A(job->chunks, i) + written,
+                                 (unsigned)(size - written));
+      r = uv_fs_write(&loop, &fs, job->fd, &buf, 1, -1, NULL);
+      uv_fs_req_cleanup(&fs);
+      if (r == UV_EINTR || r == UV_EAGAIN) {
+        continue;
+      }
+      if (r <= 0) {
+        r = r == 0 ? UV_EIO : r;
+        break;
+      }
+      written += (size_t)r;
+    }
+  }
+  if (r >= 0 && job->fsync) {
+    r = uv_fs_fsync(&loop, &fs, job->fd, NULL);
+    uv_fs_req_cleanup(&fs);
+    if (r == UV_ENOTSUP) {  // fsync not supported on this storage.
+      r = 0;
+    }
+  }
+  const int rc = uv_fs_close(&loop, &fs, job->fd, NULL);
+  uv_fs_req_cleanup(&fs);
+  if (r >= 0) {
+    r = rc;
+  }
+  if (r >= 0) {
+    r = uv_fs_rename(&loop, &fs, job->tmpname, job->fname, NULL);
+    uv_fs_req_cleanup(&fs);
+  }
+  if (r < 0) {
+    uv_fs_unlink(&loop, &fs, job->tmpname, NULL);
+    uv_fs_req_cleanup(&fs);
+    job->error = r;
+  }
+  uv_loop_close(&loop);
+  trace_end(span, "io", "write", job->fname);
+}
+
+static void buf_write_bg_after_work(uv_work_t *req, int status)
+{
+  ((BufWriteJob *)req->data)->done = true;
+  multiqueue_put(main_loop.events, buf_write_bg_event, 0);
+}
+
+static void buf_write_bg_event(void **argv)
+{
+  buf_write_bg_reap(true);
+}
+
+/// Finish the ":write" commands done in the background whose worker has
+/// finished.  Their BufWritePost autocommands are executed when "autocmds"
+/// is true, otherwise that is left for buf_write_bg_event().
+static void buf_write_bg_reap(bool autocmds)
+{
+  for (BufWriteJob *job = bwb_jobs; job != NULL; job = job->next) {
+    if (job->done && !job->completed) {
+      buf_write_bg_complete(job);
+    }
+  }
+  while (autocmds) {
+    BufWriteJob **pp = &bwb_jobs;
+    while (*pp != NULL && !(*pp)->completed) {
+      pp = &(*pp)->next;
+    }
+    BufWriteJob *const job = *pp;
+    if (job == NULL) {
+      return;
+    }
+    // Unlink first, autocommands may start or wait for another write.
+    *pp = job->next;
+    buf_write_bg_autocmds(job);
+    buf_write_bg_free(job);
+  }
+}
+
+/// Wait for the ":write" commands done in the background for "buf" to
+/// finish, or for all buffers when "buf" is NULL.
+///
+/// @param autocmds  Also execute the BufWritePost autocommands of finished
+///                  writes.  Otherwise they are executed later from the main
+///                  loop, so that buffers can't be deleted under the caller.
+void buf_write_bg_wait(buf_T *buf, bool autocmds)
+{
+  for (;;) {
+    BufWriteJob *job = bwb_jobs;
+    while (job != NULL
+           && (job->done || (buf != NULL && job->bufref.br_buf != buf))) {
+      job = job->next;
+    }
+    if (job == NULL) {
+      break;
+    }
+    LOOP_PROCESS_EVENTS_UNTIL(&main_loop, NULL, -1, job->done);
+  }
+  buf_write_bg_reap(autocmds);
+}
+
+/// Does what buf_write() does after writing the file, for a job started by
+/// buf_write_bg_start(), except for executing autocommands.
+static void buf_write_bg_complete(BufWriteJob *job)
+{
+  job->completed = true;
+  buf_T *const buf = bufref_valid(&job->bufref) ? job->bufref.br_buf : NULL;
+  char_u *const fname = (char_u *)job->sfname;
+
+  if (job->error != 0) {
+    add_quoted_fname((char *)IObuff, IOSIZE - 100, buf, (const char *)fname);
+    emsgf(_("E5410: %swrite failed: %s"), IObuff, os_strerror(job->error));
+  }
+  if (buf == NULL) {
+    return;
+  }
+  buf->b_write_bg = false;
+  buf->b_saving = false;
+  if (job->error != 0) {
+    return;
+  }
+
+  buf_set_file_id(buf);
+  add_quoted_fname((char *)IObuff, IOSIZE, buf, (const char *)fname);
+  bool c = false;
+  if (job->newfile) {
+    STRCAT(IObuff, new_file_message());
+    c = true;
+  }
+  if (job->no_eol) {
+    msg_add_eol();
+    c = true;
+  }
+  if (msg_add_fileformat(job->fileformat)) {
+    c = true;
+  }
+  msg_add_lines(c, (long)job->nlines, job->nchars);
+  if (!shortmess(SHM_WRITE)) {
+    STRCAT(IObuff, shortmess(SHM_WRI) ? _(" [w]") : _(" written"));
+  }
+  set_keep_msg(msg_trunc_attr(IObuff, false, 0), 0);
+
+  // Changing the buffer waits for the write, but check anyway.  The buffer
+  // may also have been unloaded.
+  if (buf_get_changedtick(buf) == job->changedtick
+      && buf->b_ml.ml_mfp != NULL) {
+    unchanged(buf, true, false);
+    const varnumber_T changedtick = buf_get_changedtick(buf);
+    if (buf->b_last_changedtick + 1 == changedtick) {
+      // b:changedtick may be incremented in unchanged() but that
+      // should not trigger a TextChanged event.
+      buf->b_last_changedtick = changedtick;
+    }
+    u_unchanged(buf);
+    u_update_save_nr(buf);
+    if (job->write_undo_file) {
+      u_write_undo(NULL, false, buf, job->hash);
+    }
+  }
+  ml_timestamp(buf);
+  buf->b_flags &= ~BF_WRITE_MASK;
+  runtime_index_invalidate(job->fname);
+}
+
+/// Executes the BufWritePost autocommands for a job completed by
+/// buf_write_bg_complete().
+static void buf_write_bg_autocmds(BufWriteJob *job)
+{
+  if (job->error != 0 || !bufref_valid(&job->bufref)
+      || job->bufref.br_buf->b_ml.ml_mfp == NULL) {
+    return;
+  }
+  buf_T *const buf = job->bufref.br_buf;
+  char_u *const fname = (char_u *)job->sfname;
+  aco_save_T aco;
+  buf->b_no_eol_lnum = 0;
+  aucmd_prepbuf(&aco, buf);
+  apply_autocmds(EVENT_BUFWRITEPOST, fname, fname, false, curbuf);
+  aucmd_restbuf(&aco);
+}
+
+static void buf_write_bg_free(BufWriteJob *job)
+{
+  for (size_t i = 0; i < kv_size(job->chunks); i++) {
+    xfree(kv_A(job->chunks, i));
+  }
+  kv_destroy(job->chunks);
+  xfree(job->fname);
+  xfree(job->sfname);
+  xfree(job->tmpname);
+  xfree(job);
+}
+
 /*
  * Set the name of the current buffer.  Use when the buffer doesn't have a
  * name and a ":r" or ":w" command with a file name is used.
@@ -331,7 +331,8 @@ for i = 1, #functions do
       output:write('  msgpack_rpc_add_method_handler('..
                    '(String) {.data = "'..fn.name..'", '..
                    '.size = sizeof("'..fn.name..'") - 1}, '..
-                   '(MsgpackRpcRequestHandler) {.fn = handle_'..  (fn.impl_name or fn.name)..
+                   '(MsgpackRpcRequestHandler) {.name = "'..fn.name..'", '..
+                   '.fn = handle_'..  (fn.impl_name or fn.name)..
                    ', .fast = '..tostring(fn.fast)..'});\n')
   end
 end
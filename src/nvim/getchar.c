@@ -35,6 +35,7 @@
 #include "nvim/message.h"
 #include "nvim/misc1.h"
 #include "nvim/keymap.h"
+#include "nvim/latency.h"
 #include "nvim/garray.h"
 #include "nvim/move.h"
 #include "nvim/normal.h"
@@ -1409,6 +1410,7 @@ int vgetc(void)
   int n;
   char_u buf[MB_MAXBYTES + 1];
   int i;
+  const LatencySpan span = latency_begin(kLatencyVgetc);
 
   // Do garbage collection when garbagecollect() was called previously and
   // we are now at the toplevel.
@@ -1558,6 +1560,7 @@ int vgetc(void)
   // Exec lua callbacks for on_keystroke
   nlua_execute_log_keystroke(c);
 
+  latency_end(&span);
   return c;
 }
 
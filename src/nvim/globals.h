@@ -75,7 +75,12 @@
 EXTERN struct nvim_stats_s {
   int64_t fsync;
   int64_t redraw;
-} g_stats INIT(= { 0, 0 });
+  int64_t regexp_cache_hit;
+  int64_t regexp_cache_miss;
+  int64_t memfile_cache_hit;
+  int64_t memfile_cache_miss;
+  int64_t memfile_cache_evict;
+} g_stats INIT(= { 0, 0, 0, 0, 0, 0, 0 });
 
 // Values for "starting".
 #define NO_SCREEN       2       // no screen updating yet
@@ -41,6 +41,38 @@
 
 char hash_removed;
 
+/// Interned string
+///
+/// Like with other hashtab users the key is contained within the item, so
+/// hash and length of an interned key can be found from the key pointer.
+typedef struct {
+  hash_T is_hash;   ///< Precomputed hash_hash() of is_key.
+  size_t is_len;    ///< Length of is_key.
+  char_u is_key[];  ///< NUL-terminated key.
+} InternedString;
+
+/// Get InternedString from a key returned by hash_intern().
+#define IKEY2IS(ikey) \
+    ((InternedString *)((ikey) - offsetof(InternedString, is_key)))
+
+/// Maximum length of a string that is interned.
+#define HASH_INTERN_MAX_LEN 256
+
+/// Maximum number of strings held in the intern table.
+///
+/// Interned strings are never freed (except by free_all_mem()), this keeps
+/// memory used by the table bounded.
+#define HASH_INTERN_MAX_ITEMS 16384
+
+/// Table with interned strings, see hash_intern().
+static hashtab_T intern_ht = { .ht_array = NULL };
+
+/// Number of hash_intern() calls which found an existing string.
+static size_t intern_hits = 0;
+
+/// Number of hash_intern() calls which did not find an existing string.
+static size_t intern_misses = 0;
+
 /// Initialize an empty hash table.
 void hash_init(hashtab_T *ht)
 {
@@ -442,6 +474,102 @@ hash_T hash_hash_len(const char *key, const size_t len)
 
 #undef HASH_CYCLE_BODY
 
+/// Intern a string
+///
+/// Returns a shared copy of the key with its hash and length computed once,
+/// so that the same key can be looked up in any number of hashtables (dict
+/// keys decoded from JSON, variable and function names) without hashing it
+/// again: @see hash_find_interned().
+///
+/// @param[in]  key  Key to intern, need not be NUL-terminated.
+/// @param[in]  len  Key length.
+///
+/// @return Interned key, valid until free_all_mem(). NULL if the key is too
+///         long, contains NUL or the intern table is full: callers must then
+///         fall back to regular hash_find().
+const char_u *hash_intern(const char *const key, const size_t len)
+  FUNC_ATTR_NONNULL_ALL FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  if (len > HASH_INTERN_MAX_LEN || memchr(key, NUL, len) != NULL) {
+    return NULL;
+  }
+  if (intern_ht.ht_array == NULL) {
+    hash_init(&intern_ht);
+  }
+  const hash_T hash = hash_hash_len(key, len);
+  hashitem_T *const hi = hash_lookup(&intern_ht, key, len, hash);
+  if (!HASHITEM_EMPTY(hi)) {
+    intern_hits++;
+    return hi->hi_key;
+  }
+  intern_misses++;
+  if (intern_ht.ht_used >= HASH_INTERN_MAX_ITEMS) {
+    return NULL;
+  }
+  InternedString *const is = xmalloc(offsetof(InternedString, is_key)
+                                     + len + 1);
+  is->is_hash = hash;
+  is->is_len = len;
+  memcpy(is->is_key, key, len);
+  is->is_key[len] = NUL;
+  hash_add_item(&intern_ht, hi, is->is_key, hash);
+  return is->is_key;
+}
+
+/// Get the precomputed hash of a key returned by hash_intern()
+hash_T hash_intern_hash(const char_u *const ikey)
+  FUNC_ATTR_NONNULL_ALL FUNC_ATTR_PURE FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  return IKEY2IS(ikey)->is_hash;
+}
+
+/// Get the length of a key returned by hash_intern()
+size_t hash_intern_len(const char_u *const ikey)
+  FUNC_ATTR_NONNULL_ALL FUNC_ATTR_PURE FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  return IKEY2IS(ikey)->is_len;
+}
+
+/// Like hash_find(), but uses hash and length precomputed by hash_intern()
+///
+/// @param[in]  ht  Hashtab to look in.
+/// @param[in]  ikey  Key returned by hash_intern().
+///
+/// @return Same as hash_find().
+hashitem_T *hash_find_interned(const hashtab_T *const ht,
+                               const char_u *const ikey)
+  FUNC_ATTR_NONNULL_ALL FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  const InternedString *const is = IKEY2IS(ikey);
+  return hash_lookup(ht, (const char *)is->is_key, is->is_len, is->is_hash);
+}
+
+/// Get statistics of the intern table
+///
+/// @param[out]  hits  Number of lookups which found an interned string.
+/// @param[out]  misses  Number of lookups which did not.
+///
+/// @return Number of interned strings.
+size_t hash_intern_stats(size_t *const hits, size_t *const misses)
+  FUNC_ATTR_NONNULL_ALL
+{
+  *hits = intern_hits;
+  *misses = intern_misses;
+  return intern_ht.ht_array == NULL ? 0 : intern_ht.ht_used;
+}
+
+#if defined(EXITFREE)
+/// Free all interned strings
+void hash_intern_free_all(void)
+{
+  if (intern_ht.ht_array == NULL) {
+    return;
+  }
+  hash_clear_all(&intern_ht, offsetof(InternedString, is_key));
+  intern_ht.ht_array = NULL;
+}
+#endif
+
 /// Function to get HI_KEY_REMOVED value
 ///
 /// Used for testing because luajit ffi does not allow getting addresses of
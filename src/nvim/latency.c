@@ -0,0 +1,207 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check
+// it. PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+// Latency histograms for the phases of the main loop.
+//
+// Always enabled: recording a sample costs two monotonic clock reads and a
+// few additions. Samples go into log-linear buckets (as in HdrHistogram):
+// values below 2^LATENCY_SUB_BITS microseconds are exact, larger ones are
+// rounded to 1/2^LATENCY_SUB_BITS of their power of two, about 6%.
+//
+// Time spent waiting for input (in inbuf_poll()) is not counted, and a span
+// which contains a nested span of the same phase is dropped, e.g. executing
+// "i" in Normal mode runs all of Insert mode.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nvim/latency.h"
+#include "nvim/api/private/defs.h"
+#include "nvim/api/private/helpers.h"
+#include "nvim/os/time.h"
+
+#define LATENCY_SUB_BITS 4
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)
+/// Largest power of two kept apart, larger values go into the last bucket.
+#define LATENCY_MAX_EXP 40
+#define LATENCY_BUCKETS \
+  ((LATENCY_MAX_EXP - LATENCY_SUB_BITS + 2) * LATENCY_SUB_COUNT)
+
+typedef struct {
+  uint64_t count;
+  uint64_t sum;  ///< microseconds
+  uint64_t min;  ///< microseconds
+  uint64_t max;  ///< microseconds
+  uint64_t buckets[LATENCY_BUCKETS];
+} LatencyHistogram;
+
+static const char *const latency_names[kLatencyPhaseCount] = {
+  [kLatencyKey] = "key",
+  [kLatencyInput] = "input",
+  [kLatencyVgetc] = "vgetc",
+  [kLatencyExecute] = "execute",
+  [kLatencyRedraw] = "redraw",
+  [kLatencyFlush] = "flush",
+  [kLatencyRpc] = "rpc",
+};
+
+static LatencyHistogram latency_hist[kLatencyPhaseCount];
+/// Number of spans started for each phase, to detect nesting.
+static uint64_t latency_seq[kLatencyPhaseCount];
+/// Total time spent waiting for input, in nanoseconds.
+static uint64_t latency_waited = 0;
+/// Time when input arrived which was not shown by ui_flush() yet, or 0.
+static uint64_t latency_key_start = 0;
+
+#ifdef INCLUDE_GENERATED_DECLARATIONS
+# include "latency.c.generated.h"
+#endif
+
+/// Gets the bucket for a value in microseconds.
+static size_t latency_bucket(uint64_t us)
+  FUNC_ATTR_CONST
+{
+  if (us < LATENCY_SUB_COUNT) {
+    return (size_t)us;
+  }
+  int exp = LATENCY_SUB_BITS;
+  while (exp < LATENCY_MAX_EXP && (us >> (exp + 1)) != 0) {
+    exp++;
+  }
+  if ((us >> (exp + 1)) != 0) {
+    return LATENCY_BUCKETS - 1;
+  }
+  const size_t sub = (size_t)(us >> (exp - LATENCY_SUB_BITS))
+                     & (LATENCY_SUB_COUNT - 1);
+  return (size_t)(exp - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT + sub;
+}
+
+/// Gets the largest value in microseconds which goes into bucket `idx`.
+static uint64_t latency_bucket_max(size_t idx)
+  FUNC_ATTR_CONST
+{
+  if (idx < LATENCY_SUB_COUNT) {
+    return idx;
+  }
+  const int exp = (int)(idx / LATENCY_SUB_COUNT) + LATENCY_SUB_BITS - 1;
+  const uint64_t sub = idx % LATENCY_SUB_COUNT;
+  const int shift = exp - LATENCY_SUB_BITS;
+  return ((LATENCY_SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+/// Adds a sample to the histogram of `phase`.
+///
+/// @param  ns  Duration in nanoseconds.
+void latency_add(LatencyPhase phase, uint64_t ns)
+{
+  assert(phase < kLatencyPhaseCount);
+  LatencyHistogram *const h = &latency_hist[phase];
+  const uint64_t us = ns / 1000;
+  if (h->count == 0 || us < h->min) {
+    h->min = us;
+  }
+  if (us > h->max) {
+    h->max = us;
+  }
+  h->count++;
+  h->sum += us;
+  h->buckets[latency_bucket(us)]++;
+}
+
+/// Starts measuring `phase`, finish with latency_end().
+LatencySpan latency_begin(LatencyPhase phase)
+  FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  return (LatencySpan) {
+    .phase = phase,
+    .start = os_hrtime(),
+    .waited = latency_waited,
+    .seq = ++latency_seq[phase],
+  };
+}
+
+/// Adds the duration of `span` to its histogram.
+void latency_end(const LatencySpan *span)
+  FUNC_ATTR_NONNULL_ALL
+{
+  if (latency_seq[span->phase] != span->seq) {
+    return;  // Nested span of the same phase, do not count it twice.
+  }
+  const uint64_t waited = latency_waited - span->waited;
+  const uint64_t elapsed = os_hrtime() - span->start;
+  latency_add(span->phase, elapsed > waited ? elapsed - waited : 0);
+}
+
+/// Adds time spent waiting for input, which is not counted in any phase.
+void latency_wait(uint64_t ns)
+{
+  latency_waited += ns;
+}
+
+/// Called when input is queued. Starts the "key" latency.
+void latency_input_queued(void)
+{
+  if (latency_key_start == 0) {
+    latency_key_start = os_hrtime();
+  }
+}
+
+/// Called after the UI was flushed. Finishes the "key" latency when all
+/// queued input was consumed.
+///
+/// @param  input_pending  Queued input was not read yet.
+void latency_ui_flushed(bool input_pending)
+{
+  if (latency_key_start != 0 && !input_pending) {
+    latency_add(kLatencyKey, os_hrtime() - latency_key_start);
+    latency_key_start = 0;
+  }
+}
+
+/// Gets the value below which fraction `q` of the samples in `h` fall.
+static uint64_t latency_quantile(const LatencyHistogram *h, double q)
+{
+  const uint64_t rank = (uint64_t)((double)h->count * q + 0.5);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += h->buckets[i];
+    if (seen >= rank && seen > 0) {
+      const uint64_t v = latency_bucket_max(i);
+      return v < h->max ? v : h->max;
+    }
+  }
+  return h->max;
+}
+
+/// Gets the statistics of all phases, times in microseconds.
+///
+/// @return Dictionary with a Dictionary for each phase with samples.
+Dictionary latency_stats(void)
+{
+  Dictionary rv = ARRAY_DICT_INIT;
+  for (int i = 0; i < kLatencyPhaseCount; i++) {
+    const LatencyHistogram *const h = &latency_hist[i];
+    if (h->count == 0) {
+      continue;
+    }
+    Dictionary d = ARRAY_DICT_INIT;
+    PUT(d, "count", INTEGER_OBJ((Integer)h->count));
+    PUT(d, "min", INTEGER_OBJ((Integer)h->min));
+    PUT(d, "max", INTEGER_OBJ((Integer)h->max));
+    PUT(d, "mean", INTEGER_OBJ((Integer)(h->sum / h->count)));
+    PUT(d, "p50", INTEGER_OBJ((Integer)latency_quantile(h, 0.5)));
+    PUT(d, "p90", INTEGER_OBJ((Integer)latency_quantile(h, 0.9)));
+    PUT(d, "p99", INTEGER_OBJ((Integer)latency_quantile(h, 0.99)));
+    PUT(d, "p999", INTEGER_OBJ((Integer)latency_quantile(h, 0.999)));
+    PUT(rv, latency_names[i], DICTIONARY_OBJ(d));
+  }
+  return rv;
+}
+
+/// Discards all samples.
+void latency_reset(void)
+{
+  memset(latency_hist, 0, sizeof(latency_hist));
+}
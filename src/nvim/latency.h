@@ -0,0 +1,32 @@
+#ifndef NVIM_LATENCY_H
+#define NVIM_LATENCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nvim/api/private/defs.h"
+
+/// Phases of the main loop with a latency histogram, see latency.c.
+typedef enum {
+  kLatencyKey,      ///< from input arriving until the UI flush after it
+  kLatencyInput,    ///< queueing input in os/input.c
+  kLatencyVgetc,    ///< vgetc(), not counting the time it waited for input
+  kLatencyExecute,  ///< executing a key in the current state
+  kLatencyRedraw,   ///< update_screen()
+  kLatencyFlush,    ///< ui_flush()
+  kLatencyRpc,      ///< handling an RPC request or notification
+  kLatencyPhaseCount,
+} LatencyPhase;
+
+/// A phase being measured, see latency_begin().
+typedef struct {
+  LatencyPhase phase;
+  uint64_t start;   ///< os_hrtime() at the start
+  uint64_t waited;  ///< time waited for input before the start
+  uint64_t seq;     ///< number of spans of the phase started before
+} LatencySpan;
+
+#ifdef INCLUDE_GENERATED_DECLARATIONS
+# include "latency.h.generated.h"
+#endif
+#endif  // NVIM_LATENCY_H
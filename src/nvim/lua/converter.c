@@ -183,6 +183,39 @@ typedef struct {
   int idx;  ///< Container index (used to detect self-referencing structures).
 } TVPopStackItem;
 
+/// Convert leading string items of a lua array to VimL list items
+///
+/// Bulk path for nlua_pop_typval(): lists of strings (lines, file names, …)
+/// do not need to go through the conversion stack. Stops at the first item
+/// which is not a string or contains NUL, remaining items are left to the
+/// generic code which continues from the current length of the list.
+///
+/// Expects the array on top of the lua stack, leaves the stack unchanged.
+///
+/// @param  lstate  Lua state.
+/// @param[out]  l  List to append to.
+/// @param[in]  maxidx  Length of the array.
+static void nlua_pop_string_items(lua_State *const lstate, list_T *const l,
+                                  const size_t maxidx)
+  FUNC_ATTR_NONNULL_ALL
+{
+  for (size_t i = (size_t)tv_list_len(l) + 1; i <= maxidx; i++) {
+    lua_rawgeti(lstate, -1, (int)i);
+    if (lua_type(lstate, -1) != LUA_TSTRING) {
+      lua_pop(lstate, 1);
+      return;
+    }
+    size_t len;
+    const char *const s = lua_tolstring(lstate, -1, &len);
+    if (memchr(s, NUL, len) != NULL) {
+      lua_pop(lstate, 1);
+      return;
+    }
+    tv_list_append_string(l, s, (ssize_t)len);
+    lua_pop(lstate, 1);
+  }
+}
+
 /// Convert lua object to VimL typval_T
 ///
 /// Should pop exactly one value from lua stack.
@@ -340,7 +373,10 @@ bool nlua_pop_typval(lua_State *lstate, typval_T *ret_tv)
             cur.tv->vval.v_list = tv_list_alloc((ptrdiff_t)table_props.maxidx);
             cur.tv->vval.v_list->lua_table_ref = table_ref;
             tv_list_ref(cur.tv->vval.v_list);
-            if (table_props.maxidx != 0) {
+            nlua_pop_string_items(lstate, cur.tv->vval.v_list,
+                                  table_props.maxidx);
+            if ((size_t)tv_list_len(cur.tv->vval.v_list)
+                < table_props.maxidx) {
               cur.container = true;
               cur.idx = lua_gettop(lstate);
               kv_push(stack, cur);
@@ -602,6 +638,40 @@ static bool typval_conv_special = false;
 #undef TYPVAL_ENCODE_CONV_RECURSE
 #undef TYPVAL_ENCODE_ALLOW_SPECIALS
 
+/// Push VimL list of strings as a lua array
+///
+/// Bulk path for nlua_push_typval(): converting a list which contains only
+/// strings needs none of the recursion tracking done by encode_vim_to_lua().
+///
+/// @param  lstate  Lua interpreter state.
+/// @param[in]  l  List to convert.
+///
+/// @return true if list was pushed, false if it contains something other than
+///         strings (or is empty), nothing is pushed then.
+static bool nlua_push_string_list(lua_State *const lstate,
+                                  const list_T *const l)
+  FUNC_ATTR_NONNULL_ARG(1) FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  const int len = tv_list_len(l);
+  if (len == 0) {
+    return false;
+  }
+  TV_LIST_ITER_CONST(l, li, {
+    if (TV_LIST_ITEM_TV(li)->v_type != VAR_STRING) {
+      return false;
+    }
+  });
+  lua_createtable(lstate, len, 0);
+  int idx = 1;
+  TV_LIST_ITER_CONST(l, li, {
+    const typval_T *const item_tv = TV_LIST_ITEM_TV(li);
+    lua_pushlstring(lstate, (const char *)item_tv->vval.v_string,
+                    tv_strlen(item_tv));
+    lua_rawseti(lstate, -2, idx++);
+  });
+  return true;
+}
+
 /// Convert VimL typval_T to lua value
 ///
 /// Should leave single value in lua stack. May only fail if lua failed to grow
@@ -620,6 +690,10 @@ bool nlua_push_typval(lua_State *lstate, typval_T *const tv, bool special)
     emsgf(_("E1502: Lua failed to grow stack to %i"), initial_size + 4);
     return false;
   }
+  if (tv->v_type == VAR_LIST && nlua_push_string_list(lstate,
+                                                      tv->vval.v_list)) {
+    return true;
+  }
   if (encode_vim_to_lua(lstate, tv, "nlua_push_typval argument") == FAIL) {
     return false;
   }
@@ -36,6 +36,7 @@
 #include "nvim/event/loop.h"
 
 #include "nvim/os/os.h"
+#include "nvim/os/time.h"
 
 #include "nvim/lua/converter.h"
 #include "nvim/lua/executor.h"
@@ -1446,6 +1447,48 @@ bool nlua_exec_file(const char *path)
   return true;
 }
 
+/// Execute lua file contents read in advance
+///
+/// Like nlua_exec_file(), for a file already read into memory.
+///
+/// @param  path  File name, used as the chunk name.
+/// @param  data  File contents, a "#!" first line is blanked out.
+/// @param  len  Length of data.
+/// @param[out]  parse_time  Time taken to load the chunk, in nanoseconds.
+bool nlua_exec_file_contents(const char *path, char *data, size_t len,
+                             uint64_t *parse_time)
+  FUNC_ATTR_NONNULL_ALL
+{
+  lua_State *const lstate = nlua_enter();
+
+  // luaL_loadfile() skips the first line when it starts with "#", keep the
+  // line count.
+  if (len > 0 && *data == '#') {
+    for (size_t i = 0; i < len && data[i] != '\n'; i++) {
+      data[i] = ' ';
+    }
+  }
+
+  size_t name_len = strlen(path) + 2;
+  char *const chunkname = xmalloc(name_len);
+  snprintf(chunkname, name_len, "@%s", path);
+  const uint64_t start = os_hrtime();
+  const int err = luaL_loadbuffer(lstate, data, len, chunkname);
+  *parse_time = os_hrtime() - start;
+  xfree(chunkname);
+  if (err) {
+    nlua_error(lstate, _("E5112: Error while creating lua chunk: %.*s"));
+    return false;
+  }
+
+  if (lua_pcall(lstate, 0, 0, 0)) {
+    nlua_error(lstate, _("E5113: Error while calling lua chunk: %.*s"));
+    return false;
+  }
+
+  return true;
+}
+
 int tslua_get_language_version(lua_State *L)
 {
   lua_pushnumber(L, TREE_SITTER_LANGUAGE_VERSION);
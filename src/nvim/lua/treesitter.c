@@ -21,6 +21,7 @@
 #include "nvim/api/private/handle.h"
 #include "nvim/memline.h"
 #include "nvim/buffer.h"
+#include "nvim/trace.h"
 
 #define TS_META_PARSER "treesitter_parser"
 #define TS_META_TREE "treesitter_tree"
@@ -353,8 +354,9 @@ static int parser_parse(lua_State *L)
   size_t len;
   const char *str;
   long bufnr;
-  buf_T *buf;
+  buf_T *buf = NULL;
   TSInput input;
+  const TraceSpan trace_span = trace_begin();
 
   // This switch is necessary because of the behavior of lua_isstring, that
   // consider numbers as strings...
@@ -380,6 +382,8 @@ static int parser_parse(lua_State *L)
     default:
       return luaL_error(L, "invalid argument to parser:parse()");
   }
+  trace_end(trace_span, "treesitter", "parse",
+            buf != NULL ? (char *)buf->b_ffname : NULL);
 
   // Sometimes parsing fails (timeout, or wrong parser ABI)
   // In those case, just return an error.
@@ -53,13 +53,131 @@ for s in  (package.cpath..';'):gmatch('[^;]*;') do
   end
 end
 
+-- State of the lua module cache, see |vim.luacache|.
+local luacache = {
+  enabled = false,
+  dir = nil,  -- Directory with compiled chunks and the index.
+  rtp = nil,  -- 'runtimepath' the index was built for.
+  stamp = nil,  -- luacache_stamp() of 'runtimepath' when the index was built.
+  checked = false,  -- Whether "stamp" was compared after loading the index.
+  index = {},  -- Module name -> path of the file it was loaded from.
+  index_changed = false,
+  stats = { chunk_hits = 0, index_hits = 0 },
+}
+
+-- Name of the file with the compiled chunk of "path". Characters that can't
+-- be in a file name and "%" itself are escaped as "%XX".
+local function luacache_chunk_file(path)
+  return luacache.dir..'/'..path:gsub('[%%/\\:]', function(c)
+    return ('%%%02X'):format(c:byte())
+  end)
+end
+
+-- Modification times of the "lua" directories in 'runtimepath': a module
+-- added to an entry before the one where it was found before changes it.
+local function luacache_stamp(rtp)
+  local stamps = {}
+  for _, dir in ipairs(vim.split(rtp, ',', true)) do
+    local stat = vim.loop.fs_stat(dir..'/lua')
+    table.insert(stamps, stat
+      and ('%d.%d'):format(stat.mtime.sec, stat.mtime.nsec) or '-')
+  end
+  return table.concat(stamps, ',')
+end
+
+-- Like loadfile(), but reuses bytecode compiled earlier while the file keeps
+-- its mtime and size.
+local function luacache_loadfile(path)
+  local stat = vim.loop.fs_stat(path)
+  if not stat then
+    return loadfile(path)
+  end
+  local stamp = ('%d:%d:%d\n'):format(stat.mtime.sec, stat.mtime.nsec, stat.size)
+  local chunk_file = luacache_chunk_file(path)
+  local f = io.open(chunk_file, 'rb')
+  if f then
+    local data = f:read('*a')
+    f:close()
+    if data and data:sub(1, #stamp) == stamp then
+      local chunk = loadstring(data:sub(#stamp + 1), '@'..path)
+      if chunk then
+        luacache.stats.chunk_hits = luacache.stats.chunk_hits + 1
+        return chunk
+      end
+    end
+  end
+  local chunk, err = loadfile(path)
+  if not chunk then
+    return nil, err
+  end
+  -- Write to a temporary file and rename it: other Nvim instances may be
+  -- reading the cache at the same time.
+  local tmp = ('%s.%.0f'):format(chunk_file, vim.loop.hrtime())
+  f = io.open(tmp, 'wb')
+  if f then
+    f:write(stamp, string.dump(chunk))
+    f:close()
+    os.rename(tmp, chunk_file)
+  end
+  return chunk
+end
+
+-- Finds path of the file in 'runtimepath' the module was loaded from before,
+-- so that require() does not need to search 'runtimepath' again.
+local function luacache_find(name)
+  if vim.in_fast_event() then
+    return nil
+  end
+  local rtp = vim.api.nvim_get_option('runtimepath')
+  if rtp ~= luacache.rtp
+      or (not luacache.checked and luacache_stamp(rtp) ~= luacache.stamp) then
+    luacache.rtp = rtp
+    luacache.stamp = luacache_stamp(rtp)
+    luacache.checked = true
+    luacache.index = {}
+    luacache.index_changed = true
+    return nil
+  end
+  luacache.checked = true
+  local path = luacache.index[name]
+  if path and not vim.loop.fs_stat(path) then
+    luacache.index[name] = nil
+    luacache.index_changed = true
+    return nil
+  end
+  if path then
+    luacache.stats.index_hits = luacache.stats.index_hits + 1
+  end
+  return path
+end
+
+local function luacache_remember(name, path)
+  if luacache.index[name] ~= path and not vim.in_fast_event() then
+    luacache.index[name] = path
+    luacache.index_changed = true
+  end
+end
+
 function vim._load_package(name)
+  local load = loadfile
+  if luacache.enabled then
+    load = luacache_loadfile
+    local path = luacache_find(name)
+    if path then
+      local f, err = load(path)
+      return f or error(err)
+    end
+  end
+
   local basename = name:gsub('%.', '/')
   local paths = {"lua/"..basename..".lua", "lua/"..basename.."/init.lua"}
   for _,path in ipairs(paths) do
     local found = vim.api.nvim_get_runtime_file(path, false)
     if #found > 0 then
-      local f, err = loadfile(found[1])
+      if luacache.enabled then
+        luacache_remember(name, found[1])
+      end
+      local f, err = load(found[1])
       return f or error(err)
     end
   end
@@ -84,6 +202,87 @@ end
 
 table.insert(package.loaders, 1, vim._load_package)
 
+--- Cache for lua modules loaded with `require()`.
+---
+--- When enabled, modules found in 'runtimepath' are stored as compiled
+--- bytecode under `stdpath('cache')/luacache`, and reused until the source
+--- file changes its modification time or size. Paths of found modules are
+--- remembered (and saved on exit) so that next `require()` of the same module
+--- does not need to search 'runtimepath'. The index is discarded when
+--- 'runtimepath' changes.
+vim.luacache = {}
+
+--- Enables the cache. Call it as early as possible, e.g. first thing in
+--- |init.lua|.
+function vim.luacache.enable()
+  if luacache.enabled then
+    return
+  end
+  luacache.dir = vim.fn.stdpath('cache')..'/luacache'
+  vim.fn.mkdir(luacache.dir, 'p')
+  luacache.enabled = true
+  luacache.rtp = nil
+  luacache.checked = false
+  luacache.index = {}
+  local f = io.open(luacache.dir..'/index', 'rb')
+  if f then
+    luacache.rtp = f:read('*l')
+    luacache.stamp = f:read('*l')
+    for line in f:lines() do
+      local name, path = line:match('^([^\t]+)\t(.+)$')
+      if name then
+        luacache.index[name] = path
+      end
+    end
+    f:close()
+  end
+  luacache.index_changed = false
+  vim.api.nvim_exec([[
+    augroup luacache
+      autocmd!
+      autocmd VimLeavePre * lua vim.luacache._save_index()
+    augroup END
+  ]], false)
+end
+
+--- Disables the cache. Files already in the cache are kept.
+function vim.luacache.disable()
+  luacache.enabled = false
+end
+
+--- Removes all files from the cache.
+function vim.luacache.clear()
+  local dir = luacache.dir or (vim.fn.stdpath('cache')..'/luacache')
+  for _, file in ipairs(vim.fn.glob(dir..'/*', true, true)) do
+    os.remove(file)
+  end
+  luacache.index = {}
+  luacache.rtp = nil
+end
+
+function vim.luacache._stats()
+  return vim.deepcopy(luacache.stats)
+end
+
+function vim.luacache._save_index()
+  if not luacache.enabled or not luacache.index_changed
+      or luacache.rtp == nil then
+    return
+  end
+  local tmp = ('%s/index.%.0f'):format(luacache.dir, vim.loop.hrtime())
+  local f = io.open(tmp, 'wb')
+  if not f then
+    return
+  end
+  f:write(luacache.rtp, '\n', luacache.stamp, '\n')
+  for name, path in pairs(luacache.index) do
+    f:write(name, '\t', path, '\n')
+  end
+  f:close()
+  os.rename(tmp, luacache.dir..'/index')
+  luacache.index_changed = false
+end
+
 -- These are for loading runtime modules lazily since they aren't available in
 -- the nvim binary as specified in executor.c
 setmetatable(vim, {
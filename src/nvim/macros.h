@@ -242,4 +242,12 @@
 
 #define EMPTY_POS(a) ((a).lnum == 0 && (a).col == 0 && (a).coladd == 0)
 
+/// Storage class of a variable with a separate instance for each thread, for
+/// state that work done on other threads must not share with the main thread.
+#ifdef _MSC_VER
+# define THREAD_LOCAL __declspec(thread)
+#else
+# define THREAD_LOCAL __thread
+#endif
+
 #endif  // NVIM_MACROS_H
@@ -54,11 +54,13 @@
 #include "nvim/profile.h"
 #include "nvim/popupmnu.h"
 #include "nvim/quickfix.h"
+#include "nvim/runtime.h"
 #include "nvim/screen.h"
 #include "nvim/sign.h"
 #include "nvim/state.h"
 #include "nvim/strings.h"
 #include "nvim/syntax.h"
+#include "nvim/trace.h"
 #include "nvim/ui.h"
 #include "nvim/ui_compositor.h"
 #include "nvim/version.h"
@@ -131,6 +133,7 @@ void event_init(void)
   remote_ui_init();
   api_vim_init();
   terminal_init();
+  syntax_idle_init();
   ui_init();
 }
 
@@ -151,6 +154,8 @@ bool event_teardown(void)
   server_teardown();
   signal_teardown();
   terminal_teardown();
+  syntax_idle_teardown();
+  runtime_index_teardown();
 
   return loop_close(&main_loop, true);
 }
@@ -411,7 +416,7 @@ int main(int argc, char **argv)
   // This is where v:oldfiles gets filled.
   //
   if (*p_shada != NUL) {
-    shada_read_everything(NULL, false, true);
+    shada_read_startup();
     TIME_MSG("reading ShaDa");
   }
   // It's better to make v:oldfiles an empty list than NULL.
@@ -570,6 +575,9 @@ int main(int argc, char **argv)
 void os_exit(int r)
   FUNC_ATTR_NORETURN
 {
+  if (!v_dying) {
+    buf_write_bg_wait(NULL, false);  // Finish writing files in the background.
+  }
   exiting = true;
 
   ui_flush();
@@ -615,6 +623,10 @@ void getout(int exitval)
   if (v_dying <= 1) {
     const tabpage_T *next_tp;
 
+    // Finish writing files in the background, with their BufWritePost
+    // autocommands, before anything else happens.
+    buf_write_bg_wait(NULL, true);
+
     // Trigger BufWinLeave for all windows, but only once per buffer.
     for (const tabpage_T *tp = first_tabpage; tp != NULL; tp = next_tp) {
       next_tp = tp->tp_next;
@@ -669,7 +681,7 @@ void getout(int exitval)
 
   if (p_shada && *p_shada != NUL) {
     // Write out the registers, history, marks etc, to the ShaDa file
-    shada_write_file(NULL, false);
+    shada_write_file_on_exit();
   }
 
   if (v_dying <= 1) {
@@ -1288,7 +1300,14 @@ static void init_startuptime(mparm_T *paramp)
 {
   for (int i = 1; i < paramp->argc - 1; i++) {
     if (STRICMP(paramp->argv[i], "--startuptime") == 0) {
-      time_fd = os_fopen(paramp->argv[i + 1], "a");
+      const char *fname = paramp->argv[i + 1];
+      const size_t len = strlen(fname);
+      if (len > 5 && STRICMP(fname + len - 5, ".json") == 0) {
+        // Structured trace instead of the text log, see trace.c.
+        trace_startup(fname);
+        break;
+      }
+      time_fd = os_fopen(fname, "a");
       time_start("--- NVIM STARTING ---");
       break;
     }
@@ -1363,8 +1382,6 @@ static void load_plugins(void)
 {
   if (p_lpl) {
     char_u *rtp_copy = NULL;
-    char_u *const plugin_pattern_vim = (char_u *)"plugin/**/*.vim";  // NOLINT
-    char_u *const plugin_pattern_lua = (char_u *)"plugin/**/*.lua";  // NOLINT
 
     // First add all package directories to 'runtimepath', so that their
     // autoload directories can be found.  Only if not done already with a
@@ -1376,12 +1393,8 @@ static void load_plugins(void)
       add_pack_start_dirs();
     }
 
-    source_in_path(rtp_copy == NULL ? p_rtp : rtp_copy,
-                   plugin_pattern_vim,
-                   DIP_ALL | DIP_NOAFTER);
-    source_in_path(rtp_copy == NULL ? p_rtp : rtp_copy,
-                   plugin_pattern_lua,
-                   DIP_ALL | DIP_NOAFTER);
+    source_plugins_in_path(rtp_copy == NULL ? p_rtp : rtp_copy,
+                           DIP_ALL | DIP_NOAFTER);
     TIME_MSG("loading plugins");
     xfree(rtp_copy);
 
@@ -1392,8 +1405,7 @@ static void load_plugins(void)
     }
     TIME_MSG("loading packages");
 
-    source_runtime(plugin_pattern_vim, DIP_ALL | DIP_AFTER);
-    source_runtime(plugin_pattern_lua, DIP_ALL | DIP_AFTER);
+    source_plugins_in_path(p_rtp, DIP_ALL | DIP_AFTER | DIP_START);
     TIME_MSG("loading after plugins");
   }
 }
@@ -20,6 +20,18 @@
 /// as long as it is locked. If it is no longer locked it can be swapped out to
 /// the file. It is only written to the file if it has been changed.
 ///
+/// The blocks in memory of all memfiles form a cache, limited by 'swapcache'.
+/// When it is exceeded, blocks are released with the clock algorithm: a hand
+/// goes around all blocks, clearing the reference bit set by mf_get() and
+/// releasing blocks which were not referenced since it last passed them.
+/// Only blocks of memfiles with a swap file can be released.
+///
+/// With MFS_ASYNC, mf_sync() copies the dirty blocks and hands them to a writer
+/// thread, which writes them to the swap file in the order they were queued.
+/// Blocks are marked clean right away, and dirty again when writing fails.
+/// Before the file is read, written directly, or closed, the pending write is
+/// waited for.
+///
 /// Under normal operation the file is created when opening the memory file and
 /// deleted when closing the memory file. Only with recovery an existing memory
 /// file is opened.
@@ -35,6 +47,7 @@
 /// mf_free()         remove a block
 /// mf_sync()         sync changed parts of memfile to disk
 /// mf_release_all()  release as much memory as possible
+/// mf_cache_trim()   release blocks until 'swapcache' is not exceeded
 /// mf_trans_del()    may translate negative to positive block number
 /// mf_fullname()     make file name full path (use before first :cd)
 
@@ -44,6 +57,7 @@
 #include <string.h>
 #include <stdbool.h>
 #include <fcntl.h>
+#include <uv.h>
 
 #include "nvim/vim.h"
 #include "nvim/ascii.h"
@@ -52,14 +66,60 @@
 #include "nvim/memline.h"
 #include "nvim/message.h"
 #include "nvim/memory.h"
+#include "nvim/option.h"
 #include "nvim/os_unix.h"
 #include "nvim/path.h"
 #include "nvim/assert.h"
+#include "nvim/lib/kvec.h"
 #include "nvim/os/os.h"
 #include "nvim/os/input.h"
+#include "nvim/trace.h"
 
 #define MEMFILE_PAGE_SIZE 4096       /// default page size
 
+/// Next block in the block cache clock to look at, NULL when it is empty.
+static bhdr_T *mf_clock_hand = NULL;
+/// Number of blocks in the block cache clock.
+static size_t mf_cache_count = 0;
+/// Bytes of memory used by the blocks in the block cache clock.
+static size_t mf_cache_bytes = 0;
+/// When mf_cache_trim() could not release enough blocks, it does not try again
+/// before this many bytes are used.
+static size_t mf_cache_retry_bytes = 0;
+/// Memfile of which mf_cache_trim() must not release blocks.
+static memfile_T *mf_cache_keep = NULL;
+
+/// Data to write at an offset of a swap file, see MfWriteJob.
+typedef struct {
+  off_T offset;     ///< Offset in the file.
+  size_t size;      ///< Number of bytes.
+  char *data;       ///< Copy of the block contents.
+  blocknr_T bnum;   ///< Block number, negative for filler data.
+} MfWritePiece;
+
+/// Writes of one mf_sync() call, done by the swap file writer thread.
+///
+/// Only "done" and "failed" are changed by the writer, with mf_writer_mutex
+/// held.
+typedef struct mf_write_job {
+  struct mf_write_job *next;        ///< Next job in the queue.
+  int fd;                           ///< Swap file descriptor.
+  kvec_t(MfWritePiece) pieces;      ///< Data to write.
+  bool fsync;                       ///< Sync the file after writing.
+  bool done;                        ///< The writer has finished.
+  bool failed;                      ///< Writing or syncing failed.
+} MfWriteJob;
+
+static bool mf_writer_started = false;
+static uv_thread_t mf_writer_thread;
+static uv_mutex_t mf_writer_mutex;
+static uv_cond_t mf_writer_cond;       ///< Signalled when a job is queued.
+static uv_cond_t mf_writer_done_cond;  ///< Signalled when a job is done.
+static MfWriteJob *mf_writer_first = NULL;  ///< Queue of jobs to do.
+static MfWriteJob *mf_writer_last = NULL;
+static size_t mf_writer_written = 0;   ///< Number of jobs written.
+/// Set by mf_writer_dying(): don't block on the writer anymore.
+static bool mf_writer_abandon = false;
 
 #ifdef INCLUDE_GENERATED_DECLARATIONS
 # include "memfile.c.generated.h"
@@ -97,6 +157,7 @@ memfile_T *mf_open(char_u *fname, int flags)
   mfp->mf_used_first = NULL;         // used list is empty
   mfp->mf_used_last = NULL;
   mfp->mf_dirty = false;
+  mfp->mf_write_job = NULL;
   mf_hash_init(&mfp->mf_hash);
   mf_hash_init(&mfp->mf_trans);
   mfp->mf_page_size = MEMFILE_PAGE_SIZE;
@@ -167,6 +228,7 @@ void mf_close(memfile_T *mfp, bool del_file)
   if (mfp == NULL) {                    // safety check
     return;
   }
+  mf_sync_wait(mfp);
   if (mfp->mf_fd >= 0 && close(mfp->mf_fd) < 0) {
       EMSG(_(e_swapclose));
   }
@@ -177,6 +239,7 @@ void mf_close(memfile_T *mfp, bool del_file)
   // free entries in used list
   for (bhdr_T *hp = mfp->mf_used_first, *nextp; hp != NULL; hp = nextp) {
     nextp = hp->bh_next;
+    mf_clock_rem(mfp, hp);
     mf_free_bhdr(hp);
   }
   while (mfp->mf_free_first != NULL) {  // free entries in free list
@@ -200,11 +263,14 @@ void mf_close_file(buf_T *buf, bool getlines)
 
   if (getlines) {
     // get all blocks in memory by accessing all lines (clumsy!)
+    mf_cache_keep = mfp;
     for (linenr_T lnum = 1; lnum <= buf->b_ml.ml_line_count; lnum++) {
       (void)ml_get_buf(buf, lnum, false);
     }
+    mf_cache_keep = NULL;
   }
 
+  mf_sync_wait(mfp);
   if (close(mfp->mf_fd) < 0) {           // close the file
     EMSG(_(e_swapclose));
   }
@@ -220,6 +286,10 @@ void mf_close_file(buf_T *buf, bool getlines)
 /// and the size it indicates differs from what was guessed.
 void mf_new_page_size(memfile_T *mfp, unsigned new_size)
 {
+  for (bhdr_T *hp = mfp->mf_used_first; hp != NULL; hp = hp->bh_next) {
+    mf_cache_bytes -= (size_t)mfp->mf_page_size * hp->bh_page_count;
+    mf_cache_bytes += (size_t)new_size * hp->bh_page_count;
+  }
   mfp->mf_page_size = new_size;
 }
 
@@ -271,6 +341,7 @@ bhdr_T *mf_new(memfile_T *mfp, bool negative, unsigned page_count)
   // This also avoids that the passwd file ends up in the swap file!
   (void)memset(hp->bh_data, 0, mfp->mf_page_size * page_count);
 
+  mf_cache_trim(false);
   return hp;
 }
 
@@ -302,15 +373,21 @@ bhdr_T *mf_get(memfile_T *mfp, blocknr_T nr, unsigned page_count)
       mf_free_bhdr(hp);
       return NULL;
     }
+    g_stats.memfile_cache_miss++;
+
+    hp->bh_flags |= BH_LOCKED;
+    mf_ins_used(mfp, hp);
+    mf_ins_hash(mfp, hp);
+    mf_cache_trim(false);
   } else {
-    mf_rem_used(mfp, hp);       // remove from list, insert in front below
+    g_stats.memfile_cache_hit++;
+    // The clock keeps the block while it is used, no need to move it in the
+    // used list.
+    hp->bh_flags |= BH_LOCKED | BH_REFERENCED;
     mf_rem_hash(mfp, hp);
+    mf_ins_hash(mfp, hp);       // put in front of hash list
   }
 
-  hp->bh_flags |= BH_LOCKED;
-  mf_ins_used(mfp, hp);         // put in front of used list
-  mf_ins_hash(mfp, hp);         // put in front of hash list
-
   return hp;
 }
 
@@ -358,6 +435,10 @@ void mf_free(memfile_T *mfp, bhdr_T *hp)
 ///               MFS_FLUSH  Make sure buffers are flushed to disk, so they will
 ///                          survive a system crash.
 ///               MFS_ZERO   Only write block 0.
+///               MFS_ASYNC  Copy the blocks and write them on the swap file
+///                          writer thread. Does nothing while a previous
+///                          write is in progress. Write errors are reported
+///                          later.
 ///
 /// @return FAIL  If failure. Possible causes:
 ///               - No file (nothing to do).
@@ -372,6 +453,19 @@ int mf_sync(memfile_T *mfp, int flags)
     return FAIL;
   }
 
+  MfWriteJob *job = NULL;
+  if (flags & MFS_ASYNC) {
+    mf_write_reap(mfp, false);
+    if (mfp->mf_write_job != NULL) {
+      // Still writing, the dirty blocks are written next time.
+      return OK;
+    }
+    job = xcalloc(1, sizeof(*job));
+    job->fd = mfp->mf_fd;
+  } else {
+    mf_sync_wait(mfp);
+  }
+
   // Only a CTRL-C while writing will break us here, not one typed previously.
   got_int = false;
 
@@ -388,12 +482,14 @@ int mf_sync(memfile_T *mfp, int flags)
                              && hp->bh_bnum < mfp->mf_infile_count))) {
       if ((flags & MFS_ZERO) && hp->bh_bnum != 0)
         continue;
-      if (mf_write(mfp, hp) == FAIL) {
+      if (mf_write(mfp, hp, job) == FAIL) {
         if (status == FAIL)     // double error: quit syncing
           break;
         status = FAIL;
       }
-      if (flags & MFS_STOP) {   // Stop when char available now.
+      if (job != NULL) {
+        // Copying is quick, no need to stop.
+      } else if (flags & MFS_STOP) {   // Stop when char available now.
         if (os_char_avail())
           break;
       } else {
@@ -408,7 +504,15 @@ int mf_sync(memfile_T *mfp, int flags)
   if (hp == NULL || status == FAIL)
     mfp->mf_dirty = false;
 
-  if (flags & MFS_FLUSH) {
+  if (job != NULL) {
+    job->fsync = (flags & MFS_FLUSH) != 0;
+    if (kv_size(job->pieces) == 0 && !job->fsync) {
+      mf_write_job_free(job);
+    } else {
+      mfp->mf_write_job = job;
+      mf_writer_queue(job);
+    }
+  } else if (flags & MFS_FLUSH) {
     if (os_fsync(mfp->mf_fd)) {
       status = FAIL;
     }
@@ -419,6 +523,217 @@ int mf_sync(memfile_T *mfp, int flags)
   return status;
 }
 
+/// Wait until blocks handed to the swap file writer by mf_sync() are written.
+void mf_sync_wait(memfile_T *mfp)
+{
+  mf_write_reap(mfp, true);
+}
+
+/// Finish the write of "mfp" by the swap file writer, if it is done. When it
+/// failed the blocks are marked dirty again.
+///
+/// @param wait  Wait for the writer to finish.
+static void mf_write_reap(memfile_T *mfp, bool wait)
+{
+  MfWriteJob *job = mfp->mf_write_job;
+  if (job == NULL) {
+    return;
+  }
+  if (mf_writer_abandon) {
+    mf_write_reap_dying(mfp, wait);
+    return;
+  }
+  uv_mutex_lock(&mf_writer_mutex);
+  while (wait && !job->done) {
+    uv_cond_wait(&mf_writer_done_cond, &mf_writer_mutex);
+  }
+  const bool done = job->done;
+  uv_mutex_unlock(&mf_writer_mutex);
+  if (!done) {
+    return;
+  }
+  mf_write_finish(mfp, job);
+}
+
+/// mf_write_reap() after mf_writer_dying(): never blocks on mf_writer_mutex or
+/// on a writer that may be stuck, e.g. on a hung file system. When waiting,
+/// poll for up to a second, then give up on the job and mark its blocks dirty,
+/// so that they are written directly.
+static void mf_write_reap_dying(memfile_T *mfp, bool wait)
+{
+  MfWriteJob *job = mfp->mf_write_job;
+  const uint64_t start = uv_hrtime();
+  bool done = false;
+  for (;;) {
+    if (uv_mutex_trylock(&mf_writer_mutex) == 0) {
+      done = job->done;
+      uv_mutex_unlock(&mf_writer_mutex);
+    }
+    if (done || !wait || uv_hrtime() - start > 1000000000u) {
+      break;
+    }
+  }
+  if (done) {
+    mf_write_finish(mfp, job);
+  } else if (wait) {
+    // The writer still owns the job, it is not freed.
+    mfp->mf_write_job = NULL;
+    mf_write_redirty(mfp, job);
+  }
+}
+
+/// Mark the blocks written by "job" dirty again.
+static void mf_write_redirty(memfile_T *mfp, const MfWriteJob *job)
+{
+  for (size_t i = 0; i < kv_size(job->pieces); i++) {
+    const blocknr_T bnum = kv_A(job->pieces, i).bnum;
+    bhdr_T *hp = bnum >= 0 ? mf_find_hash(mfp, bnum) : NULL;
+    if (hp != NULL) {
+      hp->bh_flags |= BH_DIRTY;
+      mfp->mf_dirty = true;
+    }
+  }
+}
+
+/// Handle the end of a job written by the swap file writer and free it.
+static void mf_write_finish(memfile_T *mfp, MfWriteJob *job)
+{
+  mfp->mf_write_job = NULL;
+  if (job->failed) {
+    mf_write_redirty(mfp, job);
+    if (!did_swapwrite_msg) {
+      EMSG(_("E297: Write error in swap file"));
+    }
+    did_swapwrite_msg = true;
+  } else {
+    did_swapwrite_msg = false;
+  }
+  mf_write_job_free(job);
+}
+
+static void mf_write_job_free(MfWriteJob *job)
+{
+  for (size_t i = 0; i < kv_size(job->pieces); i++) {
+    xfree(kv_A(job->pieces, i).data);
+  }
+  kv_destroy(job->pieces);
+  xfree(job);
+}
+
+/// Stop blocking on the swap file writer: used by preserve_exit() after a
+/// deadly signal or when out of memory, where waiting could hang forever.
+void mf_writer_dying(void)
+{
+  mf_writer_abandon = true;
+}
+
+/// @return  number of jobs the swap file writer thread has written.
+size_t mf_writer_count(void)
+{
+  if (!mf_writer_started) {
+    return 0;
+  }
+  uv_mutex_lock(&mf_writer_mutex);
+  const size_t count = mf_writer_written;
+  uv_mutex_unlock(&mf_writer_mutex);
+  return count;
+}
+
+/// Hand a job to the swap file writer thread, starting it if needed.
+static void mf_writer_queue(MfWriteJob *job)
+{
+  if (!mf_writer_started) {
+    uv_mutex_init(&mf_writer_mutex);
+    uv_cond_init(&mf_writer_cond);
+    uv_cond_init(&mf_writer_done_cond);
+    if (uv_thread_create(&mf_writer_thread, mf_writer_main, NULL) != 0) {
+      abort();
+    }
+    mf_writer_started = true;
+  }
+  uv_mutex_lock(&mf_writer_mutex);
+  if (mf_writer_last == NULL) {
+    mf_writer_first = job;
+  } else {
+    mf_writer_last->next = job;
+  }
+  mf_writer_last = job;
+  uv_cond_signal(&mf_writer_cond);
+  uv_mutex_unlock(&mf_writer_mutex);
+}
+
+/// Swap file writer thread: writes queued jobs in order.
+///
+/// Runs on its own thread: only use thread-safe functions here.
+static void mf_writer_main(void *arg)
+{
+  uv_loop_t loop;
+  if (uv_loop_init(&loop) != 0) {
+    abort();
+  }
+  uv_mutex_lock(&mf_writer_mutex);
+  for (;;) {
+    while (mf_writer_first == NULL) {
+      uv_cond_wait(&mf_writer_cond, &mf_writer_mutex);
+    }
+    MfWriteJob *job = mf_writer_first;
+    mf_writer_first = job->next;
+    if (mf_writer_first == NULL) {
+      mf_writer_last = NULL;
+    }
+    uv_mutex_unlock(&mf_writer_mutex);
+
+    const TraceSpan span = trace_begin();
+    const bool ok = mf_writer_do(&loop, job);
+    trace_end(span, "io", "swapfile", NULL);
+
+    uv_mutex_lock(&mf_writer_mutex);
+    job->failed = !ok;
+    job->done = true;
+    if (ok) {
+      mf_writer_written++;
+    }
+    uv_cond_broadcast(&mf_writer_done_cond);
+  }
+}
+
+/// Write the pieces of a job and sync the file if needed.
+///
+/// Runs on the swap file writer thread.
+///
+/// @return  false if writing or syncing failed.
+static bool mf_writer_do(uv_loop_t *loop, const MfWriteJob *job)
+{
+  uv_fs_t req;
+  for (size_t i = 0; i < kv_size(job->pieces); i++) {
+    const MfWritePiece *const piece = &kv_A(job->pieces, i);
+    size_t written = 0;
+    while (written < piece->size) {
+      uv_buf_t buf = uv_buf_init(piece->data + written,
+                                 (unsigned)(piece->size - written));
+      const int r = uv_fs_write(loop, &req, job->fd, &buf, 1,
+                                (int64_t)piece->offset + (int64_t)written,
+                                NULL);
+      uv_fs_req_cleanup(&req);
+      if (r == UV_EINTR || r == UV_EAGAIN) {
+        continue;
+      }
+      if (r <= 0) {
+        return false;
+      }
+      written += (size_t)r;
+    }
+  }
+  if (job->fsync) {
+    const int r = uv_fs_fsync(loop, &req, job->fd, NULL);
+    uv_fs_req_cleanup(&req);
+    if (r < 0 && r != UV_ENOTSUP && r != UV_EINVAL) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /// Set dirty flag for all blocks in memory file with a positive block number.
 /// These are blocks that need to be written to a newly created swapfile.
 void mf_set_dirty(memfile_T *mfp)
@@ -449,9 +764,11 @@ static bhdr_T *mf_find_hash(memfile_T *mfp, blocknr_T nr)
   return (bhdr_T *)mf_hash_find(&mfp->mf_hash, nr);
 }
 
-/// Insert block at the front of memfile's used list.
+/// Insert block at the front of memfile's used list and in the block cache
+/// clock.
 static void mf_ins_used(memfile_T *mfp, bhdr_T *hp)
 {
+  mf_clock_ins(mfp, hp);
   hp->bh_next = mfp->mf_used_first;
   mfp->mf_used_first = hp;
   hp->bh_prev = NULL;
@@ -462,9 +779,10 @@ static void mf_ins_used(memfile_T *mfp, bhdr_T *hp)
   }
 }
 
-/// Remove block from memfile's used list.
+/// Remove block from memfile's used list and the block cache clock.
 static void mf_rem_used(memfile_T *mfp, bhdr_T *hp)
 {
+  mf_clock_rem(mfp, hp);
   if (hp->bh_next == NULL)                 // last block in used list
     mfp->mf_used_last = hp->bh_prev;
   else
@@ -494,10 +812,11 @@ bool mf_release_all(void)
 
       // Flush as many blocks as possible, only if there is a swapfile.
       if (mfp->mf_fd >= 0) {
+        mf_sync_wait(mfp);
         for (bhdr_T *hp = mfp->mf_used_last; hp != NULL; ) {
           if (!(hp->bh_flags & BH_LOCKED)
               && (!(hp->bh_flags & BH_DIRTY)
-                  || mf_write(mfp, hp) != FAIL)) {
+                  || mf_write(mfp, hp, NULL) != FAIL)) {
             mf_rem_used(mfp, hp);
             mf_rem_hash(mfp, hp);
             mf_free_bhdr(hp);
@@ -513,6 +832,98 @@ bool mf_release_all(void)
   return retval;
 }
 
+/// Insert block in the block cache clock, just behind the hand: it is looked at
+/// last.
+static void mf_clock_ins(memfile_T *mfp, bhdr_T *hp)
+{
+  hp->bh_mfp = mfp;
+  hp->bh_flags |= BH_REFERENCED;
+  if (mf_clock_hand == NULL) {
+    hp->bh_clock_next = hp;
+    hp->bh_clock_prev = hp;
+    mf_clock_hand = hp;
+  } else {
+    hp->bh_clock_next = mf_clock_hand;
+    hp->bh_clock_prev = mf_clock_hand->bh_clock_prev;
+    hp->bh_clock_prev->bh_clock_next = hp;
+    mf_clock_hand->bh_clock_prev = hp;
+  }
+  mf_cache_count++;
+  mf_cache_bytes += (size_t)mfp->mf_page_size * hp->bh_page_count;
+}
+
+/// Remove block from the block cache clock.
+static void mf_clock_rem(memfile_T *mfp, bhdr_T *hp)
+{
+  if (hp->bh_clock_next == hp) {
+    mf_clock_hand = NULL;
+  } else {
+    if (mf_clock_hand == hp) {
+      mf_clock_hand = hp->bh_clock_next;
+    }
+    hp->bh_clock_prev->bh_clock_next = hp->bh_clock_next;
+    hp->bh_clock_next->bh_clock_prev = hp->bh_clock_prev;
+  }
+  mf_cache_count--;
+  mf_cache_bytes -= (size_t)mfp->mf_page_size * hp->bh_page_count;
+}
+
+/// Release blocks which were not used recently until the memory used by blocks
+/// of all memfiles is within 'swapcache'. Dirty blocks are written to the swap
+/// file first.
+///
+/// Locked blocks and blocks of memfiles without a swap file are kept, so the
+/// limit may still be exceeded. Then trying again is delayed until more memory
+/// is used, to avoid going around all blocks for every new one.
+///
+/// @param force  Try even if the previous attempt failed.
+void mf_cache_trim(bool force)
+{
+  const size_t limit = (size_t)p_swc * 1024;
+  if (p_swc <= 0 || mf_cache_bytes <= limit
+      || (!force && mf_cache_bytes < mf_cache_retry_bytes)) {
+    return;
+  }
+  // Every block may be passed twice: once to clear its reference bit and once
+  // to release it.
+  size_t todo = 2 * mf_cache_count;
+  while (mf_cache_bytes > limit && todo-- > 0) {
+    bhdr_T *hp = mf_clock_hand;
+    memfile_T *mfp = hp->bh_mfp;
+    mf_clock_hand = hp->bh_clock_next;
+    if ((hp->bh_flags & BH_LOCKED) || mfp->mf_fd < 0
+        || mfp == mf_cache_keep) {
+      continue;
+    }
+    // A clean block may still be written by the writer thread, and marked
+    // dirty again if that fails.
+    mf_write_reap(mfp, false);
+    if (mfp->mf_write_job != NULL) {
+      continue;
+    }
+    if (hp->bh_flags & BH_REFERENCED) {
+      hp->bh_flags &= ~BH_REFERENCED;
+      continue;
+    }
+    if ((hp->bh_flags & BH_DIRTY) && mf_write(mfp, hp, NULL) == FAIL) {
+      continue;
+    }
+    mf_rem_used(mfp, hp);
+    mf_rem_hash(mfp, hp);
+    mf_free_bhdr(hp);
+    g_stats.memfile_cache_evict++;
+  }
+  mf_cache_retry_bytes = (mf_cache_bytes > limit
+                          ? mf_cache_bytes + mf_cache_bytes / 8
+                          : 0);
+}
+
+/// Get the number of bytes of memory used by the blocks of all memfiles.
+size_t mf_cache_size(void)
+{
+  return mf_cache_bytes;
+}
+
 /// Allocate a block header and a block of memory for it.
 static bhdr_T *mf_alloc_bhdr(memfile_T *mfp, unsigned page_count)
 {
@@ -557,6 +968,8 @@ static int mf_read(memfile_T *mfp, bhdr_T *hp)
   if (mfp->mf_fd < 0)       // there is no file, can't read
     return FAIL;
 
+  mf_sync_wait(mfp);        // the block may not be written yet
+
   unsigned page_size = mfp->mf_page_size;
   // TODO(elmart): Check (page_size * hp->bh_bnum) within off_T bounds.
   off_T offset = (off_T)(page_size * hp->bh_bnum);
@@ -577,13 +990,16 @@ static int mf_read(memfile_T *mfp, bhdr_T *hp)
 
 /// Write a block to disk.
 ///
+/// @param job  When not NULL, add copies of the data to this job for the swap
+///             file writer thread instead of writing it.
+///
 /// @return  OK    On success.
 ///          FAIL  On failure. Could be:
 ///                - No file.
 ///                - Could not translate negative block number to positive.
 ///                - Seek error in swap file.
 ///                - Write error in swap file.
-static int mf_write(memfile_T *mfp, bhdr_T *hp)
+static int mf_write(memfile_T *mfp, bhdr_T *hp, MfWriteJob *job)
 {
   off_T offset;             // offset in the file
   blocknr_T nr;             // block nr which is being written
@@ -595,6 +1011,10 @@ static int mf_write(memfile_T *mfp, bhdr_T *hp)
   if (mfp->mf_fd < 0)       // there is no file, can't write
     return FAIL;
 
+  if (job == NULL) {        // must not be overwritten by the writer thread
+    mf_sync_wait(mfp);
+  }
+
   if (hp->bh_bnum < 0)      // must assign file block number
     if (mf_trans_add(mfp, hp) == FAIL)
       return FAIL;
@@ -616,17 +1036,23 @@ static int mf_write(memfile_T *mfp, bhdr_T *hp)
 
     // TODO(elmart): Check (page_size * nr) within off_T bounds.
     offset = (off_T)(page_size * nr);
-    if (vim_lseek(mfp->mf_fd, offset, SEEK_SET) != offset) {
-      PERROR(_("E296: Seek error in swap file write"));
-      return FAIL;
-    }
     if (hp2 == NULL)                // freed block, fill with dummy data
       page_count = 1;
     else
       page_count = hp2->bh_page_count;
     size = page_size * page_count;
     void *data = (hp2 == NULL) ? hp->bh_data : hp2->bh_data;
-    if ((unsigned)write_eintr(mfp->mf_fd, data, size) != size) {
+    if (job != NULL) {
+      kv_push(job->pieces, ((MfWritePiece) {
+        .offset = offset,
+        .size = size,
+        .data = xmemdup(data, size),
+        .bnum = hp2 == NULL ? -1 : nr,
+      }));
+    } else if (vim_lseek(mfp->mf_fd, offset, SEEK_SET) != offset) {
+      PERROR(_("E296: Seek error in swap file write"));
+      return FAIL;
+    } else if ((unsigned)write_eintr(mfp->mf_fd, data, size) != size) {
       /// Avoid repeating the error message, this mostly happens when the
       /// disk is full. We give the message again only after a successful
       /// write or when hitting a key. We keep on trying, in case some
@@ -635,8 +1061,9 @@ static int mf_write(memfile_T *mfp, bhdr_T *hp)
         EMSG(_("E297: Write error in swap file"));
       did_swapwrite_msg = true;
       return FAIL;
+    } else {
+      did_swapwrite_msg = false;
     }
-    did_swapwrite_msg = false;
     if (hp2 != NULL)                               // written a non-dummy block
       hp2->bh_flags &= ~BH_DIRTY;
     if (nr + (blocknr_T)page_count > mfp->mf_infile_count)  // appended to file
@@ -9,6 +9,7 @@
 #define MFS_STOP        2       /// stop syncing when a character is available
 #define MFS_FLUSH       4       /// flushed file to disk
 #define MFS_ZERO        8       /// only write block 0
+#define MFS_ASYNC       16      /// write on the swap file writer thread
 
 #ifdef INCLUDE_GENERATED_DECLARATIONS
 # include "memfile.h.generated.h"
@@ -54,8 +54,11 @@ typedef struct mf_hashtab {
 /// The block may be linked in the used list OR in the free list.
 /// The used blocks are also kept in hash lists.
 ///
-/// The used list is a doubly linked list, most recently used block first.
+/// The used list is a doubly linked list, most recently added block first.
 /// The blocks in the used list have a block of memory allocated.
+/// The used blocks of all memfiles are also in the block cache clock, a
+/// circular list used to choose blocks to release when 'swapcache' is
+/// exceeded.
 /// The hash lists are used to quickly find a block in the used list.
 /// The free list is a single linked list, not sorted.
 /// The blocks in the free list have no block of memory allocated and
@@ -66,12 +69,16 @@ typedef struct bhdr {
 
   struct bhdr *bh_next;              /// next block header in free or used list
   struct bhdr *bh_prev;              /// previous block header in used list
+  struct bhdr *bh_clock_next;        /// next block in the block cache clock
+  struct bhdr *bh_clock_prev;        /// previous block in the block cache clock
+  struct memfile *bh_mfp;            /// memfile of a used block
   void *bh_data;                     /// pointer to memory (for used block)
   unsigned bh_page_count;            /// number of pages in this block
 
 #define BH_DIRTY    1U
 #define BH_LOCKED   2U
-  unsigned bh_flags;                 // BH_DIRTY or BH_LOCKED
+#define BH_REFERENCED 4U             // used since the clock last passed it
+  unsigned bh_flags;                 // BH_DIRTY, BH_LOCKED or BH_REFERENCED
 } bhdr_T;
 
 /// A block number translation list item.
@@ -102,6 +109,8 @@ typedef struct memfile {
   blocknr_T mf_infile_count;         /// number of pages in the file
   unsigned mf_page_size;             /// number of bytes in a page
   bool mf_dirty;                      /// TRUE if there are dirty blocks
+  struct mf_write_job *mf_write_job;  /// blocks being written by the swap
+                                      /// file writer thread, or NULL
 } memfile_T;
 
 #endif  // NVIM_MEMFILE_DEFS_H
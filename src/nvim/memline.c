@@ -423,6 +423,7 @@ void ml_setname(buf_T *buf)
     }
     /* need to close the swap file before renaming */
     if (mfp->mf_fd >= 0) {
+      mf_sync_wait(mfp);
       close(mfp->mf_fd);
       mfp->mf_fd = -1;
     }
@@ -1696,7 +1697,8 @@ void ml_sync_all(int check_file, int check_char, bool do_fsync)
       }
     }
     if (buf->b_ml.ml_mfp->mf_dirty) {
-      (void)mf_sync(buf->b_ml.ml_mfp, (check_char ? MFS_STOP : 0)
+      // Waiting for a key: write in the background.
+      (void)mf_sync(buf->b_ml.ml_mfp, (check_char ? MFS_ASYNC : 0)
                     | (do_fsync && bufIsChanged(buf) ? MFS_FLUSH : 0));
       if (check_char && os_char_avail()) {      // character available now
         break;
@@ -1889,6 +1891,68 @@ errorret:
   return buf->b_ml.ml_line_ptr;
 }
 
+/// Get lines "lnum" up to "end" of "buf" like ml_get_buf(), but all the lines
+/// in the data block of "lnum" at once.  For reading many lines in order:
+/// the block is looked up once and the length of the lines is known from the
+/// block index, no strlen() is needed.
+///
+/// @param  max  Maximum number of lines to get, the size of "lines" and
+///              "lens".
+/// @param[out]  lines  Set to the text of the lines, "lines[0]" for "lnum".
+///                     Valid until the memline of "buf" is used again.
+/// @param[out]  lens  Set to the length of the lines, without the NUL.
+///
+/// A changed line that is not in its block yet is returned on its own.
+///
+/// @return  number of lines, at least one when "lnum" <= "end".
+int ml_get_block(buf_T *buf, linenr_T lnum, linenr_T end, int max,
+                 char_u **lines, size_t *lens)
+  FUNC_ATTR_NONNULL_ALL
+{
+  if (lnum > end || max <= 0) {
+    return 0;
+  }
+  // A changed line is not in its block yet. Don't flush it, a caller may
+  // still use the pointer ml_get_buf() returned for it.
+  const linenr_T changed = (buf->b_ml.ml_flags & ML_LINE_DIRTY)
+                           ? buf->b_ml.ml_line_lnum : 0;
+  if (changed == lnum) {
+    lines[0] = buf->b_ml.ml_line_ptr;
+    lens[0] = STRLEN(lines[0]);
+    return 1;
+  }
+  bhdr_T *hp = NULL;
+  if (lnum >= 1 && lnum <= buf->b_ml.ml_line_count
+      && buf->b_ml.ml_mfp != NULL) {
+    hp = ml_find_line(buf, lnum, ML_FIND);
+  }
+  if (hp == NULL) {
+    // Let ml_get_buf() deal with it and give the error message.
+    lines[0] = ml_get_buf(buf, lnum, false);
+    lens[0] = STRLEN(lines[0]);
+    return 1;
+  }
+
+  DATA_BL *const dp = hp->bh_data;
+  const int first = (int)(lnum - buf->b_ml.ml_locked_low);
+  if (changed > lnum && changed <= end) {
+    end = changed - 1;  // stop before the changed line
+  }
+  const int count = (int)MIN(MIN(end, buf->b_ml.ml_locked_high) - lnum + 1,
+                             max);
+  // The text of the lines is stored in reverse order: the text of a line is
+  // followed by the text of the previous line, the first one ends the block.
+  unsigned next = first == 0 ? dp->db_txt_end
+                             : (dp->db_index[first - 1] & DB_INDEX_MASK);
+  for (int i = 0; i < count; i++) {
+    const unsigned start = dp->db_index[first + i] & DB_INDEX_MASK;
+    lines[i] = (char_u *)dp + start;
+    lens[i] = next - start - 1;
+    next = start;
+  }
+  return count;
+}
+
 /*
  * Check if a line that was just obtained by a call to ml_get
  * is in allocated memory.
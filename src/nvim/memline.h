@@ -5,6 +5,9 @@
 #include "nvim/pos.h" // for pos_T, linenr_T, colnr_T
 #include "nvim/buffer_defs.h" // for buf_T
 
+/// Number of lines to get at once with ml_get_block().
+#define ML_GET_BLOCK_MAX 256
+
 #ifdef INCLUDE_GENERATED_DECLARATIONS
 # include "memline.h.generated.h"
 #endif
@@ -11,6 +11,7 @@
 #include "nvim/vim.h"
 #include "nvim/context.h"
 #include "nvim/eval.h"
+#include "nvim/hashtab.h"
 #include "nvim/highlight.h"
 #include "nvim/memfile.h"
 #include "nvim/memory.h"
@@ -41,14 +42,37 @@ MemRealloc mem_realloc = &realloc;
 bool entered_free_all_mem = false;
 #endif
 
+// Set on threads that run work for the main thread, see mem_worker_thread().
+static THREAD_LOCAL bool mem_in_worker = false;
+
+/// Marks the current thread as a worker thread.  When an allocation fails on
+/// it there is no attempt to free memory or preserve files, which can only be
+/// done by the main thread, Nvim aborts instead.
+void mem_worker_thread(void)
+{
+  mem_in_worker = true;
+}
+
+/// Gives the out-of-memory error and exits.
+static void mem_outofmem_exit(void)
+{
+  if (mem_in_worker) {
+    abort();
+  }
+  mch_errmsg(e_outofmem);
+  mch_errmsg("\n");
+  preserve_exit();
+}
+
 /// Try to free memory. Used when trying to recover from out of memory errors.
 /// @see {xmalloc}
 void try_to_free_memory(void)
 {
   static bool trying_to_free = false;
   // avoid recursive calls
-  if (trying_to_free)
+  if (trying_to_free || mem_in_worker) {
     return;
+  }
   trying_to_free = true;
 
   // free any scrollback text
@@ -106,9 +130,7 @@ void *xmalloc(size_t size)
 {
   void *ret = try_malloc(size);
   if (!ret) {
-    mch_errmsg(e_outofmem);
-    mch_errmsg("\n");
-    preserve_exit();
+    mem_outofmem_exit();
   }
   return ret;
 }
@@ -137,9 +159,7 @@ void *xcalloc(size_t count, size_t size)
     try_to_free_memory();
     ret = calloc(allocated_count, allocated_size);
     if (!ret) {
-      mch_errmsg(e_outofmem);
-      mch_errmsg("\n");
-      preserve_exit();
+      mem_outofmem_exit();
     }
   }
   return ret;
@@ -159,9 +179,7 @@ void *xrealloc(void *ptr, size_t size)
     try_to_free_memory();
     ret = realloc(ptr, allocated_size);
     if (!ret) {
-      mch_errmsg(e_outofmem);
-      mch_errmsg("\n");
-      preserve_exit();
+      mem_outofmem_exit();
     }
   }
   return ret;
@@ -546,9 +564,11 @@ void time_to_bytes(time_t time_, uint8_t buf[8])
 #include "nvim/regexp.h"
 #include "nvim/screen.h"
 #include "nvim/search.h"
+#include "nvim/shada.h"
 #include "nvim/spell.h"
 #include "nvim/syntax.h"
 #include "nvim/tag.h"
+#include "nvim/trace.h"
 #include "nvim/window.h"
 #include "nvim/os/os.h"
 #include "nvim/eval/typval.h"
@@ -673,6 +693,7 @@ void free_all_mem(void)
       break;
 
   eval_clear();
+  hash_intern_free_all();
   api_vim_free_all_mem();
   ctx_free_all();
 
@@ -701,6 +722,12 @@ void free_all_mem(void)
   decor_free_all_mem();
 
   nlua_free_all_mem();
+
+  // After everything which may hold a regprog was freed.
+  regcache_clear();
+
+  shada_free_all_mem();
+  trace_free_all_mem();
 }
 
 #endif
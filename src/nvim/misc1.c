@@ -31,6 +31,7 @@
 #include "nvim/buffer_updates.h"
 #include "nvim/main.h"
 #include "nvim/mbyte.h"
+#include "nvim/memfile.h"
 #include "nvim/memline.h"
 #include "nvim/memory.h"
 #include "nvim/message.h"
@@ -986,6 +987,7 @@ void preserve_exit(void)
   mch_errmsg("\n");
   ui_flush();
 
+  mf_writer_dying();                // don't block on the swap file writer
   ml_close_notmod();                // close all not-modified buffers
 
   FOR_ALL_BUFFERS(buf) {
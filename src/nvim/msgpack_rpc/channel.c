@@ -29,8 +29,10 @@
 #include "nvim/map.h"
 #include "nvim/log.h"
 #include "nvim/misc1.h"
+#include "nvim/latency.h"
 #include "nvim/lib/kvec.h"
 #include "nvim/os/input.h"
+#include "nvim/trace.h"
 #include "nvim/ui.h"
 
 #if MIN_LOG_LEVEL > DEBUG_LOG_LEVEL
@@ -381,7 +383,11 @@ static void request_event(void **argv)
     // channel was closed, abort any pending requests
     goto free_ret;
   }
+  const TraceSpan trace_span = trace_begin();
+  const LatencySpan latency_span = latency_begin(kLatencyRpc);
   Object result = handler.fn(channel->id, e->args, &error);
+  latency_end(&latency_span);
+  trace_end(trace_span, "rpc", handler.name, NULL);
   if (e->type == kMessageTypeRequest || ERROR_SET(&error)) {
     // Send the response.
     msgpack_packer response;
@@ -43,6 +43,7 @@
 #include "nvim/path.h"
 #include "nvim/screen.h"
 #include "nvim/search.h"
+#include "nvim/shada.h"
 #include "nvim/state.h"
 #include "nvim/strings.h"
 #include "nvim/terminal.h"
@@ -815,6 +816,7 @@ yankreg_T *get_yank_register(int regname, int mode)
 {
   yankreg_T *reg;
 
+  shada_load_registers();
   if (mode == YREG_PASTE && get_clipboard(regname, &reg, false)) {
     // reg is set to clipboard contents.
     return reg;
@@ -932,6 +934,7 @@ int do_record(int c)
        * We don't want to change the default register here, so save and
        * restore the current register name.
        */
+      shada_load_registers();
       old_y_previous = y_previous;
 
       retval = stuff_yank(regname, p);
@@ -1383,6 +1386,7 @@ bool cmdline_paste_reg(int regname, bool literally_arg, bool remcr)
 // Shift the delete registers: "9 is cleared, "8 becomes "9, etc.
 static void shift_delete_registers(bool y_append)
 {
+  shada_load_registers();
   free_register(&y_regs[9]);  // free register "9
   for (int n = 9; n > 1; n--) {
     y_regs[n] = y_regs[n - 1];
@@ -3592,6 +3596,7 @@ void ex_display(exarg_T *eap)
   if (arg != NULL && *arg == NUL)
     arg = NULL;
   int attr = HL_ATTR(HLF_8);
+  shada_load_registers();
 
   // Highlight title
   msg_puts_title(_("\nType Name Content"));
@@ -5275,6 +5280,7 @@ static yankreg_T *init_write_reg(int name, yankreg_T **old_y_previous, bool must
   }
 
   // Don't want to change the current (unnamed) register.
+  shada_load_registers();
   *old_y_previous = y_previous;
 
   yankreg_T *reg = get_yank_register(name, YREG_YANK);
@@ -6217,6 +6223,7 @@ const void *op_global_reg_iter(const void *const iter, char *const name,
                                yankreg_T *const reg, bool *is_unnamed)
   FUNC_ATTR_NONNULL_ARG(2, 3, 4) FUNC_ATTR_WARN_UNUSED_RESULT
 {
+  shada_load_registers();
   return op_reg_iter(iter, y_regs, name, reg, is_unnamed);
 }
 
@@ -6260,6 +6267,7 @@ const void *op_reg_iter(const void *const iter, const yankreg_T *const regs,
 size_t op_reg_amount(void)
   FUNC_ATTR_WARN_UNUSED_RESULT
 {
+  shada_load_registers();
   size_t ret = 0;
   for (size_t i = 0; i < NUM_SAVED_REGISTERS; i++) {
     if (!reg_empty(y_regs + i)) {
@@ -6278,6 +6286,7 @@ size_t op_reg_amount(void)
 /// @return true on success, false on failure.
 bool op_reg_set(const char name, const yankreg_T reg, bool is_unnamed)
 {
+  shada_load_registers();
   int i = op_reg_index(name);
   if (i == -1) {
     return false;
@@ -6298,6 +6307,7 @@ bool op_reg_set(const char name, const yankreg_T reg, bool is_unnamed)
 /// @return Pointer to the register contents or NULL.
 const yankreg_T *op_reg_get(const char name)
 {
+  shada_load_registers();
   int i = op_reg_index(name);
   if (i == -1) {
     return NULL;
@@ -6313,6 +6323,7 @@ const yankreg_T *op_reg_get(const char name)
 bool op_reg_set_previous(const char name)
   FUNC_ATTR_WARN_UNUSED_RESULT
 {
+  shada_load_registers();
   int i = op_reg_index(name);
   if (i == -1) {
     return false;
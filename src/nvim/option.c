@@ -4199,9 +4199,17 @@ static char *set_num_option(int opt_idx, char_u *varp, long value,
       errmsg = e_invarg;
     }
   } else if (pp == &p_re) {
-    if (value < 0 || value > 2) {
+    if (value < 0 || value > 3) {
       errmsg = e_invarg;
     }
+  } else if (pp == &p_vgp) {
+    if (value < 0) {
+      errmsg = e_positive;
+    }
+  } else if (pp == &p_swc) {
+    if (value < 0) {
+      errmsg = e_positive;
+    }
   } else if (pp == &p_report) {
     if (value < 0) {
       errmsg = e_positive;
@@ -4365,6 +4373,8 @@ static char *set_num_option(int opt_idx, char_u *varp, long value,
     if (p_uc && !old_value) {
       ml_open_files();
     }
+  } else if (pp == &p_swc) {
+    mf_cache_trim(true);
   } else if (pp == &p_pb) {
     p_pb = MAX(MIN(p_pb, 100), 0);
     hl_invalidate_blends();
@@ -642,6 +642,7 @@ EXTERN char_u   *p_sps;         // 'spellsuggest'
 EXTERN int p_spr;               // 'splitright'
 EXTERN int p_sol;               // 'startofline'
 EXTERN char_u   *p_su;          // 'suffixes'
+EXTERN long p_swc;              // 'swapcache'
 EXTERN char_u   *p_swb;         // 'switchbuf'
 EXTERN unsigned swb_flags;
 #ifdef IN_OPTION_C
@@ -694,6 +695,7 @@ EXTERN char *p_shadafile;       ///< 'shadafile'
 EXTERN char_u *p_vdir;          ///< 'viewdir'
 EXTERN char_u *p_vop;           ///< 'viewoptions'
 EXTERN unsigned vop_flags;      ///< uses SSOP_ flags
+EXTERN long p_vgp;              ///< 'vimgrepprefetch'
 EXTERN int p_vb;                ///< 'visualbell'
 EXTERN char_u *p_ve;            ///< 'virtualedit'
 EXTERN unsigned ve_flags;
@@ -734,6 +736,7 @@ EXTERN long p_wiw;              // 'winwidth'
 EXTERN int p_ws;                // 'wrapscan'
 EXTERN int p_write;             // 'write'
 EXTERN int p_wa;                // 'writeany'
+EXTERN int p_wbg;               // 'writebackground'
 EXTERN int p_wb;                // 'writebackup'
 EXTERN long p_wd;               // 'writedelay'
 
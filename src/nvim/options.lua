@@ -2681,6 +2681,14 @@ return {
       varname='p_sua',
       defaults={if_true={vi=""}}
     },
+    {
+      full_name='swapcache', abbreviation='swc',
+      short_desc=N_("maximum memory (in Kbyte) used for buffer text"),
+      type='number', scope={'global'},
+      vi_def=true,
+      varname='p_swc',
+      defaults={if_true={vi=0}}
+    },
     {
       full_name='swapfile', abbreviation='swf',
       short_desc=N_("whether to use a swapfile for a buffer"),
@@ -3060,6 +3068,14 @@ return {
       varname='p_vop',
       defaults={if_true={vi="folds,options,cursor,curdir"}}
     },
+    {
+      full_name='vimgrepprefetch', abbreviation='vgp',
+      short_desc=N_("number of files :vimgrep reads in advance"),
+      type='number', scope={'global'},
+      vi_def=true,
+      varname='p_vgp',
+      defaults={if_true={vi=32}}
+    },
     {
       -- Alias for "shada".
       full_name='viminfo', abbreviation='vi',
@@ -3287,6 +3303,14 @@ return {
       varname='p_wa',
       defaults={if_true={vi=false}}
     },
+    {
+      full_name='writebackground', abbreviation='wbg',
+      short_desc=N_("write files in the background with \":write\""),
+      type='bool', scope={'global'},
+      vi_def=true,
+      varname='p_wbg',
+      defaults={if_true={vi=false}}
+    },
     {
       full_name='writebackup', abbreviation='wb',
       short_desc=N_("make a backup before overwriting a file"),
@@ -730,6 +730,19 @@ int os_fsync(int fd)
   return r;
 }
 
+/// Truncates or extends a file to the given size.
+///
+/// @param fd the file descriptor of the file.
+/// @param size new size of the file in bytes.
+///
+/// @return 0 on success, or libuv error code on failure.
+int os_ftruncate(int fd, uint64_t size)
+{
+  int r;
+  RUN_UV_FS_FUNC(r, uv_fs_ftruncate, fd, (int64_t)size, NULL);
+  return r;
+}
+
 /// Get stat information for a file.
 ///
 /// @return libuv return code, or -errno
@@ -982,6 +995,18 @@ const char *os_scandir_next(Directory *dir)
   return err != UV_EOF ? dir->ent.name : NULL;
 }
 
+/// Gets the type of the entry last returned by `os_scandir_next()`.
+///
+/// @param dir  The Directory object.
+/// @returns UV_DIRENT_DIR or UV_DIRENT_FILE, or another type when it needs to
+///          be checked with `os_isdir()` (links, or when the file system does
+///          not report types).
+uv_dirent_type_t os_scandir_type(const Directory *dir)
+  FUNC_ATTR_NONNULL_ALL FUNC_ATTR_PURE FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  return dir->ent.type;
+}
+
 /// Frees memory associated with `os_scandir()`.
 /// @param dir  The directory.
 void os_closedir(Directory *dir)
@@ -16,6 +16,7 @@
 #include "nvim/ui.h"
 #include "nvim/memory.h"
 #include "nvim/keymap.h"
+#include "nvim/latency.h"
 #include "nvim/mbyte.h"
 #include "nvim/fileio.h"
 #include "nvim/ex_cmds2.h"
@@ -24,6 +25,7 @@
 #include "nvim/misc1.h"
 #include "nvim/state.h"
 #include "nvim/msgpack_rpc/channel.h"
+#include "nvim/os/time.h"
 
 #define READ_BUFFER_SIZE 0xfff
 #define INPUT_BUFFER_SIZE (READ_BUFFER_SIZE * 4)
@@ -197,6 +199,8 @@ bool os_isatty(int fd)
 
 size_t input_enqueue(String keys)
 {
+  const LatencySpan span = latency_begin(kLatencyInput);
+  latency_input_queued();
   char *ptr = keys.data;
   char *end = ptr + keys.size;
 
@@ -249,6 +253,7 @@ size_t input_enqueue(String keys)
 
   size_t rv = (size_t)(ptr - keys.data);
   process_interrupts();
+  latency_end(&span);
   return rv;
 }
 
@@ -412,8 +417,10 @@ static InbufPollResult inbuf_poll(int ms, MultiQueue *events)
   }
   DLOG("blocking... events_enabled=%d events_pending=%d", events != NULL,
        events && !multiqueue_empty(events));
+  const uint64_t wait_start = os_hrtime();
   LOOP_PROCESS_EVENTS_UNTIL(&main_loop, NULL, ms,
                             input_ready(events) || input_eof);
+  latency_wait(os_hrtime() - wait_start);
   blocking = false;
 
   if (do_profiling == PROF_YES && ms) {
@@ -444,11 +451,16 @@ static void input_read_cb(Stream *stream, RBuffer *buf, size_t c, void *data,
     input_done();
   }
 
+  const LatencySpan span = latency_begin(kLatencyInput);
+  if (rbuffer_size(buf) > 0) {
+    latency_input_queued();
+  }
   assert(rbuffer_space(input_buffer) >= rbuffer_size(buf));
   RBUFFER_UNTIL_EMPTY(buf, ptr, len) {
     (void)rbuffer_write(input_buffer, ptr, len);
     rbuffer_consumed(buf, len);
   }
+  latency_end(&span);
 }
 
 static void process_interrupts(void)
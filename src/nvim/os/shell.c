@@ -1101,44 +1101,29 @@ static size_t word_length(const char_u *str)
 /// before we finish writing.
 static void read_input(DynamicBuffer *buf)
 {
-  size_t written = 0, l = 0, len = 0;
   linenr_T lnum = curbuf->b_op_start.lnum;
-  char_u *lp = ml_get(lnum);
-
-  for (;;) {
-    l = strlen((char *)lp + written);
-    if (l == 0) {
-      len = 0;
-    } else if (lp[written] == NL) {
-      // NL -> NUL translation
-      len = 1;
-      dynamic_buffer_ensure(buf, buf->len + len);
-      buf->data[buf->len++] = NUL;
-    } else {
-      char_u  *s = vim_strchr(lp + written, NL);
-      len = s == NULL ? l : (size_t)(s - (lp + written));
-      dynamic_buffer_ensure(buf, buf->len + len);
-      memcpy(buf->data + buf->len, lp + written, len);
-      buf->len += len;
-    }
+  const linenr_T end = curbuf->b_op_end.lnum;
+
+  while (lnum <= end) {
+    // Get all the lines of a data block at once.
+    char_u *lines[ML_GET_BLOCK_MAX];
+    size_t lens[ML_GET_BLOCK_MAX];
+    const int count = ml_get_block(curbuf, lnum, end, ML_GET_BLOCK_MAX,
+                                   lines, lens);
+    for (int i = 0; i < count; i++, lnum++) {
+      dynamic_buffer_ensure(buf, buf->len + lens[i] + 1);
+      char *const p = buf->data + buf->len;
+      memcpy(p, lines[i], lens[i]);
+      memchrsub(p, NL, NUL, lens[i]);  // NL -> NUL translation
+      buf->len += lens[i];
 
-    if (len == l) {
       // Finished a line, add a NL, unless this line should not have one.
-      if (lnum != curbuf->b_op_end.lnum
+      if (lnum != end
           || (!curbuf->b_p_bin && curbuf->b_p_fixeol)
           || (lnum != curbuf->b_no_eol_lnum
               && (lnum != curbuf->b_ml.ml_line_count || curbuf->b_p_eol))) {
-        dynamic_buffer_ensure(buf, buf->len + 1);
         buf->data[buf->len++] = NL;
       }
-      ++lnum;
-      if (lnum > curbuf->b_op_end.lnum) {
-        break;
-      }
-      lp = ml_get(lnum);
-      written = 0;
-    } else if (len > 0) {
-      written += len;
     }
   }
 }
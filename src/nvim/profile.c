@@ -290,3 +290,17 @@ void time_msg(const char *mesg, const proftime_T *start)
   g_prev_time = now;
   fprintf(time_fd, ": %s\n", mesg);
 }
+
+/// Prints details of the previous time_msg() message.
+///
+/// Printed without timing columns, does not reset the "elapsed" time.
+///
+/// @param mesg the details to display, times in msec
+void time_msg_detail(const char *mesg)
+{
+  if (time_fd == NULL) {
+    return;
+  }
+
+  fprintf(time_fd, "%27s%s\n", "", mesg);
+}
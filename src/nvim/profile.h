@@ -4,10 +4,13 @@
 #include <stdint.h>
 #include <time.h>
 
+#include "nvim/trace.h"
+
 typedef uint64_t proftime_T;
 
 #define TIME_MSG(s) do { \
     if (time_fd != NULL) time_msg(s, NULL); \
+    trace_phase(s); \
   } while (0)
 
 #ifdef INCLUDE_GENERATED_DECLARATIONS
@@ -39,6 +39,7 @@
 #include "nvim/search.h"
 #include "nvim/strings.h"
 #include "nvim/syntax.h"
+#include "nvim/trace.h"
 #include "nvim/ui.h"
 #include "nvim/window.h"
 #include "nvim/os/os.h"
@@ -205,6 +206,39 @@ typedef struct {
   bool   valid;
 } qffields_T;
 
+typedef struct vgr_prefetch VgrPrefetch;
+
+/// File read in advance for ":vimgrep", see vgr_prefetch_start().
+typedef struct {
+  uv_work_t work;       ///< Reads the file on a worker thread.
+  VgrPrefetch *pf;
+  char *fname;          ///< Full file name.
+  char *data;           ///< File contents, allocated with malloc().
+  char_u **lines;       ///< Lines in "data", allocated with malloc().
+  linenr_T nlines;      ///< Number of lines.
+  size_t reserved;      ///< Bytes taken from "pf->avail".
+  regmmatch_T regmatch;  ///< Copy of the pattern for the worker, or NULL.
+  uint8_t *result;      ///< RegParResult for each line, or NULL.
+  bool ok;              ///< Whether the file can be searched without loading.
+  bool done;            ///< Whether the worker has finished.
+} VgrFile;
+
+/// Reading files in advance for ":vimgrep".
+struct vgr_prefetch {
+  uv_loop_t loop;         ///< Loop used to wait for the workers.
+  uv_mutex_t mutex;       ///< Protects "avail".
+  size_t avail;           ///< Bytes the workers may still allocate.
+  regmmatch_T *regmatch;  ///< Pattern searched for.
+  buf_T *buf;             ///< Copy of 'iskeyword' of the current buffer.
+  VgrFile **files;        ///< Files being read, indexed like the names.
+  int next;               ///< Index of the next file to read.
+};
+
+/// Files larger than this are loaded into a buffer for ":vimgrep".
+#define VGR_PREFETCH_MAX_SIZE (64 * 1024 * 1024)
+/// Maximum number of bytes held by the files read in advance.
+#define VGR_PREFETCH_MAX_TOTAL (128 * 1024 * 1024)
+
 #ifdef INCLUDE_GENERATED_DECLARATIONS
 # include "quickfix.c.generated.h"
 #endif
@@ -5294,6 +5328,322 @@ static bool vgr_match_buflines(qf_list_T *qfl, char_u *fname, buf_T *buf,
   return found_match;
 }
 
+/// Check whether files read by vgr_prefetch_start() can be searched as they
+/// are: reading them into a buffer would not change the text.  Files with a
+/// BOM, a CR or illegal bytes are not used, the global options must allow
+/// "unix" file format and UTF-8.
+static bool vgr_prefetch_usable(void)
+{
+  if (strstr((char *)p_ffs, "unix") == NULL) {
+    return false;
+  }
+  const char *p = (char *)p_fencs;
+  if (STRNCMP(p, "ucs-bom", 7) == 0 && (p[7] == ',' || p[7] == NUL)) {
+    p += p[7] == ',' ? 8 : 7;
+  }
+  return *p == NUL
+         || (STRNCMP(p, "utf-8", 5) == 0 && (p[5] == ',' || p[5] == NUL))
+         || (STRNCMP(p, "utf8", 4) == 0 && (p[4] == ',' || p[4] == NUL));
+}
+
+/// Check whether file "fname" can be searched without loading it into a
+/// buffer: that would not trigger any autocommands.  The "filetypedetect"
+/// autocommands are ignored, they only set 'filetype' and FileType is not
+/// triggered for ":vimgrep" anyway, see vgr_load_dummy_buf().
+static bool vgr_no_autocmds(char_u *fname)
+{
+  static const event_T events[] = {
+    EVENT_BUFNEW, EVENT_BUFREADCMD, EVENT_BUFREADPRE, EVENT_BUFREADPOST,
+    EVENT_SWAPEXISTS, EVENT_BUFUNLOAD, EVENT_BUFDELETE, EVENT_BUFWIPEOUT,
+  };
+  for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+    if (has_autocmd_except(events[i], fname, NULL, "filetypedetect")) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Split the contents of a file read by a worker into lines, the way
+/// readfile() would store them in a buffer.
+///
+/// Runs on a worker thread: only use thread-safe functions here.
+///
+/// @return false if the file has a BOM, a CR or illegal bytes.
+static bool vgr_prefetch_split(VgrFile *vf, size_t size)
+{
+  char *const data = vf->data;
+  if (size >= 3 && memcmp(data, "\xef\xbb\xbf", 3) == 0) {
+    return false;
+  }
+  size_t nlines = 1;
+  for (size_t i = 0; i < size; i++) {
+    const uint8_t c = (uint8_t)data[i];
+    if (c == '\n') {
+      nlines++;
+    } else if (c == '\r') {
+      return false;
+    } else if (c >= 0x80) {
+      const int l = utf_ptr2len_len((char_u *)data + i, (int)(size - i));
+      if (l == 1 || (size_t)l > size - i) {
+        return false;
+      }
+      i += (size_t)l - 1;
+    }
+  }
+  // A line break at the end doesn't start another line.
+  if (size > 0 && data[size - 1] == '\n') {
+    nlines--;
+  }
+  if (nlines > MAXLNUM
+      || !vgr_prefetch_reserve(vf, nlines * (sizeof(*vf->lines) + 1))) {
+    return false;
+  }
+  vf->lines = malloc(nlines * sizeof(*vf->lines));
+  if (vf->lines == NULL) {
+    return false;
+  }
+  data[size] = NUL;
+  vf->lines[0] = (char_u *)data;
+  vf->nlines = 1;
+  for (size_t i = 0; i < size; i++) {
+    if (data[i] == '\n') {
+      data[i] = NUL;
+      if ((size_t)vf->nlines < nlines) {
+        vf->lines[vf->nlines++] = (char_u *)data + i + 1;
+      }
+    } else if (data[i] == NUL) {
+      data[i] = '\n';  // NUL is stored as NL
+    }
+  }
+  return true;
+}
+
+/// Take "size" bytes from the memory the workers may use.
+///
+/// Runs on a worker thread.
+static bool vgr_prefetch_reserve(VgrFile *vf, size_t size)
+{
+  VgrPrefetch *const pf = vf->pf;
+  bool ok = false;
+  uv_mutex_lock(&pf->mutex);
+  if (pf->avail >= size) {
+    pf->avail -= size;
+    vf->reserved += size;
+    ok = true;
+  }
+  uv_mutex_unlock(&pf->mutex);
+  return ok;
+}
+
+static void vgr_prefetch_work(uv_work_t *req)
+{
+  VgrFile *const vf = req->data;
+  const TraceSpan span = trace_begin();
+  // Runs on a worker thread: only use thread-safe functions here.
+  mem_worker_thread();
+  FILE *const fp = fopen(vf->fname, READBIN);
+  if (fp == NULL) {
+    return;
+  }
+  size_t size = 0;
+  size_t cap = 0;
+  for (;;) {
+    if (size == cap) {
+      if (cap >= VGR_PREFETCH_MAX_SIZE) {
+        break;
+      }
+      const size_t newcap = cap == 0 ? 64 * 1024 : cap * 2;
+      if (!vgr_prefetch_reserve(vf, newcap - cap)) {
+        break;
+      }
+      char *const p = realloc(vf->data, newcap + 1);
+      if (p == NULL) {
+        break;
+      }
+      vf->data = p;
+      cap = newcap;
+    }
+    const size_t n = fread(vf->data + size, 1, cap - size, fp);
+    if (n == 0) {
+      break;
+    }
+    size += n;
+  }
+  vf->ok = vf->data != NULL && feof(fp) && !ferror(fp)
+           && vgr_prefetch_split(vf, size);
+  fclose(fp);
+  trace_end(span, "io", "vimgrep", vf->fname);
+
+  // Find out which lines match, only those are matched again.
+  if (vf->ok && vf->regmatch.regprog != NULL) {
+    vf->result = malloc((size_t)vf->nlines);
+    if (vf->result != NULL) {
+      const TraceSpan mspan = trace_begin();
+      vim_regexec_worker(&vf->regmatch, vf->pf->buf, vf->lines, vf->nlines,
+                         vf->result);
+      trace_end(mspan, "regexp", "vimgrep", vf->fname);
+    }
+  }
+}
+
+static void vgr_prefetch_after_work(uv_work_t *req, int status)
+{
+  ((VgrFile *)req->data)->done = true;
+}
+
+/// Prepare for reading the "fcount" files of ":vimgrep" in advance and
+/// searching them for "regmatch" on worker threads.
+///
+/// @return NULL if that is not possible.
+static VgrPrefetch *vgr_prefetch_init(int fcount, regmmatch_T *regmatch)
+{
+  VgrPrefetch *const pf = xcalloc(1, sizeof(*pf));
+  if (uv_loop_init(&pf->loop) != 0) {
+    xfree(pf);
+    return NULL;
+  }
+  uv_mutex_init(&pf->mutex);
+  pf->avail = VGR_PREFETCH_MAX_TOTAL;
+  pf->regmatch = regmatch;
+  // The current buffer may change while the workers use 'iskeyword'.
+  pf->buf = xcalloc(1, sizeof(buf_T));
+  memcpy(pf->buf->b_chartab, curbuf->b_chartab, sizeof(curbuf->b_chartab));
+  pf->files = xcalloc((size_t)fcount, sizeof(*pf->files));
+  return pf;
+}
+
+/// Stop reading files in advance and free "pf".
+static void vgr_prefetch_end(VgrPrefetch *pf)
+{
+  for (int i = 0; i < pf->next; i++) {
+    vgr_prefetch_free(pf->files[i]);
+  }
+  uv_loop_close(&pf->loop);
+  uv_mutex_destroy(&pf->mutex);
+  xfree(pf->buf);
+  xfree(pf->files);
+  xfree(pf);
+}
+
+/// Start reading files in the background, to have "p_vgp" files after
+/// "fnames[fi]" read in advance.
+static void vgr_prefetch_start(VgrPrefetch *pf, char_u **fnames, int fcount,
+                               int fi)
+{
+  while (pf->next < fcount && pf->next <= fi + p_vgp) {
+    VgrFile *const vf = xcalloc(1, sizeof(*vf));
+    vf->pf = pf;
+    vf->fname = fix_fname((char *)fnames[pf->next]);
+    vf->regmatch.regprog = vim_regdup_worker(pf->regmatch->regprog);
+    vf->regmatch.rmm_ic = pf->regmatch->rmm_ic;
+    vf->regmatch.rmm_maxcol = pf->regmatch->rmm_maxcol;
+    vf->work.data = vf;
+    if (uv_queue_work(&pf->loop, &vf->work, vgr_prefetch_work,
+                      vgr_prefetch_after_work) != 0) {
+      vf->done = true;
+      vgr_prefetch_free(vf);
+    } else {
+      pf->files[pf->next] = vf;
+    }
+    pf->next++;
+  }
+}
+
+/// Wait for the worker of "vf" and free it.
+static void vgr_prefetch_free(VgrFile *vf)
+{
+  if (vf == NULL) {
+    return;
+  }
+  VgrPrefetch *const pf = vf->pf;
+  while (!vf->done) {
+    uv_run(&pf->loop, UV_RUN_ONCE);
+  }
+  uv_mutex_lock(&pf->mutex);
+  pf->avail += vf->reserved;
+  uv_mutex_unlock(&pf->mutex);
+  free(vf->result);
+  free(vf->lines);
+  free(vf->data);
+  vim_regfree(vf->regmatch.regprog);
+  xfree(vf->fname);
+  xfree(vf);
+}
+
+/// Take file "fi" read by vgr_prefetch_start().  Waits for it to be read.
+///
+/// @return NULL if the file was not read or can't be used as it is.
+static VgrFile *vgr_prefetch_take(VgrPrefetch *pf, int fi)
+{
+  VgrFile *const vf = pf->files[fi];
+  if (vf == NULL) {
+    return NULL;
+  }
+  pf->files[fi] = NULL;
+  while (!vf->done) {
+    uv_run(&pf->loop, UV_RUN_ONCE);
+  }
+  if (!vf->ok) {
+    vgr_prefetch_free(vf);
+    return NULL;
+  }
+  return vf;
+}
+
+/// Search for a pattern in all the lines of a file read by
+/// vgr_prefetch_start() and add the matching lines to a quickfix list.
+static bool vgr_match_lines(qf_list_T *qfl, char_u *fname, VgrFile *vf,
+                            regmmatch_T *regmatch, long *tomatch, int flags)
+  FUNC_ATTR_NONNULL_ALL
+{
+  bool found_match = false;
+
+  for (linenr_T lnum = 1; lnum <= vf->nlines && *tomatch > 0; lnum++) {
+    if (vf->result != NULL && vf->result[lnum - 1] == kRegParNoMatch) {
+      continue;
+    }
+    colnr_T col = 0;
+    while (vim_regexec_lines(regmatch, vf->lines, vf->nlines, lnum, col) > 0) {
+      const linenr_T mlnum = regmatch->startpos[0].lnum + lnum;
+      if (qf_add_entry(qfl,
+                       NULL,  // dir
+                       fname,
+                       NULL,
+                       0,     // bufnum
+                       vf->lines[mlnum - 1],
+                       mlnum,
+                       regmatch->startpos[0].col + 1,
+                       false,  // vis_col
+                       NULL,   // search pattern
+                       0,      // nr
+                       0,      // type
+                       true)    // valid
+          == QF_FAIL) {
+        got_int = true;
+        break;
+      }
+      found_match = true;
+      if (--*tomatch == 0) {
+        break;
+      }
+      if ((flags & VGR_GLOBAL) == 0 || regmatch->endpos[0].lnum > 0) {
+        break;
+      }
+      col = regmatch->endpos[0].col + (col == regmatch->endpos[0].col);
+      if (col > (colnr_T)STRLEN(vf->lines[lnum - 1])) {
+        break;
+      }
+    }
+    line_breakcheck();
+    if (got_int) {
+      break;
+    }
+  }
+
+  return found_match;
+}
+
 /// Jump to the first match and update the directory.
 static void vgr_jump_to_match(qf_info_T *qi, int forceit, int *redraw_for_dummy,
                               buf_T *first_match_buf, char_u *target_dir)
@@ -5359,6 +5709,7 @@ void ex_vimgrep(exarg_T *eap)
   char_u      *dirname_now = NULL;
   char_u      *target_dir = NULL;
   char_u      *au_name =  NULL;
+  VgrPrefetch *prefetch = NULL;
 
   au_name = vgr_get_auname(eap->cmdidx);
   if (au_name != NULL && apply_autocmds(EVENT_QUICKFIXCMDPRE, au_name,
@@ -5424,6 +5775,12 @@ void ex_vimgrep(exarg_T *eap)
   // autocommands changing the current quickfix list.
   unsigned save_qfid = qf_get_curlist(qi)->qf_id;
 
+  // When not jumping to a match no buffer has to be kept loaded, read files
+  // in advance and search them without loading them if possible.
+  if ((flags & VGR_NOJUMP) && p_vgp > 0 && vgr_prefetch_usable()) {
+    prefetch = vgr_prefetch_init(fcount, &regmatch);
+  }
+
   seconds = (time_t)0;
   for (fi = 0; fi < fcount && !got_int && tomatch > 0; fi++) {
     fname = path_try_shorten_fname(fnames[fi]);
@@ -5434,7 +5791,22 @@ void ex_vimgrep(exarg_T *eap)
       vgr_display_fname(fname);
     }
 
+    if (prefetch != NULL) {
+      vgr_prefetch_start(prefetch, fnames, fcount, fi);
+    }
+
     buf = buflist_findname_exp(fnames[fi]);
+    VgrFile *const vf = ((buf == NULL || buf->b_ml.ml_mfp == NULL)
+                         && prefetch != NULL)
+                        ? vgr_prefetch_take(prefetch, fi) : NULL;
+    if (vf != NULL && vgr_no_autocmds(fnames[fi])) {
+      vgr_match_lines(qf_get_curlist(qi), fname, vf, &regmatch, &tomatch,
+                      flags);
+      vgr_prefetch_free(vf);
+      continue;
+    }
+    vgr_prefetch_free(vf);
+
     if (buf == NULL || buf->b_ml.ml_mfp == NULL) {
       // Remember that a buffer with this name already exists.
       duplicate_name = (buf != NULL);
@@ -5563,6 +5935,9 @@ void ex_vimgrep(exarg_T *eap)
   }
 
 theend:
+  if (prefetch != NULL) {
+    vgr_prefetch_end(prefetch);
+  }
   xfree(title);
   xfree(dirname_now);
   xfree(dirname_start);
@@ -50,6 +50,7 @@
 #include <inttypes.h>
 #include <stdbool.h>
 #include <string.h>
+#include <uv.h>
 
 #include "nvim/vim.h"
 #include "nvim/ascii.h"
@@ -64,7 +65,9 @@
 #include "nvim/message.h"
 #include "nvim/misc1.h"
 #include "nvim/garray.h"
+#include "nvim/hashtab.h"
 #include "nvim/strings.h"
+#include "nvim/trace.h"
 
 #ifdef REGEXP_DEBUG
 /* show/save debugging data when BT engine is used */
@@ -379,6 +382,26 @@ typedef struct {
   int a, b, c;
 } decomp_T;
 
+/// Minimum number of lines for vim_regexec_par() to use worker threads.
+#define REGPAR_MIN_LINES 16384
+/// Number of lines matched by one worker at a time.
+#define REGPAR_CHUNK 2048
+/// Number of chunks being matched or waiting for a worker.
+#define REGPAR_QUEUED 8
+
+/// A chunk of lines matched on a worker thread by vim_regexec_par().
+typedef struct {
+  uv_work_t work;
+  regmmatch_T regmatch;  ///< with a copy of the program for this chunk
+  buf_T *buf;            ///< buffer for 'iskeyword'
+  char_u *text;          ///< copy of the text of the lines
+  size_t textsize;       ///< allocated size of "text"
+  size_t off[REGPAR_CHUNK];       ///< offset of each line in "text"
+  char_u *lines[REGPAR_CHUNK];    ///< pointers into "text"
+  linenr_T nlines;
+  uint8_t *result;       ///< RegParResult for each line
+  bool busy;             ///< queued and not finished yet
+} RegParChunk;
 
 #ifdef INCLUDE_GENERATED_DECLARATIONS
 # include "regexp.c.generated.h"
@@ -760,6 +783,8 @@ static int nextchr;             /* used for ungetchr() */
 
 static regengine_T bt_regengine;
 static regengine_T nfa_regengine;
+static bool nfa_par_usable(const nfa_regprog_T *prog);
+static regprog_T *nfa_regdup(const nfa_regprog_T *prog);
 
 // Return true if compiled regular expression "prog" can match a line break.
 int re_multiline(const regprog_T *prog)
@@ -3209,6 +3234,7 @@ static unsigned reg_tofreelen;
 // reg_buf              curbuf                  buffer in which to search
 // reg_firstlnum        <invalid>               first line in which to search
 // reg_maxline          0                       last line nr
+// reg_lines            NULL                    lines to search or NULL
 // reg_line_lbr         false or true           false
 typedef struct {
   regmatch_T *reg_match;
@@ -3221,6 +3247,8 @@ typedef struct {
   buf_T *reg_buf;
   linenr_T reg_firstlnum;
   linenr_T reg_maxline;
+  char_u **reg_lines;  // lines used instead of "reg_buf", see
+                       // vim_regexec_lines()
   bool reg_line_lbr;  // "\n" in string is line break
 
   // The current match-position is remembered with these variables:
@@ -3261,8 +3289,23 @@ typedef struct {
   int nfa_has_zsubexpr;  ///< NFA regexp has \z( ), set zsubexpr.
 } regexec_T;
 
-static regexec_T rex;
-static bool rex_in_use = false;
+// The execution state is thread-local, so that vim_regexec_par() can match
+// with the NFA engine on worker threads.
+
+static THREAD_LOCAL regexec_T rex;
+static THREAD_LOCAL bool rex_in_use = false;
+
+// Lines passed to vim_regexec_lines(), for the regexec_multi functions.
+static THREAD_LOCAL char_u **regexec_lines = NULL;
+static THREAD_LOCAL linenr_T regexec_nlines = 0;
+
+// True on a worker thread of vim_regexec_par(): don't check for CTRL-C and
+// don't give error messages.
+static THREAD_LOCAL bool reg_worker = false;
+
+// got_int is set on the main thread, a worker must not read it: the main
+// thread stops handing out work instead.  Only for the NFA engine.
+#define REG_GOT_INT (!reg_worker && got_int)
 
 /*
  * "regstack" and "backpos" are used by regmatch().  They are kept over calls
@@ -3320,6 +3363,9 @@ static char_u *reg_getline(linenr_T lnum)
     // Must have matched the "\n" in the last line.
     return (char_u *)"";
   }
+  if (rex.reg_lines != NULL) {
+    return rex.reg_lines[rex.reg_firstlnum + lnum - 1];
+  }
   return ml_get_buf(rex.reg_buf, rex.reg_firstlnum + lnum, false);
 }
 
@@ -3352,6 +3398,7 @@ bt_regexec_nl (
   rex.reg_match = rmp;
   rex.reg_mmatch = NULL;
   rex.reg_maxline = 0;
+  rex.reg_lines = NULL;
   rex.reg_line_lbr = line_lbr;
   rex.reg_buf = curbuf;
   rex.reg_win = NULL;
@@ -3427,7 +3474,10 @@ static long bt_regexec_multi(regmmatch_T *rmp, win_T *win, buf_T *buf,
   rex.reg_buf = buf;
   rex.reg_win = win;
   rex.reg_firstlnum = lnum;
-  rex.reg_maxline = rex.reg_buf->b_ml.ml_line_count - lnum;
+  rex.reg_lines = regexec_lines;
+  rex.reg_maxline = (regexec_lines != NULL
+                     ? regexec_nlines
+                     : rex.reg_buf->b_ml.ml_line_count) - lnum;
   rex.reg_line_lbr = false;
   rex.reg_ic = rmp->rmm_ic;
   rex.reg_icombine = false;
@@ -3758,7 +3808,7 @@ static bool reg_match_visual(void)
   colnr_T curswant;
 
   // Check if the buffer is the current buffer.
-  if (rex.reg_buf != curbuf || VIsual.lnum == 0) {
+  if (rex.reg_buf != curbuf || rex.reg_lines != NULL || VIsual.lnum == 0) {
     return false;
   }
 
@@ -3977,7 +4027,9 @@ static bool regmatch(
           int cmp = OPERAND(scan)[1];
           pos_T   *pos;
 
-          pos = getmark_buf(rex.reg_buf, mark, false);
+          pos = rex.reg_lines != NULL
+                ? NULL
+                : getmark_buf(rex.reg_buf, mark, false);
           if (pos == NULL                    // mark doesn't exist
               || pos->lnum <= 0) {           // mark isn't set in reg_buf
             status = RA_NOMATCH;
@@ -5713,7 +5765,23 @@ static void reg_nextline(void)
 {
   rex.line = reg_getline(++rex.lnum);
   rex.input = rex.line;
-  fast_breakcheck();
+  reg_breakcheck();
+}
+
+// Like fast_breakcheck(), but not on a worker thread.
+static void reg_breakcheck(void)
+{
+  if (!reg_worker) {
+    fast_breakcheck();
+  }
+}
+
+// Like line_breakcheck(), but not on a worker thread.
+static void reg_line_breakcheck(void)
+{
+  if (!reg_worker) {
+    line_breakcheck();
+  }
 }
 
 // Save the input line and position in a regsave_T.
@@ -6624,6 +6692,7 @@ int vim_regsub(regmatch_T *rmp, char_u *source, typval_T *expr, char_u *dest,
   rex.reg_match = rmp;
   rex.reg_mmatch = NULL;
   rex.reg_maxline = 0;
+  rex.reg_lines = NULL;
   rex.reg_buf = curbuf;
   rex.reg_line_lbr = true;
   int result = vim_regsub_both(source, expr, dest, copy, magic, backslash);
@@ -6650,6 +6719,7 @@ int vim_regsub_multi(regmmatch_T *rmp, linenr_T lnum, char_u *source, char_u *de
   rex.reg_match = NULL;
   rex.reg_mmatch = rmp;
   rex.reg_buf = curbuf;  // always works on the current buffer!
+  rex.reg_lines = NULL;
   rex.reg_firstlnum = lnum;
   rex.reg_maxline = curbuf->b_ml.ml_line_count - lnum;
   rex.reg_line_lbr = false;
@@ -7193,10 +7263,101 @@ static int regexp_engine = 0;
 static char_u regname[][30] = {
   "AUTOMATIC Regexp Engine",
   "BACKTRACKING Regexp Engine",
-  "NFA Regexp Engine"
+  "NFA Regexp Engine",
+  "NFA Regexp Engine with DFA"
 };
 #endif
 
+/*
+ * Cache of compiled programs which were freed with vim_regfree(), so that
+ * compiling the same pattern again (the last search pattern for every search
+ * and redraw with 'hlsearch', patterns of autocommands, ...) doesn't have to
+ * parse it again.
+ *
+ * A program contains state while it is being executed (re_in_use, the lists
+ * of NFA states), thus it can't be shared: vim_regcomp() takes a program out
+ * of the cache and vim_regfree() puts it back, dropping the least recently
+ * used program when the cache is full.
+ */
+#define REGCACHE_SIZE 32
+
+typedef struct {
+  regprog_T *prog;  ///< NULL for an unused entry
+  hash_T hash;      ///< hash of prog->re_cache_key
+  uint64_t tick;    ///< when the entry was added, for LRU
+} regcache_entry_T;
+
+static regcache_entry_T regcache[REGCACHE_SIZE];
+static uint64_t regcache_tick = 0;
+
+/// Gets the key for caching the program compiled from "expr" with "re_flags":
+/// all the state vim_regcomp() depends on. The case of matching depends on
+/// the regmatch_T, the program only has it when "\c" or "\C" is used.
+///
+/// @return allocated key or NULL if the program must not be cached.
+static char_u *regcache_key(const char_u *expr, int re_flags)
+{
+  // "~" is replaced with the previous substitute string and character
+  // classes like "[:keyword:]" depend on the options of the current buffer.
+  if (vim_strchr(expr, '~') != NULL || strstr((char *)expr, "[:") != NULL) {
+    return NULL;
+  }
+  const size_t len = STRLEN(expr) + 40;
+  char *const key = xmalloc(len);
+  vim_snprintf(key, len, "%x:%d:%d:%d:%s", (unsigned)re_flags, (int)p_re,
+               vim_strchr(p_cpo, CPO_LITERAL) != NULL, reg_do_extmatch,
+               expr);
+  return (char_u *)key;
+}
+
+/// Takes a program with key "key" out of the cache.
+///
+/// @return the program or NULL if it is not in the cache.
+static regprog_T *regcache_take(const char_u *key, hash_T hash)
+{
+  for (int i = 0; i < REGCACHE_SIZE; i++) {
+    regprog_T *const prog = regcache[i].prog;
+    if (prog != NULL && regcache[i].hash == hash
+        && STRCMP(prog->re_cache_key, key) == 0) {
+      regcache[i].prog = NULL;
+      return prog;
+    }
+  }
+  return NULL;
+}
+
+/// Puts "prog", which must have a cache key, in the cache.
+static void regcache_put(regprog_T *prog)
+{
+  regcache_entry_T *entry = &regcache[0];
+  for (int i = 0; i < REGCACHE_SIZE; i++) {
+    if (regcache[i].prog == NULL) {
+      entry = &regcache[i];
+      break;
+    }
+    if (regcache[i].tick < entry->tick) {
+      entry = &regcache[i];
+    }
+  }
+  if (entry->prog != NULL) {
+    vim_regfree_nocache(entry->prog);
+  }
+  entry->prog = prog;
+  entry->hash = hash_hash(prog->re_cache_key);
+  entry->tick = ++regcache_tick;
+}
+
+/// Frees all programs in the cache.
+void regcache_clear(void)
+{
+  for (int i = 0; i < REGCACHE_SIZE; i++) {
+    if (regcache[i].prog != NULL) {
+      vim_regfree_nocache(regcache[i].prog);
+      regcache[i].prog = NULL;
+    }
+  }
+}
+
 /*
  * Compile a regular expression into internal code.
  * Returns the program in allocated memory.
@@ -7204,6 +7365,31 @@ static char_u regname[][30] = {
  * Returns NULL for an error.
  */
 regprog_T *vim_regcomp(char_u *expr_arg, int re_flags)
+{
+  char_u *key = regcache_key(expr_arg, re_flags);
+  if (key != NULL) {
+    regprog_T *prog = regcache_take(key, hash_hash(key));
+    if (prog != NULL) {
+      g_stats.regexp_cache_hit++;
+      xfree(key);
+      had_eol = prog->re_had_eol;  // as if it was compiled
+      return prog;
+    }
+    g_stats.regexp_cache_miss++;
+  }
+
+  regprog_T *prog = vim_regcomp_nocache(expr_arg, re_flags);
+  if (prog != NULL) {
+    prog->re_cache_key = key;
+    prog->re_had_eol = had_eol;
+  } else {
+    xfree(key);
+  }
+  return prog;
+}
+
+/// Like vim_regcomp(), but always compiles "expr_arg".
+static regprog_T *vim_regcomp_nocache(char_u *expr_arg, int re_flags)
 {
   regprog_T   *prog = NULL;
   char_u      *expr = expr_arg;
@@ -7217,7 +7403,8 @@ regprog_T *vim_regcomp(char_u *expr_arg, int re_flags)
 
     if (newengine == AUTOMATIC_ENGINE
         || newengine == BACKTRACKING_ENGINE
-        || newengine == NFA_ENGINE) {
+        || newengine == NFA_ENGINE
+        || newengine == DFA_ENGINE) {
       regexp_engine = expr[4] - '0';
       expr += 5;
 #ifdef REGEXP_DEBUG
@@ -7227,7 +7414,7 @@ regprog_T *vim_regcomp(char_u *expr_arg, int re_flags)
 #endif
     } else {
       EMSG(_(
-              "E864: \\%#= can only be followed by 0, 1, or 2. The automatic engine will be used "));
+              "E864: \\%#= can only be followed by 0, 1, 2 or 3. The automatic engine will be used "));
       regexp_engine = AUTOMATIC_ENGINE;
     }
   }
@@ -7281,6 +7468,7 @@ regprog_T *vim_regcomp(char_u *expr_arg, int re_flags)
     // to be very slow when executing it.
     prog->re_engine = regexp_engine;
     prog->re_flags = re_flags;
+    prog->re_cache_key = NULL;
   }
 
   return prog;
@@ -7288,11 +7476,27 @@ regprog_T *vim_regcomp(char_u *expr_arg, int re_flags)
 
 /*
  * Free a compiled regexp program, returned by vim_regcomp().
+ * It is kept in the cache for when the same pattern is compiled again.
  */
 void vim_regfree(regprog_T *prog)
 {
-  if (prog != NULL)
+  if (prog == NULL) {
+    return;
+  }
+  if (prog->re_cache_key != NULL && !prog->re_in_use) {
+    regcache_put(prog);
+  } else {
+    vim_regfree_nocache(prog);
+  }
+}
+
+/// Frees a compiled regexp program without putting it in the cache.
+static void vim_regfree_nocache(regprog_T *prog)
+{
+  if (prog != NULL) {
+    xfree(prog->re_cache_key);
     prog->engine->regfree(prog);
+  }
 }
 
 static void report_re_switch(char_u *pat)
@@ -7352,7 +7556,8 @@ static bool vim_regexec_string(regmatch_T *rmp, char_u *line, colnr_T col,
     char_u *pat = vim_strsave(((nfa_regprog_T *)rmp->regprog)->pattern);
 
     p_re = BACKTRACKING_ENGINE;
-    vim_regfree(rmp->regprog);
+    // Don't keep the slow program in the cache.
+    vim_regfree_nocache(rmp->regprog);
     report_re_switch(pat);
     rmp->regprog = vim_regcomp(pat, re_flags);
     if (rmp->regprog != NULL) {
@@ -7416,6 +7621,215 @@ long vim_regexec_multi(
     int         *timed_out          // flag is set when timeout limit reached
 )
   FUNC_ATTR_NONNULL_ARG(1)
+{
+  char_u **const save_lines = regexec_lines;
+
+  regexec_lines = NULL;
+  long r = regexec_multi(rmp, win, buf, lnum, col, tm, timed_out);
+  regexec_lines = save_lines;
+  return r;
+}
+
+/// Match a regexp against lines in memory, like vim_regexec_multi() does for
+/// the lines of a buffer.  Uses curbuf for 'iskeyword'.  Marks, the cursor
+/// position and the Visual area never match.
+///
+/// @param  lines  Array of "nlines" lines, "lines[0]" is line 1.
+/// @param  lnum  Number of the line to start looking for a match.
+/// @param  col  Column to start looking for a match.
+///
+/// @return zero if there is no match, number of lines contained in the match
+///         otherwise.
+long vim_regexec_lines(regmmatch_T *rmp, char_u **lines, linenr_T nlines,
+                       linenr_T lnum, colnr_T col)
+  FUNC_ATTR_NONNULL_ALL
+{
+  char_u **const save_lines = regexec_lines;
+  const linenr_T save_nlines = regexec_nlines;
+
+  regexec_lines = lines;
+  regexec_nlines = nlines;
+  long r = regexec_multi(rmp, NULL, curbuf, lnum, col, NULL, NULL);
+  regexec_lines = save_lines;
+  regexec_nlines = save_nlines;
+  return r;
+}
+
+static void regpar_work(uv_work_t *req)
+{
+  RegParChunk *const chunk = req->data;
+  const TraceSpan span = trace_begin();
+  vim_regexec_worker(&chunk->regmatch, chunk->buf, chunk->lines, chunk->nlines,
+                     chunk->result);
+  trace_end(span, "regexp", "match lines", NULL);
+}
+
+/// Makes a copy of "prog" for vim_regexec_worker(), on the main thread.
+///
+/// @return NULL when "prog" can't be matched on a worker thread, see
+///         vim_regexec_par().
+regprog_T *vim_regdup_worker(regprog_T *prog)
+  FUNC_ATTR_NONNULL_ALL
+{
+  if (prog->engine != &nfa_regengine
+      || !nfa_par_usable((nfa_regprog_T *)prog)) {
+    return NULL;
+  }
+  return nfa_regdup((nfa_regprog_T *)prog);
+}
+
+/// Finds out on a worker thread which of "nlines" lines in memory contain a
+/// match for "rmp", like vim_regexec_par() does for the lines of a buffer.
+/// "rmp->regprog" must be returned by vim_regdup_worker() and only be used by
+/// this thread.
+///
+/// @param  buf  Buffer for 'iskeyword', must not change while matching.
+/// @param  result  Set to a RegParResult for each line.
+void vim_regexec_worker(regmmatch_T *rmp, buf_T *buf, char_u **lines,
+                        linenr_T nlines, uint8_t *result)
+  FUNC_ATTR_NONNULL_ALL
+{
+  reg_worker = true;
+  mem_worker_thread();
+  regexec_lines = lines;
+  regexec_nlines = nlines;
+  for (linenr_T i = 0; i < nlines; i++) {
+    rex_in_use = true;
+    const long r = rmp->regprog->engine->regexec_multi(rmp, NULL, buf, i + 1,
+                                                       0, NULL, NULL);
+    rex_in_use = false;
+    if (r > 0) {
+      result[i] = kRegParMatch;
+    } else if (r == 0) {
+      result[i] = kRegParNoMatch;
+    } else {
+      result[i] = kRegParUnknown;  // too expensive
+    }
+  }
+  regexec_lines = NULL;
+}
+
+static void regpar_after_work(uv_work_t *req, int status)
+{
+  ((RegParChunk *)req->data)->busy = false;
+}
+
+/// Copies the text of "nlines" lines from "lnum" for a worker.
+static void regpar_fill(RegParChunk *chunk, buf_T *buf, linenr_T lnum,
+                        linenr_T nlines, uint8_t *result)
+{
+  size_t used = 0;
+  for (linenr_T i = 0; i < nlines; i++) {
+    const char_u *const line = ml_get_buf(buf, lnum + i, false);
+    const size_t len = STRLEN(line) + 1;
+    if (used + len > chunk->textsize) {
+      chunk->textsize = MAX(chunk->textsize * 2, used + len);
+      chunk->text = xrealloc(chunk->text, chunk->textsize);
+    }
+    memcpy(chunk->text + used, line, len);
+    chunk->off[i] = used;
+    used += len;
+  }
+  for (linenr_T i = 0; i < nlines; i++) {
+    chunk->lines[i] = chunk->text + chunk->off[i];
+  }
+  chunk->nlines = nlines;
+  chunk->buf = buf;
+  chunk->result = result;
+}
+
+/// Find out which of the lines "line1" to "line2" of "buf" contain a match for
+/// "rmp", like calling vim_regexec_multi() for each of them with column zero.
+/// The lines are copied in chunks and matched on worker threads with the NFA
+/// engine, while the next chunk is copied.
+///
+/// Only used for patterns that match within one line and don't depend on the
+/// line number, marks or the cursor.  Lines which can't be matched on a worker
+/// (too expensive for the NFA engine, interrupted) get kRegParUnknown.
+///
+/// @return NULL when it is not worth it or not possible, otherwise an
+///         allocated array with a RegParResult for each line, "[0]" is for
+///         "line1".
+uint8_t *vim_regexec_par(regmmatch_T *rmp, buf_T *buf, linenr_T line1,
+                         linenr_T line2)
+  FUNC_ATTR_NONNULL_ALL
+{
+  if (line2 - line1 + 1 < REGPAR_MIN_LINES || got_int
+      || rmp->regprog->engine != &nfa_regengine
+      || !nfa_par_usable((nfa_regprog_T *)rmp->regprog)) {
+    return NULL;
+  }
+  // Loop used to wait for the workers.
+  uv_loop_t loop;
+  if (uv_loop_init(&loop) != 0) {
+    return NULL;
+  }
+
+  // Each chunk gets its own copy of the program, the DFA and "re_in_use" are
+  // in it.  Don't compile the pattern again: "~" and the like may have a
+  // different meaning by now.
+  RegParChunk *chunks[REGPAR_QUEUED];
+  for (int i = 0; i < REGPAR_QUEUED; i++) {
+    chunks[i] = xcalloc(1, sizeof(RegParChunk));
+    chunks[i]->work.data = chunks[i];
+    chunks[i]->regmatch.regprog = vim_regdup_worker(rmp->regprog);
+    chunks[i]->regmatch.rmm_ic = rmp->rmm_ic;
+    chunks[i]->regmatch.rmm_maxcol = rmp->rmm_maxcol;
+  }
+
+  const size_t count = (size_t)(line2 - line1 + 1);
+  uint8_t *result = xmalloc(count);
+  memset(result, kRegParUnknown, count);
+
+  linenr_T lnum = line1;
+  int busy = 0;
+  for (;;) {
+    fast_breakcheck();
+    if (lnum <= line2 && !got_int) {
+      RegParChunk *chunk = NULL;
+      for (int i = 0; i < REGPAR_QUEUED; i++) {
+        if (!chunks[i]->busy) {
+          chunk = chunks[i];
+          break;
+        }
+      }
+      if (chunk != NULL) {
+        const linenr_T n = MIN(line2 - lnum + 1, REGPAR_CHUNK);
+        regpar_fill(chunk, buf, lnum, n, result + (lnum - line1));
+        if (uv_queue_work(&loop, &chunk->work, regpar_work,
+                          regpar_after_work) != 0) {
+          lnum = line2 + 1;  // leave the rest kRegParUnknown
+          continue;
+        }
+        chunk->busy = true;
+        busy++;
+        lnum += n;
+        continue;
+      }
+    }
+    if (busy == 0) {
+      break;
+    }
+    uv_run(&loop, UV_RUN_ONCE);
+    busy = 0;
+    for (int i = 0; i < REGPAR_QUEUED; i++) {
+      busy += chunks[i]->busy;
+    }
+  }
+
+  for (int i = 0; i < REGPAR_QUEUED; i++) {
+    vim_regfree(chunks[i]->regmatch.regprog);
+    xfree(chunks[i]->text);
+    xfree(chunks[i]);
+  }
+  uv_loop_close(&loop);
+  return result;
+}
+
+static long regexec_multi(regmmatch_T *rmp, win_T *win, buf_T *buf,
+                          linenr_T lnum, colnr_T col, proftime_T *tm,
+                          int *timed_out)
+  FUNC_ATTR_NONNULL_ARG(1)
 {
   regexec_T rex_save;
   bool rex_in_use_save = rex_in_use;
@@ -7445,7 +7859,8 @@ long vim_regexec_multi(
     char_u *pat = vim_strsave(((nfa_regprog_T *)rmp->regprog)->pattern);
 
     p_re = BACKTRACKING_ENGINE;
-    vim_regfree(rmp->regprog);
+    // Don't keep the slow program in the cache.
+    vim_regfree_nocache(rmp->regprog);
     report_re_switch(pat);
     // checking for \z misuse was already done when compiling for NFA,
     // allow all here
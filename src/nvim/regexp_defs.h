@@ -41,6 +41,7 @@
 #define AUTOMATIC_ENGINE    0
 #define BACKTRACKING_ENGINE 1
 #define NFA_ENGINE          2
+#define DFA_ENGINE          3  ///< NFA engine, lines are checked with a DFA
 
 typedef struct regengine regengine_T;
 typedef struct regprog regprog_T;
@@ -73,6 +74,8 @@ struct regprog {
   unsigned re_engine;  ///< Automatic, backtracking or NFA engine.
   unsigned re_flags;   ///< Second argument for vim_regcomp().
   bool re_in_use;      ///< prog is being executed
+  char_u *re_cache_key;  ///< key in the regprog cache, NULL if not cached
+  bool re_had_eol;       ///< vim_regcomp_had_eol() after compiling
 };
 
 /*
@@ -81,12 +84,14 @@ struct regprog {
  * See regexp.c for an explanation.
  */
 typedef struct {
-  // These four members implement regprog_T.
+  // These members implement regprog_T.
   regengine_T *engine;
   unsigned regflags;
   unsigned re_engine;
   unsigned re_flags;
   bool re_in_use;
+  char_u *re_cache_key;
+  bool re_had_eol;
 
   int regstart;
   char_u reganch;
@@ -99,6 +104,7 @@ typedef struct {
 // Structure representing a NFA state.
 // An NFA state may have no outgoing edge, when it is a NFA_MATCH state.
 typedef struct nfa_state nfa_state_T;
+typedef struct nfa_dfa nfa_dfa_T;
 struct nfa_state {
   int c;
   nfa_state_T         *out;
@@ -112,23 +118,28 @@ struct nfa_state {
  * Structure used by the NFA matcher.
  */
 typedef struct {
-  // These four members implement regprog_T.
+  // These members implement regprog_T.
   regengine_T *engine;
   unsigned regflags;
   unsigned re_engine;
   unsigned re_flags;
   bool re_in_use;
+  char_u *re_cache_key;
+  bool re_had_eol;
 
   nfa_state_T         *start;           // points into state[]
 
   int reganch;                          // pattern starts with ^
   int regstart;                         // char at start of pattern
   char_u              *match_text;      // plain text to match with
+  char_u              *must;            // text every match contains or NULL
+  int mustlen;                          // length of "must"
 
   int has_zend;                         // pattern contains \ze
   int has_backref;                      // pattern contains \1 .. \9
   int reghasz;
   char_u              *pattern;
+  nfa_dfa_T           *dfa;             // built when first executed
   int nsubexp;                          // number of ()
   int nstate;
   nfa_state_T state[1];                 // actually longer..
@@ -146,6 +157,13 @@ typedef struct {
   bool                 rm_ic;
 } regmatch_T;
 
+/// Result for a line of vim_regexec_par().
+typedef enum {
+  kRegParNoMatch = 0,
+  kRegParMatch = 1,
+  kRegParUnknown = 2,  ///< not matched, use vim_regexec_multi()
+} RegParResult;
+
 /*
  * Structure used to store external references: "\z\(\)" to "\z\1".
  * Use a reference count to avoid the need to copy this around.  When it goes
@@ -322,6 +322,46 @@ typedef struct {
   int has_pim;                  ///< true when any state has a PIM
 } nfa_list_T;
 
+// DFA for checking whether a line matches, see nfa_dfa_scan().
+#define NFA_DFA_MAX_STATES 256
+#define NFA_DFA_WIDE_SIZE 1024  // size of nfa_dfa_T.wide, a power of two
+#define NFA_DFA_WIDE_PROBE 4    // number of slots tried in nfa_dfa_T.wide
+
+/// Result of nfa_dfa_scan().
+typedef enum {
+  kDfaNoMatch,
+  kDfaMatch,
+  kDfaUnknown,  ///< DFA can't be used, need to use the NFA
+} DfaResult;
+
+typedef struct {
+  int *nfa;        ///< sorted indexes of NFA states in prog->state[]
+  int nnfa;        ///< number of items in "nfa"
+  unsigned hash;   ///< hash of "nfa"
+  bool match;      ///< contains NFA_MATCH
+  int next[128];   ///< next DFA state for an ASCII character, -1 if unknown
+} nfa_dfa_state_T;
+
+/// Cached transition for a character >= 0x80.
+typedef struct {
+  int from;        ///< DFA state, -1 for an unused slot
+  int c;           ///< character
+  int next;        ///< next DFA state
+} nfa_dfa_wide_T;
+
+struct nfa_dfa {
+  bool usable;              ///< pattern can be matched with the DFA
+  bool ic;                  ///< "rex.reg_ic" the states were built for
+  nfa_dfa_state_T *states;  ///< DFA states, the start state is the first
+  int nstates;              ///< number of DFA states
+  int *set;                 ///< NFA states of a new DFA state, "nstate" items
+  int *stack;               ///< stack for nfa_dfa_closure(), "nstate" items
+  unsigned *mark;           ///< per NFA state: "gen" when in "set"
+  unsigned gen;             ///< generation for "mark", never zero when used
+  nfa_dfa_wide_T *wide;     ///< hash table with transitions for characters
+                            ///< >= 0x80, NFA_DFA_WIDE_SIZE items or NULL
+};
+
 // Variables only used in nfa_regcomp() and descendants.
 static int nfa_re_flags;  ///< re_flags passed to nfa_regcomp().
 static int *post_start;   ///< holds the postfix form of r.e.
@@ -333,14 +373,15 @@ static int *post_ptr;
 // while NFA engine handles multibyte characters correctly.
 static bool wants_nfa;
 
-static int nstate;  ///< Number of states in the NFA. Also used when executing.
+/// Number of states in the NFA. Also used when executing.
+static THREAD_LOCAL int nstate;
 static int istate;  ///< Index in the state vector, used in alloc_state()
 
 /* If not NULL match must end at this position */
-static save_se_T *nfa_endp = NULL;
+static THREAD_LOCAL save_se_T *nfa_endp = NULL;
 
 /* 0 for first call to nfa_regmatch(), 1 for recursive call. */
-static int nfa_ll_index = 0;
+static THREAD_LOCAL int nfa_ll_index = 0;
 
 #ifdef INCLUDE_GENERATED_DECLARATIONS
 # include "regexp_nfa.c.generated.h"
@@ -559,6 +600,132 @@ static char_u *nfa_get_match_text(nfa_state_T *start)
   return ret;
 }
 
+/// Checks whether branch "p" of NFA_SPLIT "split" is a simple loop, which
+/// ends in "split" without another alternative.
+static bool nfa_split_loops(const nfa_state_T *split, const nfa_state_T *p,
+                            int nstate)
+{
+  while (p != NULL && nstate-- > 0) {
+    if (p == split) {
+      return true;
+    }
+    if (p->c == NFA_SPLIT || p->c == NFA_MATCH) {
+      return false;
+    }
+    if (p->c == NFA_START_COLL || p->c == NFA_START_NEG_COLL) {
+      p = p->out1->out;
+    } else {
+      p = p->out;
+    }
+  }
+  return false;
+}
+
+/// Finds the longest literal text that every match of the NFA starting at
+/// "start" must contain, for quickly skipping lines that can't match.
+/// Follows the states from the start until an alternative, a multi other
+/// than a simple loop, or something that may match a line break.  Thus the
+/// text is always found in the line where the match starts.
+///
+/// @param[out]  lenp  Set to the length of the text.
+///
+/// @return the text in allocated memory or NULL when there is none.
+static char_u *nfa_get_must(nfa_state_T *start, int nstate, int *lenp)
+{
+  char_u buf[MAXPATHL];
+  int len = 0;
+  const nfa_state_T *best = NULL;
+  const nfa_state_T *run = NULL;
+  int bestlen = 0;
+  int runlen = 0;
+
+  // Every state is passed at most once, a loop needs an NFA_SPLIT.
+  for (nfa_state_T *p = start; p != NULL && nstate-- > 0;) {
+    const int c = p->c;
+    if (c > 0 && !utf_iscomposing(c)) {
+      if (run == NULL) {
+        run = p;
+      }
+      runlen += utf_char2len(c);
+      if (runlen > bestlen) {
+        best = run;
+        bestlen = runlen;
+      }
+      p = p->out;
+      continue;
+    }
+    if ((c >= NFA_MOPEN && c <= NFA_ZCLOSE9)
+        || (c >= NFA_CURSOR && c <= NFA_VISUAL)
+        || (c >= NFA_BOL && c <= NFA_EOF)
+        || c == NFA_ZSTART || c == NFA_ZEND
+        || c == NFA_NOPEN || c == NFA_NCLOSE || c == NFA_EMPTY) {
+      // Zero-width: the text before and after is still adjacent.
+      p = p->out;
+      continue;
+    }
+    run = NULL;
+    runlen = 0;
+    if (c >= NFA_ANY && c <= NFA_NUPPER_IC) {
+      p = p->out;
+    } else if (c == NFA_START_COLL || c == NFA_START_NEG_COLL) {
+      p = p->out1->out;  // the state after NFA_END_COLL
+    } else if (c == NFA_SPLIT && nfa_split_loops(p, p->out, nstate)) {
+      p = p->out1;  // "x*" and "x\+": what follows the loop
+    } else if (c == NFA_SPLIT && nfa_split_loops(p, p->out1, nstate)) {
+      p = p->out;  // "x\{-}"
+    } else {
+      break;
+    }
+  }
+
+  // A single character is handled well enough by regstart.
+  if (bestlen < 2 || bestlen >= (int)sizeof(buf)) {
+    return NULL;
+  }
+  for (const nfa_state_T *p = best; len < bestlen; p = p->out) {
+    // Skip the zero-width states inside the run.
+    if (p->c > 0) {
+      len += utf_char2bytes(p->c, buf + len);
+    }
+  }
+  *lenp = len;
+  return vim_strnsave(buf, (size_t)len);
+}
+
+/// Checks whether "prog->must" appears in "rex.line" at or after "col".
+/// When ignoring case only ASCII is compared, a line or text with other
+/// characters may match and is not rejected.
+static bool nfa_has_must(const nfa_regprog_T *prog, colnr_T col)
+{
+  const char_u *const line = rex.line + col;
+  if (!rex.reg_ic) {
+    return strstr((const char *)line, (const char *)prog->must) != NULL;
+  }
+  for (int i = 0; i < prog->mustlen; i++) {
+    if (prog->must[i] >= 0x80) {
+      return true;
+    }
+  }
+  const int c0 = TOLOWER_ASC(prog->must[0]);
+  for (const char_u *s = line; *s != NUL; s++) {
+    if (*s >= 0x80) {
+      return true;  // e.g. the Kelvin sign folds to "k"
+    }
+    if (TOLOWER_ASC(*s) != c0) {
+      continue;
+    }
+    int i = 1;
+    while (i < prog->mustlen && s[i] < 0x80
+           && TOLOWER_ASC(s[i]) == TOLOWER_ASC(prog->must[i])) {
+      i++;
+    }
+    if (i == prog->mustlen || s[i] >= 0x80) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /*
  * Allocate more space for post_start.  Called when
  * running above the estimated number of states.
@@ -3590,10 +3757,10 @@ static char *pim_info(const nfa_pim_T *pim)
 #endif
 
 // Used during execution: whether a match has been found.
-static int nfa_match;
-static proftime_T *nfa_time_limit;
-static int *nfa_timed_out;
-static int nfa_time_count;
+static THREAD_LOCAL int nfa_match;
+static THREAD_LOCAL proftime_T *nfa_time_limit;
+static THREAD_LOCAL int *nfa_timed_out;
+static THREAD_LOCAL int nfa_time_count;
 
 // Copy postponed invisible match info from "from" to "to".
 static void copy_pim(nfa_pim_T *to, nfa_pim_T *from)
@@ -3968,11 +4135,11 @@ static regsubs_T *addstate(
   int i;
   regsub_T            *sub;
   regsubs_T           *subs = subs_arg;
-  static regsubs_T temp_subs;
+  static THREAD_LOCAL regsubs_T temp_subs;
 #ifdef REGEXP_DEBUG
   int did_print = false;
 #endif
-  static int depth = 0;
+  static THREAD_LOCAL int depth = 0;
 
   // This function is called recursively.  When the depth is too much we run
   // out of stack and crash, limit recursiveness here.
@@ -4102,7 +4269,9 @@ skip_add:
       const size_t newsize = newlen * sizeof(nfa_thread_T);
 
       if ((long)(newsize >> 10) >= p_mmp) {
-        EMSG(_(e_maxmempat));
+        if (!reg_worker) {
+          EMSG(_(e_maxmempat));
+        }
         depth--;
         return NULL;
       }
@@ -4392,7 +4561,9 @@ static regsubs_T *addstate_here(
       const size_t newsize = newlen * sizeof(nfa_thread_T);
 
       if ((long)(newsize >> 10) >= p_mmp) {
-        EMSG(_(e_maxmempat));
+        if (!reg_worker) {
+          EMSG(_(e_maxmempat));
+        }
         return NULL;
       }
       nfa_thread_T *const newl = xmalloc(newsize);
@@ -5086,8 +5257,8 @@ static int nfa_regmatch(nfa_regprog_T *prog, nfa_state_T *start,
 #endif
   // Some patterns may take a long time to match, especially when using
   // recursive_regmatch(). Allow interrupting them with CTRL-C.
-  fast_breakcheck();
-  if (got_int) {
+  reg_breakcheck();
+  if (REG_GOT_INT) {
 #ifdef NFA_REGEXP_DEBUG_LOG
     fclose(debug);
 #endif
@@ -5216,8 +5387,8 @@ static int nfa_regmatch(nfa_regprog_T *prog, nfa_state_T *start,
     for (listidx = 0; listidx < thislist->n; listidx++) {
       // If the list gets very long there probably is something wrong.
       // At least allow interrupting with CTRL-C.
-      fast_breakcheck();
-      if (got_int) {
+      reg_breakcheck();
+      if (REG_GOT_INT) {
         break;
       }
       if (nfa_time_limit != NULL && ++nfa_time_count == 20) {
@@ -6068,7 +6239,9 @@ static int nfa_regmatch(nfa_regprog_T *prog, nfa_state_T *start,
       case NFA_MARK_GT:
       case NFA_MARK_LT:
       {
-        pos_T *pos = getmark_buf(rex.reg_buf, t->state->val, false);
+        pos_T *pos = rex.reg_lines != NULL
+                     ? NULL
+                     : getmark_buf(rex.reg_buf, t->state->val, false);
 
         // Compare the mark position to the match position, if the mark
         // exists and mark is set in reg_buf.
@@ -6361,8 +6534,8 @@ nextchar:
     }
 
     // Allow interrupting with CTRL-C.
-    line_breakcheck();
-    if (got_int) {
+    reg_line_breakcheck();
+    if (REG_GOT_INT) {
       break;
     }
     // Check for timeout once every twenty times to avoid overhead.
@@ -6478,7 +6651,12 @@ static long nfa_regtry(nfa_regprog_T *prog,
     }
   }
 
-  /* Package any found \z(...\) matches for export. Default is none. */
+  // Package any found \z(...\) matches for export. Default is none.
+  // "re_extmatch_out" is shared, a worker thread must leave it alone, it
+  // never has \z( either.
+  if (reg_worker) {
+    return 1 + rex.lnum;
+  }
   unref_extmatch(re_extmatch_out);
   re_extmatch_out = NULL;
 
@@ -6511,6 +6689,435 @@ static long nfa_regtry(nfa_regprog_T *prog,
   return 1 + rex.lnum;
 }
 
+// A DFA built lazily from the NFA of a pattern, used to find out quickly
+// whether a line contains a match.  Only when it does the NFA is simulated to
+// find the exact match and submatches, thus the result is always the same as
+// without the DFA.
+//
+// A DFA state is the set of NFA states that can be active at a position,
+// after following all zero-width states.  Zero-width states that depend on
+// the position (^, $, \<, \%23l, etc.) are assumed to always match, the DFA
+// may then find a match where the NFA doesn't, but never the other way
+// around.  Character classes which depend on options that can change between
+// two matches (\k, \i, \f and \p) are handled like "." for the same reason.
+// Patterns with back references, look-around, items that match a line break
+// or such classes inside [] can't use the DFA.
+//
+// Transitions are cached in the DFA state for ASCII characters and in a small
+// hash table for other characters, where a new transition may replace an old
+// one.  When the number of DFA states gets too big the DFA is not used for the
+// pattern anymore.
+
+/// Checks whether the NFA of "prog" can be matched with a DFA.
+static bool nfa_dfa_usable(const nfa_regprog_T *prog)
+{
+  if (prog->has_backref || (prog->regflags & RF_HASNL)
+      || (prog->regflags & RF_ICOMBINE)) {
+    return false;
+  }
+  for (int i = 0; i < prog->nstate; i++) {
+    const int c = prog->state[i].c;
+    if (c >= 0
+        || (c >= NFA_MOPEN && c <= NFA_ZCLOSE9)
+        || (c >= NFA_ANY && c <= NFA_NUPPER_IC)
+        || (c >= NFA_CLASS_ALNUM && c <= NFA_CLASS_ESCAPE
+            && c != NFA_CLASS_PRINT)
+        || (c >= NFA_CURSOR && c <= NFA_VISUAL)) {
+      continue;
+    }
+    switch (c) {
+    case NFA_SPLIT:
+    case NFA_MATCH:
+    case NFA_EMPTY:
+    case NFA_START_COLL:
+    case NFA_END_COLL:
+    case NFA_START_NEG_COLL:
+    case NFA_RANGE_MIN:
+    case NFA_RANGE_MAX:
+    case NFA_BOL:
+    case NFA_EOL:
+    case NFA_BOW:
+    case NFA_EOW:
+    case NFA_BOF:
+    case NFA_EOF:
+    case NFA_ZSTART:
+    case NFA_ZEND:
+    case NFA_NOPEN:
+    case NFA_NCLOSE:
+      continue;
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Checks whether NFA state "s" is zero-width, for the DFA.
+static bool nfa_dfa_is_empty(const nfa_state_T *s)
+{
+  const int c = s->c;
+  return c == NFA_SPLIT || c == NFA_EMPTY
+         || (c >= NFA_MOPEN && c <= NFA_ZCLOSE9)
+         || (c >= NFA_CURSOR && c <= NFA_VISUAL)
+         || (c >= NFA_BOL && c <= NFA_EOF)
+         || c == NFA_ZSTART || c == NFA_ZEND
+         || c == NFA_NOPEN || c == NFA_NCLOSE;
+}
+
+/// Adds NFA state "s" and the states reachable from it without consuming a
+/// character to dfa->set[] (not sorted).
+static void nfa_dfa_closure(nfa_dfa_T *dfa, const nfa_regprog_T *prog,
+                            const nfa_state_T *s, int *nset)
+{
+  int sp = 0;
+  dfa->stack[sp++] = (int)(s - prog->state);
+  while (sp > 0) {
+    const int idx = dfa->stack[--sp];
+    if (dfa->mark[idx] == dfa->gen) {
+      continue;
+    }
+    dfa->mark[idx] = dfa->gen;
+    const nfa_state_T *const t = &prog->state[idx];
+    if (nfa_dfa_is_empty(t)) {
+      // Every state is visited once, thus the stack can't overflow.
+      if (t->c == NFA_SPLIT) {
+        dfa->stack[sp++] = (int)(t->out1 - prog->state);
+      }
+      dfa->stack[sp++] = (int)(t->out - prog->state);
+    } else {
+      dfa->set[(*nset)++] = idx;
+    }
+  }
+}
+
+/// Checks whether character "curc" matches the collection starting at "s",
+/// like nfa_regmatch() does.
+static bool nfa_dfa_coll_match(const nfa_state_T *s, int curc)
+{
+  const bool result_if_matched = (s->c == NFA_START_COLL);
+  for (const nfa_state_T *state = s->out;; state = state->out) {
+    if (state->c == NFA_END_COLL) {
+      return !result_if_matched;
+    }
+    if (state->c == NFA_RANGE_MIN) {
+      int c1 = state->val;
+      state = state->out;  // advance to NFA_RANGE_MAX
+      const int c2 = state->val;
+      if (curc >= c1 && curc <= c2) {
+        return result_if_matched;
+      }
+      if (rex.reg_ic) {
+        const int curc_low = utf_fold(curc);
+        for (; c1 <= c2; c1++) {
+          if (utf_fold(c1) == curc_low) {
+            return result_if_matched;
+          }
+        }
+      }
+    } else if (state->c < 0 ? check_char_class(state->c, curc)
+               : (curc == state->c
+                  || (rex.reg_ic && utf_fold(curc) == utf_fold(state->c)))) {
+      return result_if_matched;
+    }
+  }
+}
+
+/// Gets the state that follows when NFA state "s" consumes "curc", which is
+/// not NUL.
+///
+/// @return the next state or NULL when "curc" doesn't match.
+static const nfa_state_T *nfa_dfa_step(const nfa_state_T *s, int curc)
+{
+  bool result;
+  switch (s->c) {
+  case NFA_MATCH:
+    return NULL;
+  case NFA_START_COLL:
+  case NFA_START_NEG_COLL:
+    // next state is in out of the NFA_END_COLL
+    return nfa_dfa_coll_match(s, curc) ? s->out1->out : NULL;
+  case NFA_ANY:
+  // Depend on options, see above.
+  case NFA_IDENT:
+  case NFA_SIDENT:
+  case NFA_KWORD:
+  case NFA_SKWORD:
+  case NFA_FNAME:
+  case NFA_SFNAME:
+  case NFA_PRINT:
+  case NFA_SPRINT:
+    result = true;
+    break;
+  case NFA_WHITE:
+    result = ascii_iswhite(curc);
+    break;
+  case NFA_NWHITE:
+    result = !ascii_iswhite(curc);
+    break;
+  case NFA_DIGIT:
+    result = ri_digit(curc);
+    break;
+  case NFA_NDIGIT:
+    result = !ri_digit(curc);
+    break;
+  case NFA_HEX:
+    result = ri_hex(curc);
+    break;
+  case NFA_NHEX:
+    result = !ri_hex(curc);
+    break;
+  case NFA_OCTAL:
+    result = ri_octal(curc);
+    break;
+  case NFA_NOCTAL:
+    result = !ri_octal(curc);
+    break;
+  case NFA_WORD:
+    result = ri_word(curc);
+    break;
+  case NFA_NWORD:
+    result = !ri_word(curc);
+    break;
+  case NFA_HEAD:
+    result = ri_head(curc);
+    break;
+  case NFA_NHEAD:
+    result = !ri_head(curc);
+    break;
+  case NFA_ALPHA:
+    result = ri_alpha(curc);
+    break;
+  case NFA_NALPHA:
+    result = !ri_alpha(curc);
+    break;
+  case NFA_LOWER:
+    result = ri_lower(curc);
+    break;
+  case NFA_NLOWER:
+    result = !ri_lower(curc);
+    break;
+  case NFA_UPPER:
+    result = ri_upper(curc);
+    break;
+  case NFA_NUPPER:
+    result = !ri_upper(curc);
+    break;
+  case NFA_LOWER_IC:
+    result = ri_lower(curc) || (rex.reg_ic && ri_upper(curc));
+    break;
+  case NFA_NLOWER_IC:
+    result = !(ri_lower(curc) || (rex.reg_ic && ri_upper(curc)));
+    break;
+  case NFA_UPPER_IC:
+    result = ri_upper(curc) || (rex.reg_ic && ri_lower(curc));
+    break;
+  case NFA_NUPPER_IC:
+    result = !(ri_upper(curc) || (rex.reg_ic && ri_lower(curc)));
+    break;
+  default:  // regular character
+    result = s->c == curc || (rex.reg_ic && utf_fold(s->c) == utf_fold(curc));
+    break;
+  }
+  return result ? s->out : NULL;
+}
+
+static int nfa_dfa_cmp_int(const void *a, const void *b)
+{
+  return *(const int *)a - *(const int *)b;
+}
+
+/// Finds or adds the DFA state for the "nset" NFA states in dfa->set[].
+///
+/// @return index of the DFA state or -1 when there are too many states.
+static int nfa_dfa_add_state(nfa_dfa_T *dfa, const nfa_regprog_T *prog,
+                             int nset)
+{
+  qsort(dfa->set, (size_t)nset, sizeof(int), nfa_dfa_cmp_int);
+  unsigned hash = (unsigned)nset;
+  for (int i = 0; i < nset; i++) {
+    hash = hash * 31 + (unsigned)dfa->set[i];
+  }
+  for (int i = 0; i < dfa->nstates; i++) {
+    const nfa_dfa_state_T *const ds = &dfa->states[i];
+    if (ds->hash == hash && ds->nnfa == nset
+        && memcmp(ds->nfa, dfa->set, (size_t)nset * sizeof(int)) == 0) {
+      return i;
+    }
+  }
+  if (dfa->nstates == NFA_DFA_MAX_STATES) {
+    return -1;
+  }
+  if (dfa->states == NULL) {
+    dfa->states = xmalloc(NFA_DFA_MAX_STATES * sizeof(*dfa->states));
+  }
+  nfa_dfa_state_T *const ds = &dfa->states[dfa->nstates];
+  ds->nfa = xmemdup(dfa->set, (size_t)nset * sizeof(int));
+  ds->nnfa = nset;
+  ds->hash = hash;
+  ds->match = false;
+  for (int i = 0; i < nset; i++) {
+    if (prog->state[dfa->set[i]].c == NFA_MATCH) {
+      ds->match = true;
+    }
+  }
+  memset(ds->next, -1, sizeof(ds->next));
+  return dfa->nstates++;
+}
+
+/// Computes the DFA state after DFA state "from" consumed "curc".
+///
+/// @return index of the DFA state or -1 when there are too many states.
+static int nfa_dfa_transition(nfa_dfa_T *dfa, const nfa_regprog_T *prog,
+                              int from, int curc)
+{
+  int nset = 0;
+  nfa_dfa_next_gen(dfa, prog);
+  const nfa_dfa_state_T *const ds = &dfa->states[from];
+  for (int i = 0; i < ds->nnfa; i++) {
+    const nfa_state_T *const next = nfa_dfa_step(&prog->state[ds->nfa[i]],
+                                                 curc);
+    if (next != NULL) {
+      nfa_dfa_closure(dfa, prog, next, &nset);
+    }
+  }
+  // A match may also start at the next position.
+  nfa_dfa_closure(dfa, prog, prog->start, &nset);
+  return nfa_dfa_add_state(dfa, prog, nset);
+}
+
+/// Computes the DFA state after DFA state "from" consumed "c", which is
+/// >= 0x80, using the cache in dfa->wide[].
+///
+/// @return index of the DFA state or -1 when there are too many states.
+static int nfa_dfa_wide_transition(nfa_dfa_T *dfa, const nfa_regprog_T *prog,
+                                   int from, int c)
+{
+  if (dfa->wide == NULL) {
+    dfa->wide = xmalloc(NFA_DFA_WIDE_SIZE * sizeof(*dfa->wide));
+    for (int i = 0; i < NFA_DFA_WIDE_SIZE; i++) {
+      dfa->wide[i].from = -1;
+    }
+  }
+  const unsigned hash = ((unsigned)from * 0x9E3779B1u) ^ (unsigned)c;
+  nfa_dfa_wide_T *slot = NULL;
+  for (unsigned i = 0; i < NFA_DFA_WIDE_PROBE; i++) {
+    nfa_dfa_wide_T *const w = &dfa->wide[(hash + i) & (NFA_DFA_WIDE_SIZE - 1)];
+    if (w->from == from && w->c == c) {
+      return w->next;
+    }
+    if (w->from < 0 && slot == NULL) {
+      slot = w;
+    }
+  }
+  const int next = nfa_dfa_transition(dfa, prog, from, c);
+  if (next >= 0) {
+    if (slot == NULL) {
+      // All slots used: replace the first one.
+      slot = &dfa->wide[hash & (NFA_DFA_WIDE_SIZE - 1)];
+    }
+    slot->from = from;
+    slot->c = c;
+    slot->next = next;
+  }
+  return next;
+}
+
+/// Starts a new generation for dfa->mark[], resetting it when "gen" wraps
+/// around.
+static void nfa_dfa_next_gen(nfa_dfa_T *dfa, const nfa_regprog_T *prog)
+{
+  if (++dfa->gen == 0) {
+    memset(dfa->mark, 0, (size_t)prog->nstate * sizeof(*dfa->mark));
+    dfa->gen = 1;
+  }
+}
+
+/// Frees the DFA states of "dfa", keeping the DFA usable.
+static void nfa_dfa_clear(nfa_dfa_T *dfa)
+{
+  for (int i = 0; i < dfa->nstates; i++) {
+    xfree(dfa->states[i].nfa);
+  }
+  XFREE_CLEAR(dfa->states);
+  XFREE_CLEAR(dfa->wide);
+  dfa->nstates = 0;
+}
+
+static void nfa_dfa_free(nfa_dfa_T *dfa)
+{
+  if (dfa != NULL) {
+    nfa_dfa_clear(dfa);
+    xfree(dfa->set);
+    xfree(dfa->stack);
+    xfree(dfa->mark);
+    xfree(dfa);
+  }
+}
+
+/// Checks with the DFA of "prog" whether rex.line contains a match starting
+/// at or after "col".
+static DfaResult nfa_dfa_scan(nfa_regprog_T *prog, colnr_T col)
+{
+  nfa_dfa_T *dfa = prog->dfa;
+  if (dfa == NULL) {
+    dfa = prog->dfa = xcalloc(1, sizeof(*dfa));
+    dfa->usable = nfa_dfa_usable(prog);
+    if (dfa->usable) {
+      dfa->set = xmalloc((size_t)prog->nstate * sizeof(int));
+      dfa->stack = xmalloc((size_t)prog->nstate * sizeof(int));
+      dfa->mark = xcalloc((size_t)prog->nstate, sizeof(*dfa->mark));
+    }
+  }
+  if (!dfa->usable || rex.reg_icombine) {
+    return kDfaUnknown;
+  }
+  if (dfa->nstates == 0 || dfa->ic != rex.reg_ic) {
+    nfa_dfa_clear(dfa);
+    dfa->ic = rex.reg_ic;
+    int nset = 0;
+    nfa_dfa_next_gen(dfa, prog);
+    nfa_dfa_closure(dfa, prog, prog->start, &nset);
+    (void)nfa_dfa_add_state(dfa, prog, nset);
+  }
+
+  int cur = 0;
+  for (const char_u *p = rex.line + col;; ) {
+    if (dfa->states[cur].match) {
+      return kDfaMatch;
+    }
+    int c = *p;
+    if (c == NUL) {
+      return kDfaNoMatch;
+    }
+    int next;
+    if (c < 0x80) {
+      next = dfa->states[cur].next[c];
+      if (next < 0) {
+        next = nfa_dfa_transition(dfa, prog, cur, c);
+        if (next >= 0) {
+          dfa->states[cur].next[c] = next;
+        }
+      }
+      p++;
+    } else {
+      c = utf_ptr2char(p);
+      if (utf_iscomposing(c)) {
+        // nfa_regmatch() skips over composing characters in some states.
+        return kDfaUnknown;
+      }
+      next = nfa_dfa_wide_transition(dfa, prog, cur, c);
+      p += utf_ptr2len(p);
+    }
+    if (next < 0) {
+      // Too many states, the pattern is not suitable for a DFA.
+      nfa_dfa_clear(dfa);
+      dfa->usable = false;
+      return kDfaUnknown;
+    }
+    cur = next;
+  }
+}
+
 /// Match a regexp against a string ("line" points to the string) or multiple
 /// lines (if "line" is NULL, use reg_getline()).
 ///
@@ -6582,6 +7189,11 @@ static long nfa_regexec_both(char_u *line, colnr_T startcol,
     rex.need_clear_zsubexpr = false;
   }
 
+  // Skip the line when it doesn't contain the text every match contains.
+  if (prog->must != NULL && !rex.reg_icombine && !nfa_has_must(prog, col)) {
+    goto theend;
+  }
+
   if (prog->regstart != NUL) {
     /* Skip ahead until a character we know the match must start with.
      * When there is none there is no match. */
@@ -6600,6 +7212,12 @@ static long nfa_regexec_both(char_u *line, colnr_T startcol,
     goto theend;
   }
 
+  // Quickly check whether there is a match at all.
+  if (prog->re_engine != NFA_ENGINE
+      && nfa_dfa_scan(prog, col) == kDfaNoMatch) {
+    goto theend;
+  }
+
   // Set the "nstate" used by nfa_regcomp() to zero to trigger an error when
   // it's accidentally used during execution.
   nstate = 0;
@@ -6716,6 +7334,7 @@ static regprog_T *nfa_regcomp(char_u *expr, int re_flags)
   prog->reganch = nfa_get_reganch(prog->start, 0);
   prog->regstart = nfa_get_regstart(prog->start, 0);
   prog->match_text = nfa_get_match_text(prog->start);
+  prog->must = nfa_get_must(prog->start, prog->nstate, &prog->mustlen);
 
 #ifdef REGEXP_DEBUG
   nfa_postfix_dump(expr, OK);
@@ -6724,6 +7343,7 @@ static regprog_T *nfa_regcomp(char_u *expr, int re_flags)
   /* Remember whether this pattern has any \z specials in it. */
   prog->reghasz = re_has_z;
   prog->pattern = vim_strsave(expr);
+  prog->dfa = NULL;
 #ifdef REGEXP_DEBUG
   nfa_regengine.expr = NULL;
 #endif
@@ -6750,11 +7370,47 @@ static void nfa_regfree(regprog_T *prog)
 {
   if (prog != NULL) {
     xfree(((nfa_regprog_T *)prog)->match_text);
+    xfree(((nfa_regprog_T *)prog)->must);
     xfree(((nfa_regprog_T *)prog)->pattern);
+    nfa_dfa_free(((nfa_regprog_T *)prog)->dfa);
     xfree(prog);
   }
 }
 
+/// Makes a copy of compiled program "prog", for matching on a worker thread
+/// with the same program.  The copy is not cached, free it with
+/// vim_regfree().
+static regprog_T *nfa_regdup(const nfa_regprog_T *prog)
+  FUNC_ATTR_NONNULL_ALL FUNC_ATTR_NONNULL_RET
+{
+  const size_t prog_size = sizeof(nfa_regprog_T)
+                           + sizeof(nfa_state_T) * (size_t)(prog->nstate - 1);
+  nfa_regprog_T *const copy = xmalloc(prog_size);
+  memcpy(copy, prog, prog_size);
+
+  // The states point to each other, relocate them to the copy.
+#define NFA_RELOC(p) \
+  ((p) == NULL ? NULL : copy->state + ((p) - prog->state))
+  copy->start = NFA_RELOC(prog->start);
+  for (int i = 0; i < copy->nstate; i++) {
+    copy->state[i].out = NFA_RELOC(prog->state[i].out);
+    copy->state[i].out1 = NFA_RELOC(prog->state[i].out1);
+  }
+#undef NFA_RELOC
+
+  copy->re_in_use = false;
+  copy->re_cache_key = NULL;
+  if (prog->match_text != NULL) {
+    copy->match_text = vim_strsave(prog->match_text);
+  }
+  if (prog->must != NULL) {
+    copy->must = vim_strsave(prog->must);
+  }
+  copy->pattern = vim_strsave(prog->pattern);
+  copy->dfa = NULL;
+  return (regprog_T *)copy;
+}
+
 /*
  * Match a regexp against a string.
  * "rmp->regprog" is a compiled regexp as returned by nfa_regcomp().
@@ -6774,6 +7430,7 @@ nfa_regexec_nl (
   rex.reg_match = rmp;
   rex.reg_mmatch = NULL;
   rex.reg_maxline = 0;
+  rex.reg_lines = NULL;
   rex.reg_line_lbr = line_lbr;
   rex.reg_buf = curbuf;
   rex.reg_win = NULL;
@@ -6783,6 +7440,38 @@ nfa_regexec_nl (
   return nfa_regexec_both(line, col, NULL, NULL);
 }
 
+/// Checks whether "prog" can be matched on a worker thread against a part of
+/// the lines of a buffer, see vim_regexec_par().  The match must not depend on
+/// other lines, the line number, marks, the cursor or the window, and must not
+/// use state shared between threads.
+static bool nfa_par_usable(const nfa_regprog_T *prog)
+{
+  if (prog->has_backref || prog->reghasz == REX_SET
+      || (prog->regflags & RF_HASNL)) {
+    return false;
+  }
+  for (int i = 0; i < prog->nstate; i++) {
+    const int c = prog->state[i].c;
+    if (c >= NFA_START_INVISIBLE_BEFORE
+        && c <= NFA_START_INVISIBLE_BEFORE_NEG_FIRST) {
+      return false;  // look-behind may look in the previous line
+    }
+    if ((c >= NFA_ZREF1 && c <= NFA_ZREF9)
+        || (c >= NFA_CURSOR && c <= NFA_VISUAL && c != NFA_COL
+            && c != NFA_COL_GT && c != NFA_COL_LT)) {
+      return false;
+    }
+    switch (c) {
+    case NFA_BOF:
+    case NFA_EOF:
+      return false;
+    default:
+      break;
+    }
+  }
+  return true;
+}
+
 /// Matches a regexp against multiple lines.
 /// "rmp->regprog" is a compiled regexp as returned by vim_regcomp().
 /// Uses curbuf for line count and 'iskeyword'.
@@ -6827,7 +7516,10 @@ static long nfa_regexec_multi(regmmatch_T *rmp, win_T *win, buf_T *buf,
   rex.reg_buf = buf;
   rex.reg_win = win;
   rex.reg_firstlnum = lnum;
-  rex.reg_maxline = rex.reg_buf->b_ml.ml_line_count - lnum;
+  rex.reg_lines = regexec_lines;
+  rex.reg_maxline = (regexec_lines != NULL
+                     ? regexec_nlines
+                     : rex.reg_buf->b_ml.ml_line_count) - lnum;
   rex.reg_line_lbr = false;
   rex.reg_ic = rmp->rmm_ic;
   rex.reg_icombine = false;
@@ -12,10 +12,72 @@
 #include "nvim/option.h"
 #include "nvim/ex_cmds.h"
 #include "nvim/ex_cmds2.h"
+#include "nvim/fileio.h"
+#include "nvim/hashtab.h"
+#include "nvim/lib/kvec.h"
+#include "nvim/main.h"
+#include "nvim/memory.h"
 #include "nvim/misc1.h"
 #include "nvim/os/os.h"
+#include "nvim/path.h"
+#include "nvim/regexp.h"
 #include "nvim/runtime.h"
 
+/// Entry of a directory listed in the runtime file index
+typedef struct {
+  char *name;   ///< File name.
+  bool is_dir;  ///< Whether it is a directory (or a link to one).
+} RtpIndexEntry;
+
+/// Directory listed in the runtime file index
+///
+/// Like with other hashtab users the key is contained within the item.
+typedef struct {
+  uv_fs_event_t watcher;  ///< Watches the directory for changes.
+  bool watching;          ///< Whether "watcher" was started.
+  bool stale;             ///< Directory changed since it was listed.
+  kvec_t(RtpIndexEntry) entries;  ///< Directory contents, sorted by name.
+  char_u path[];          ///< Directory path, key in rtp_index.
+} RtpIndexDir;
+
+#define HI2RID(hi) \
+    ((RtpIndexDir *)((hi)->hi_key - offsetof(RtpIndexDir, path)))
+
+/// Maximum number of directories kept up to date with a watcher.
+///
+/// Directories listed after this limit is reached are listed again each time
+/// they are searched.
+#define RTP_INDEX_MAX_WATCHED 2048
+
+/// Runtime file index: contents of directories searched by do_in_path().
+///
+/// Filled lazily while 'runtimepath' and 'packpath' are searched, so that
+/// repeated lookups (:runtime, filetype plugins, syntax files, require())
+/// do not read the same directories over and over again.  Listings are
+/// invalidated by file system watchers, and by runtime_index_invalidate()
+/// for files written by Nvim itself.
+static hashtab_T rtp_index = { .ht_array = NULL };
+
+/// Number of directories in rtp_index with a started watcher.
+static size_t rtp_index_watched = 0;
+
+/// Files matching a source_all_matches() pattern, found in advance
+typedef struct {
+  char_u *pat;      ///< Pattern, as given to source_all_matches().
+  size_t dirlen;    ///< Length of the package directory at the start of "pat".
+  int num_files;    ///< Number of matches.
+  char_u **files;   ///< Matches, as returned by gen_expand_wildcards().
+} PluginMatches;
+
+/// Matches found by load_start_packages() before loading packages.
+static garray_T plugin_matches = GA_EMPTY_INIT_VALUE;
+
+/// Patterns of plugin files sourced by load_pack_plugin().
+static const char *const pack_plugin_pats[] = {
+  "%s/plugin/**/*.vim",  // NOLINT
+  "%s/plugin/**/*.lua",  // NOLINT
+};
+
 #ifdef INCLUDE_GENERATED_DECLARATIONS
 # include "runtime.c.generated.h"
 #endif
@@ -52,6 +114,393 @@ static void source_callback(char_u *fname, void *cookie)
   (void)do_source(fname, false, DOSO_NONE);
 }
 
+/// Callback which adds a copy of "fname" to the garray_T in "cookie".
+static void collect_callback(char_u *fname, void *cookie)
+{
+  GA_APPEND(char_u *, (garray_T *)cookie, vim_strsave(fname));
+}
+
+static int rtp_index_entry_cmp(const void *a, const void *b)
+{
+  return strcmp(((const RtpIndexEntry *)a)->name,
+                ((const RtpIndexEntry *)b)->name);
+}
+
+static void rtp_index_clear_entries(RtpIndexDir *rid)
+{
+  for (size_t i = 0; i < kv_size(rid->entries); i++) {
+    xfree(kv_A(rid->entries, i).name);
+  }
+  kv_size(rid->entries) = 0;
+}
+
+/// Read contents of the directory into "rid".
+///
+/// @return false if the directory cannot be read.
+static bool rtp_index_scan(RtpIndexDir *rid)
+{
+  Directory dir;
+  if (!os_scandir(&dir, (char *)rid->path)) {
+    return false;
+  }
+  rtp_index_clear_entries(rid);
+  const size_t pathlen = STRLEN(rid->path);
+  char *full = NULL;
+  const char *name;
+  while ((name = os_scandir_next(&dir)) != NULL) {
+    uv_dirent_type_t type = os_scandir_type(&dir);
+    bool is_dir = type == UV_DIRENT_DIR;
+    if (type != UV_DIRENT_DIR && type != UV_DIRENT_FILE) {
+      // Links and unknown types: need to ask the file system.
+      full = xrealloc(full, pathlen + strlen(name) + 2);
+      STRCPY(full, rid->path);
+      add_pathsep(full);
+      STRCAT(full, name);
+      is_dir = os_isdir((char_u *)full);
+    }
+    kv_push(rid->entries, ((RtpIndexEntry) {
+      .name = xstrdup(name),
+      .is_dir = is_dir,
+    }));
+  }
+  os_closedir(&dir);
+  xfree(full);
+  if (kv_size(rid->entries) > 1) {
+    qsort(rid->entries.items, kv_size(rid->entries), sizeof(RtpIndexEntry),
+          rtp_index_entry_cmp);
+  }
+  rid->stale = false;
+  return true;
+}
+
+static void rtp_index_watcher_cb(uv_fs_event_t *handle, const char *filename,
+                                 int events, int status)
+{
+  ((RtpIndexDir *)handle->data)->stale = true;
+}
+
+static void rtp_index_close_cb(uv_handle_t *handle)
+{
+  RtpIndexDir *const rid = handle->data;
+  rtp_index_clear_entries(rid);
+  kv_destroy(rid->entries);
+  xfree(rid);
+}
+
+/// Remove directory from the index and free it.
+static void rtp_index_remove(hashitem_T *hi)
+{
+  RtpIndexDir *const rid = HI2RID(hi);
+  hash_remove(&rtp_index, hi);
+  if (rid->watching) {
+    rtp_index_watched--;
+    uv_fs_event_stop(&rid->watcher);
+    uv_close((uv_handle_t *)&rid->watcher, rtp_index_close_cb);
+  } else {
+    rtp_index_clear_entries(rid);
+    kv_destroy(rid->entries);
+    xfree(rid);
+  }
+}
+
+/// Get up-to-date contents of a directory, listing it if needed.
+///
+/// @param[in]  path  Absolute directory path, without trailing separator.
+///
+/// @return NULL if the directory cannot be read.
+static RtpIndexDir *rtp_index_get(const char_u *path)
+{
+  if (rtp_index.ht_array == NULL) {
+    hash_init(&rtp_index);
+  }
+  const size_t len = STRLEN(path);
+  const hash_T hash = hash_hash(path);
+  hashitem_T *const hi = hash_lookup(&rtp_index, (const char *)path, len,
+                                     hash);
+  if (!HASHITEM_EMPTY(hi)) {
+    RtpIndexDir *const rid = HI2RID(hi);
+    if (rid->watching && !rid->stale) {
+      return rid;
+    }
+    if (!rtp_index_scan(rid)) {
+      rtp_index_remove(hi);
+      return NULL;
+    }
+    rid->stale = !rid->watching;
+    return rid;
+  }
+
+  RtpIndexDir *const rid = xmalloc(offsetof(RtpIndexDir, path) + len + 1);
+  memcpy(rid->path, path, len + 1);
+  kv_init(rid->entries);
+  rid->watching = false;
+  if (!rtp_index_scan(rid)) {
+    kv_destroy(rid->entries);
+    xfree(rid);
+    return NULL;
+  }
+  if (rtp_index_watched < RTP_INDEX_MAX_WATCHED
+      && uv_fs_event_init(&main_loop.uv, &rid->watcher) == 0) {
+    rid->watcher.data = rid;
+    if (uv_fs_event_start(&rid->watcher, rtp_index_watcher_cb,
+                          (const char *)rid->path, 0) != 0) {
+      // Not kept in the index: the listing is used only by the current
+      // search, rid is freed once the handle is closed.
+      uv_close((uv_handle_t *)&rid->watcher, rtp_index_close_cb);
+      return rid;
+    }
+    rid->watching = true;
+    rtp_index_watched++;
+  }
+  // Directories without a watcher are never trusted, list them again next
+  // time.
+  rid->stale = !rid->watching;
+  hash_add_item(&rtp_index, hi, rid->path, hash);
+  return rid;
+}
+
+/// Find a file name in the listing of a directory.
+static const RtpIndexEntry *rtp_index_find(const RtpIndexDir *rid,
+                                           const char *name)
+{
+  if (!p_fic) {
+    const RtpIndexEntry key = { .name = (char *)name };
+    return bsearch(&key, rid->entries.items, kv_size(rid->entries),
+                   sizeof(RtpIndexEntry), rtp_index_entry_cmp);
+  }
+  for (size_t i = 0; i < kv_size(rid->entries); i++) {
+    if (path_fnamecmp(kv_A(rid->entries, i).name, name) == 0) {
+      return &kv_A(rid->entries, i);
+    }
+  }
+  return NULL;
+}
+
+static int rtp_index_path_cmp(const void *a, const void *b)
+{
+  return pathcmp(*(const char **)a, *(const char **)b, -1);
+}
+
+/// Expand the wildcard pattern "pat" in the directory "buf", using the index.
+///
+/// @param  buf  Buffer of MAXPATHL bytes with the directory path.
+/// @param  buflen  Length of the directory path in "buf".
+/// @param  pat  Remaining part of the pattern: path components separated with
+///              "/", no "**", environment variables, braces or backslashes.
+/// @param  flags  EW_FILE or EW_DIR.
+/// @param  gap  Matches are added here.
+static void rtp_index_match(char_u *buf, size_t buflen, const char_u *pat,
+                            int flags, garray_T *gap)
+{
+  buf[buflen] = NUL;
+  RtpIndexDir *const rid = rtp_index_get(buf);
+  if (rid == NULL || buflen + 2 >= MAXPATHL) {
+    return;
+  }
+  buf[buflen++] = PATHSEP;
+
+  const char_u *pat_end = pat;
+  bool wild = false;
+  while (*pat_end != NUL && !vim_ispathsep(*pat_end)) {
+    wild = wild || vim_strchr((char_u *)"*?[", *pat_end) != NULL;
+    pat_end++;
+  }
+  const bool last = *pat_end == NUL;
+
+  size_t first = 0;
+  size_t count = 0;
+  regmatch_T regmatch = { .regprog = NULL };
+  if (wild) {
+    char_u *const regpat = file_pat_to_reg_pat(pat, pat_end, NULL, false);
+    if (regpat == NULL) {
+      return;
+    }
+#if defined(UNIX)
+    regmatch.rm_ic = p_fic;
+#else
+    regmatch.rm_ic = true;
+#endif
+    emsg_silent++;
+    regmatch.regprog = vim_regcomp(regpat, RE_MAGIC);
+    emsg_silent--;
+    xfree(regpat);
+    if (regmatch.regprog == NULL) {
+      return;
+    }
+    count = kv_size(rid->entries);
+  } else {
+    // Literal file name: no need to look at other entries.
+    char *const name = xmemdupz(pat, (size_t)(pat_end - pat));
+    const RtpIndexEntry *const ent = rtp_index_find(rid, name);
+    xfree(name);
+    if (ent == NULL) {
+      return;
+    }
+    first = (size_t)(ent - rid->entries.items);
+    count = 1;
+  }
+
+  const int start_len = gap->ga_len;
+  for (size_t i = first; i < first + count; i++) {
+    const RtpIndexEntry *const ent = &kv_A(rid->entries, i);
+    if (wild && ((ent->name[0] == '.' && *pat != '.')
+                 || !vim_regexec(&regmatch, (char_u *)ent->name, 0))) {
+      continue;
+    }
+    const size_t namelen = strlen(ent->name);
+    if (buflen + namelen >= MAXPATHL) {
+      continue;
+    }
+    memcpy(buf + buflen, ent->name, namelen + 1);
+    if (!last) {
+      if (ent->is_dir) {
+        rtp_index_match(buf, buflen + namelen, pat_end + 1, flags, gap);
+      }
+    } else if (ent->is_dir ? (flags & EW_DIR) : (flags & EW_FILE)) {
+      char_u *const match = vim_strsave(buf);
+#ifdef BACKSLASH_IN_FILENAME
+      slash_adjust(match);
+#endif
+      GA_APPEND(char_u *, gap, match);
+    }
+  }
+  vim_regfree(regmatch.regprog);
+
+  // Same order as gen_expand_wildcards().
+  if (gap->ga_len - start_len > 1) {
+    qsort(((char_u **)gap->ga_data) + start_len,
+          (size_t)(gap->ga_len - start_len), sizeof(char_u *),
+          rtp_index_path_cmp);
+  }
+}
+
+/// Expand wildcards in a runtime file path using the runtime file index.
+///
+/// Behaves like gen_expand_wildcards() for the patterns used by :runtime,
+/// but avoids reading directories which were read before.
+///
+/// @param  buf  Pattern, in a buffer of MAXPATHL bytes.
+/// @param  tail  Start of the part of "buf" after the 'runtimepath' entry.
+/// @param  flags  EW_FILE or EW_DIR.
+///
+/// @return FAIL if the pattern cannot be expanded with the index, then the
+///         caller must fall back to gen_expand_wildcards().
+static int rtp_index_expand(char_u *buf, char_u *tail, int flags,
+                            int *num_files, char_u ***files)
+{
+  if (tail <= buf + 1 || *tail == NUL || !path_is_absolute(buf)
+      || vim_strpbrk(tail, (char_u *)"`'{$~\\") != NULL
+      || strstr((char *)tail, "**") != NULL) {
+    return FAIL;
+  }
+  // Wildcards in the 'runtimepath' entry itself, e.g. "~/.vim/bundle/*".
+  for (const char_u *p = buf; p < tail; p++) {
+    if (vim_strchr((char_u *)"*?[{`$", *p) != NULL) {
+      return FAIL;
+    }
+  }
+  for (const char_u *p = tail; *p != NUL;) {
+    const char_u *e = p;
+    while (*e != NUL && !vim_ispathsep(*e)) {
+      e++;
+    }
+    if (e == p || (*p == '.' && (e == p + 1 || (p[1] == '.' && e == p + 2)))) {
+      return FAIL;
+    }
+    p = *e == NUL ? e : e + 1;
+  }
+
+  char_u *const pat = vim_strsave(tail);
+  char_u *const dir = xmalloc(MAXPATHL);
+  size_t dirlen = (size_t)(tail - buf);
+  memcpy(dir, buf, dirlen);
+  while (dirlen > 1 && vim_ispathsep(dir[dirlen - 1])) {
+    dirlen--;
+  }
+  garray_T ga;
+  ga_init(&ga, (int)sizeof(char_u *), 10);
+  rtp_index_match(dir, dirlen, pat, flags, &ga);
+  xfree(dir);
+  xfree(pat);
+  *num_files = ga.ga_len;
+  *files = ga.ga_data;
+  return OK;
+}
+
+/// Tell the runtime file index that a file or directory has changed.
+///
+/// File system watchers only report changes when the event loop runs, call
+/// this after Nvim itself created, wrote or removed a file, so that it can be
+/// found by :runtime right away.
+///
+/// @param[in]  fname  Name of the changed file.
+void runtime_index_invalidate(const char *fname)
+  FUNC_ATTR_NONNULL_ALL
+{
+  if ((rtp_index.ht_array == NULL || rtp_index.ht_used == 0)
+      && plugin_matches.ga_len == 0) {
+    return;
+  }
+  char *const full = FullName_save(fname, false);
+  if (full == NULL) {
+    return;
+  }
+  plugin_matches_invalidate(full);
+  // Mark the file itself (when it is an indexed directory) and all its
+  // parents.
+  size_t len = strlen(full);
+  while (len > 0) {
+    full[len] = NUL;
+    hashitem_T *const hi = hash_find(&rtp_index, (char_u *)full);
+    if (!HASHITEM_EMPTY(hi)) {
+      HI2RID(hi)->stale = true;
+    }
+    const size_t prev_len = len;
+    while (len > 0 && !vim_ispathsep(full[len - 1])) {
+      len--;
+    }
+    while (len > 1 && vim_ispathsep(full[len - 1])) {
+      len--;
+    }
+    if (len == prev_len) {
+      break;
+    }
+  }
+  xfree(full);
+}
+
+/// Forget the plugin files found by load_start_packages() for the package
+/// which contains "full", it must be found again.
+static void plugin_matches_invalidate(const char *full)
+{
+  for (int i = 0; i < plugin_matches.ga_len; i++) {
+    PluginMatches *const pm = &((PluginMatches *)plugin_matches.ga_data)[i];
+    if (strncmp(full, (char *)pm->pat, pm->dirlen) == 0
+        && (full[pm->dirlen] == NUL || vim_ispathsep(full[pm->dirlen]))) {
+      xfree(pm->pat);
+      FreeWild(pm->num_files, pm->files);
+      *pm = ((PluginMatches *)plugin_matches.ga_data)[--plugin_matches.ga_len];
+      i--;
+    }
+  }
+}
+
+/// Free the runtime file index and stop its watchers
+///
+/// Must be called before the main loop is closed.
+void runtime_index_teardown(void)
+{
+  if (rtp_index.ht_array == NULL) {
+    return;
+  }
+  hash_lock(&rtp_index);
+  HASHTAB_ITER(&rtp_index, hi, {
+    rtp_index_remove(hi);
+  });
+  hash_clear(&rtp_index);
+  rtp_index.ht_array = NULL;
+}
+
 /// Find the file "name" in all directories in "path" and invoke
 /// "callback(fname, cookie)".
 /// "name" can contain wildcards.
@@ -123,8 +572,9 @@ int do_in_path(char_u *path, char_u *name, int flags,
           }
 
           // Expand wildcards, invoke the callback for each match.
-          if (gen_expand_wildcards(1, &buf, &num_files, &files,
-                                   (flags & DIP_DIR) ? EW_DIR : EW_FILE)
+          const int ew_flags = (flags & DIP_DIR) ? EW_DIR : EW_FILE;
+          if (rtp_index_expand(buf, tail, ew_flags, &num_files, &files) == OK
+              || gen_expand_wildcards(1, &buf, &num_files, &files, ew_flags)
               == OK) {
             for (i = 0; i < num_files; i++) {
               (*callback)(files[i], cookie);
@@ -245,6 +695,51 @@ int source_in_path(char_u *path, char_u *name, int flags)
   return do_in_path_and_pp(path, name, flags, source_callback, NULL);
 }
 
+/// Source plugin files ("plugin/**/*.vim", then "plugin/**/*.lua") in "path".
+///
+/// Like calling source_in_path() for both patterns, but all files are found
+/// first and read in the background (see source_prefetch()) while they are
+/// being sourced.
+void source_plugins_in_path(char_u *path, int flags)
+{
+  garray_T ga_vim;
+  garray_T ga_lua;
+  ga_init(&ga_vim, (int)sizeof(char_u *), 16);
+  ga_init(&ga_lua, (int)sizeof(char_u *), 16);
+  // A Vim plugin may change 'runtimepath', then "path" is freed.
+  const bool use_rtp = path == p_rtp;
+  char_u *const save_path = vim_strsave(path);
+  char_u *const save_pp = vim_strsave(p_pp);
+  do_in_path_and_pp(path, (char_u *)"plugin/**/*.vim", flags,  // NOLINT
+                    collect_callback, &ga_vim);
+  do_in_path_and_pp(path, (char_u *)"plugin/**/*.lua", flags,  // NOLINT
+                    collect_callback, &ga_lua);
+  source_prefetch((char_u **)ga_vim.ga_data, ga_vim.ga_len);
+  source_prefetch((char_u **)ga_lua.ga_data, ga_lua.ga_len);
+  for (int i = 0; i < ga_vim.ga_len; i++) {
+    (void)do_source(((char_u **)ga_vim.ga_data)[i], false, DOSO_NONE);
+  }
+  // A Vim plugin may have changed 'runtimepath' or 'packpath', then find the
+  // Lua plugins again, files read already are still used.
+  if (use_rtp) {
+    path = p_rtp;
+  }
+  if (STRCMP(path, save_path) != 0
+      || ((flags & DIP_START) && STRCMP(p_pp, save_pp) != 0)) {
+    ga_clear_strings(&ga_lua);
+    do_in_path_and_pp(path, (char_u *)"plugin/**/*.lua", flags,  // NOLINT
+                      collect_callback, &ga_lua);
+  }
+  xfree(save_path);
+  xfree(save_pp);
+  for (int i = 0; i < ga_lua.ga_len; i++) {
+    (void)do_source(((char_u **)ga_lua.ga_data)[i], false, DOSO_NONE);
+  }
+  source_prefetch_clear();
+  ga_clear_strings(&ga_vim);
+  ga_clear_strings(&ga_lua);
+}
+
 // Expand wildcards in "pat" and invoke do_source()/nlua_exec_file()
 // for each match.
 static void source_all_matches(char_u *pat)
@@ -252,6 +747,22 @@ static void source_all_matches(char_u *pat)
   int num_files;
   char_u **files;
 
+  // Use matches found by load_start_packages(), if any.
+  for (int i = 0; i < plugin_matches.ga_len; i++) {
+    PluginMatches *const pm = &((PluginMatches *)plugin_matches.ga_data)[i];
+    if (STRCMP(pm->pat, pat) == 0) {
+      num_files = pm->num_files;
+      files = pm->files;
+      xfree(pm->pat);
+      *pm = ((PluginMatches *)plugin_matches.ga_data)[--plugin_matches.ga_len];
+      for (int j = 0; j < num_files; j++) {
+        (void)do_source(files[j], false, DOSO_NONE);
+      }
+      FreeWild(num_files, files);
+      return;
+    }
+  }
+
   if (gen_expand_wildcards(1, &pat, &num_files, &files, EW_FILE) == OK) {
     for (int i = 0; i < num_files; i++) {
       (void)do_source(files[i], false, DOSO_NONE);
@@ -412,10 +923,10 @@ static int load_pack_plugin(char_u *fname)
   size_t len = strlen(ffname) + STRLEN(ftpat);
   char_u *pat = xmallocz(len);
 
-  vim_snprintf((char *)pat, len, "%s/plugin/**/*.vim", ffname);  // NOLINT
-  source_all_matches(pat);
-  vim_snprintf((char *)pat, len, "%s/plugin/**/*.lua", ffname);  // NOLINT
-  source_all_matches(pat);
+  for (size_t i = 0; i < ARRAY_SIZE(pack_plugin_pats); i++) {
+    vim_snprintf((char *)pat, len, pack_plugin_pats[i], ffname);
+    source_all_matches(pat);
+  }
 
   char_u *cmd = vim_strsave((char_u *)"g:did_load_filetypes");
 
@@ -478,14 +989,71 @@ void add_pack_start_dirs(void)
              add_pack_plugin, &APP_ADD_DIR);
 }
 
+/// Find plugin files of the package in "fname" and start reading them in the
+/// background, load_pack_plugin() picks them up later.
+static void prefetch_pack_plugin(char_u *fname)
+{
+  char *const ffname = fix_fname((char *)fname);
+  for (size_t i = 0; i < ARRAY_SIZE(pack_plugin_pats); i++) {
+    const size_t len = strlen(ffname) + strlen(pack_plugin_pats[i]);
+    char_u *pat = xmallocz(len);
+    vim_snprintf((char *)pat, len, pack_plugin_pats[i], ffname);
+    PluginMatches pm = { .pat = pat, .dirlen = strlen(ffname) };
+    if (gen_expand_wildcards(1, &pat, &pm.num_files, &pm.files, EW_FILE)
+        != OK) {
+      pm.num_files = 0;
+      pm.files = NULL;
+    }
+    source_prefetch(pm.files, pm.num_files);
+    ga_grow(&plugin_matches, 1);
+    ((PluginMatches *)plugin_matches.ga_data)[plugin_matches.ga_len++] = pm;
+  }
+  xfree(ffname);
+}
+
 /// Load plugins from all packages in the "start" directory.
+///
+/// Plugin files of all packages are found first and read in the background
+/// while the packages are loaded in order.
 void load_start_packages(void)
 {
+  static bool loading = false;
+
   did_source_packages = true;
+  if (loading) {
+    // ":packloadall!" from a plugin: load without reading files in advance.
+    do_in_path(p_pp, (char_u *)"pack/*/start/*", DIP_ALL + DIP_DIR,  // NOLINT
+               add_pack_plugin, &APP_LOAD);
+    do_in_path(p_pp, (char_u *)"start/*", DIP_ALL + DIP_DIR,  // NOLINT
+               add_pack_plugin, &APP_LOAD);
+    return;
+  }
+  loading = true;
+
+  garray_T dirs;
+  ga_init(&dirs, (int)sizeof(char_u *), 16);
   do_in_path(p_pp, (char_u *)"pack/*/start/*", DIP_ALL + DIP_DIR,  // NOLINT
-             add_pack_plugin, &APP_LOAD);
+             collect_callback, &dirs);
   do_in_path(p_pp, (char_u *)"start/*", DIP_ALL + DIP_DIR,  // NOLINT
-             add_pack_plugin, &APP_LOAD);
+             collect_callback, &dirs);
+
+  ga_init(&plugin_matches, (int)sizeof(PluginMatches), 32);
+  for (int i = 0; i < dirs.ga_len; i++) {
+    prefetch_pack_plugin(((char_u **)dirs.ga_data)[i]);
+  }
+  for (int i = 0; i < dirs.ga_len; i++) {
+    add_pack_plugin(((char_u **)dirs.ga_data)[i], &APP_LOAD);
+  }
+
+  for (int i = 0; i < plugin_matches.ga_len; i++) {
+    PluginMatches *const pm = &((PluginMatches *)plugin_matches.ga_data)[i];
+    xfree(pm->pat);
+    FreeWild(pm->num_files, pm->files);
+  }
+  ga_clear(&plugin_matches);
+  source_prefetch_clear();
+  ga_clear_strings(&dirs);
+  loading = false;
 }
 
 // ":packloadall"
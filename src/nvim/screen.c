@@ -65,6 +65,7 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "nvim/latency.h"
 #include "nvim/log.h"
 #include "nvim/vim.h"
 #include "nvim/ascii.h"
@@ -111,6 +112,7 @@
 #include "nvim/strings.h"
 #include "nvim/syntax.h"
 #include "nvim/terminal.h"
+#include "nvim/trace.h"
 #include "nvim/ui.h"
 #include "nvim/ui_compositor.h"
 #include "nvim/undo.h"
@@ -363,6 +365,8 @@ int update_screen(int type)
     return FAIL;
   }
   updating_screen = 1;
+  const TraceSpan trace_span = trace_begin();
+  const LatencySpan latency_span = latency_begin(kLatencyRedraw);
 
   display_tick++;           // let syntax code know we're in a next round of
                             // display updating
@@ -653,6 +657,9 @@ int update_screen(int type)
 
   // either cmdline is cleared, not drawn or mode is last drawn
   cmdline_was_last_drawn = false;
+  syntax_idle_schedule();
+  latency_end(&latency_span);
+  trace_end(trace_span, "ui", "redraw", NULL);
   return OK;
 }
 
@@ -8,6 +8,7 @@
 #include <inttypes.h>
 #include <errno.h>
 #include <assert.h>
+#include <fcntl.h>
 
 #include <msgpack.h>
 #include <uv.h>
@@ -53,6 +54,10 @@
 # include ENDIAN_INCLUDE_FILE
 #endif
 
+#ifdef UNIX
+# include <sys/file.h>
+#endif
+
 // Note: when using bufset hash pointers are intentionally casted to uintptr_t
 // and not to khint32_t or khint64_t: this way compiler must give a warning
 // (-Wconversion) when types change.
@@ -65,6 +70,7 @@ KHASH_SET_INIT_INT64(bufset)
 #endif
 KHASH_MAP_INIT_STR(fnamebufs, buf_T *)
 KHASH_SET_INIT_STR(strset)
+KHASH_MAP_INIT_STR(fnameidx, size_t)
 
 #define copy_option_part(src, dest, ...) \
     ((char *) copy_option_part((char_u **) src, (char_u *) dest, __VA_ARGS__))
@@ -407,6 +413,8 @@ typedef struct sd_read_def {
   const char *error;      ///< Error message in case of error.
   uintmax_t fpos;         ///< Current position (amount of bytes read since
                           ///< reader structure initialization). May overflow.
+  unsigned raw_flags;     ///< Entries of these types (see SRNIFlags) are not
+                          ///< decoded, but returned as kSDItemUnknown.
 } ShaDaReadDef;
 
 struct sd_write_def;
@@ -429,6 +437,28 @@ typedef struct sd_write_def {
   const char *error;       ///< Error message in case of error.
 } ShaDaWriteDef;
 
+/// Minimal amount of bytes shada_append() may add before the file is compacted
+#define SHADA_APPEND_MIN_GROWTH (64 * 1024)
+
+/// ShaDa file the current state was merged with, see shada_append()
+static char *sd_sync_fname = NULL;
+/// Entries older than this are in sd_sync_fname, 0 if this is not known
+static Timestamp sd_sync_time = 0;
+/// Size of sd_sync_fname when it was last read or written as a whole
+static uint64_t sd_sync_size = 0;
+
+/// History entries read by shada_read_startup() and not decoded yet
+static msgpack_sbuffer sd_deferred_history = { .data = NULL };
+/// Register entries read by shada_read_startup() and not decoded yet
+static msgpack_sbuffer sd_deferred_registers = { .data = NULL };
+
+/// File for v:oldfiles, with the time of its newest mark
+typedef struct {
+  char *fname;          ///< File name.
+  Timestamp timestamp;  ///< Greatest timestamp of the marks in the file.
+  size_t idx;           ///< Position of the file in the ShaDa file.
+} OldFile;
+
 #ifdef INCLUDE_GENERATED_DECLARATIONS
 # include "shada.c.generated.h"
 #endif
@@ -697,6 +727,21 @@ static ptrdiff_t write_file(ShaDaWriteDef *const sd_writer,
   return ret;
 }
 
+/// Wrapper for writing to msgpack_sbuffer
+///
+/// @return -1 or number of bytes written.
+static ptrdiff_t write_sbuf(ShaDaWriteDef *const sd_writer,
+                            const void *const src,
+                            const size_t size)
+  FUNC_ATTR_NONNULL_ALL FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  if (msgpack_sbuffer_write(sd_writer->cookie, src, size) != 0) {
+    sd_writer->error = os_strerror(UV_ENOMEM);
+    return -1;
+  }
+  return (ptrdiff_t)size;
+}
+
 /// Wrapper for closing file descriptors opened for reading
 static void close_sd_reader(ShaDaReadDef *const sd_reader)
   FUNC_ATTR_NONNULL_ALL
@@ -893,6 +938,19 @@ static int shada_read_file(const char *const file, const int flags)
     xfree(fname);
     return FAIL;
   }
+  if (flags & kShaDaWantInfo) {
+    // Entries deferred at startup were read before this file.
+    shada_load_history();
+    shada_load_registers();
+    FileInfo info;
+    if (sd_sync_fname == NULL
+        && os_fileinfo_fd(file_fd(sd_reader.cookie), &info)) {
+      shada_set_synced(fname, os_time(), os_fileinfo_size(&info));
+    } else if (sd_sync_fname == NULL || !strequal(fname, sd_sync_fname)) {
+      // Entries from another file are not in the one written on exit.
+      sd_sync_time = 0;
+    }
+  }
   xfree(fname);
 
   shada_read(&sd_reader, flags);
@@ -901,6 +959,50 @@ static int shada_read_file(const char *const file, const int flags)
   return OK;
 }
 
+/// Remember that the current state was merged with a ShaDa file
+///
+/// @param[in]  fname  Name of the file read or written.
+/// @param[in]  time   Time when reading or writing started.
+/// @param[in]  size   Size of the file.
+static void shada_set_synced(const char *const fname, const Timestamp time,
+                             const uint64_t size)
+  FUNC_ATTR_NONNULL_ALL
+{
+  if (sd_sync_fname == NULL || !strequal(fname, sd_sync_fname)) {
+    xfree(sd_sync_fname);
+    sd_sync_fname = xstrdup(fname);
+  }
+  sd_sync_time = time;
+  sd_sync_size = size;
+}
+
+#ifdef UNIX
+/// Lock ShaDa file for writing
+///
+/// Blocks while another Neovim instance holds the lock. The lock is released
+/// when the file is closed.
+///
+/// @param[in]  fd     File descriptor of the opened ShaDa file.
+/// @param[in]  fname  Name of the ShaDa file.
+///
+/// @return false if the file was replaced or removed before it was locked,
+///         then it should be opened again.
+static bool shada_lock(const int fd, const char *const fname)
+  FUNC_ATTR_NONNULL_ALL FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  if (flock(fd, LOCK_EX) != 0) {
+    // Locking is not supported (e.g. some network file systems), go on
+    // without it.
+    return true;
+  }
+  FileInfo fd_info;
+  FileInfo fname_info;
+  return (os_fileinfo_fd(fd, &fd_info)
+          && os_fileinfo(fname, &fname_info)
+          && os_fileinfo_id_equal(&fd_info, &fname_info));
+}
+#endif
+
 /// Wrapper for hist_iter() function which produces ShadaEntry values
 ///
 /// @param[in]   iter          Current iteration state.
@@ -1165,6 +1267,59 @@ static inline bool marks_equal(const pos_T a, const pos_T b)
     } \
   } while (0)
 
+/// Add numbered mark read from ShaDa file
+///
+/// Names of numbered marks are ignored, marks are sorted by timestamp like when
+/// merging them in shada_read_when_writing().
+///
+/// @param[in,out]  marks  Numbered marks read so far, newest first.
+/// @param[in]      fm     Mark to add. It is freed if not used.
+static void add_numbered_mark(xfmark_T *const marks, const xfmark_T fm)
+  FUNC_ATTR_NONNULL_ALL
+{
+  size_t idx = 0;
+  for (; idx < EXTRA_MARKS && marks[idx].fmark.mark.lnum != 0; idx++) {
+    const xfmark_T *const cur = &marks[idx];
+    // Ignore duplicates.
+    if (cur->fmark.timestamp == fm.fmark.timestamp
+        && cur->fmark.additional_data == NULL
+        && fm.fmark.additional_data == NULL
+        && marks_equal(cur->fmark.mark, fm.fmark.mark)
+        && (fm.fname == NULL
+            ? cur->fname == NULL && cur->fmark.fnum == fm.fmark.fnum
+            : cur->fname != NULL && strcmp((char *)cur->fname,
+                                           (char *)fm.fname) == 0)) {
+      free_xfmark(fm);
+      return;
+    }
+    if (cur->fmark.timestamp < fm.fmark.timestamp) {
+      break;
+    }
+  }
+  if (idx == EXTRA_MARKS) {
+    free_xfmark(fm);
+    return;
+  }
+  if (marks[EXTRA_MARKS - 1].fmark.mark.lnum != 0) {
+    free_xfmark(marks[EXTRA_MARKS - 1]);
+  }
+  memmove(marks + idx + 1, marks + idx,
+          sizeof(marks[0]) * (EXTRA_MARKS - 1 - idx));
+  marks[idx] = fm;
+}
+
+/// Compare two OldFile entries: most recently used first, then in file order
+static int compare_oldfiles(const void *a, const void *b)
+  FUNC_ATTR_WARN_UNUSED_RESULT FUNC_ATTR_PURE
+{
+  const OldFile *const a_of = a;
+  const OldFile *const b_of = b;
+  if (a_of->timestamp != b_of->timestamp) {
+    return a_of->timestamp > b_of->timestamp ? -1 : 1;
+  }
+  return a_of->idx < b_of->idx ? -1 : (a_of->idx > b_of->idx ? 1 : 0);
+}
+
 /// Read data from ShaDa file
 ///
 /// @param[in]  sd_reader  Structure containing file reader definition.
@@ -1201,16 +1356,27 @@ static void shada_read(ShaDaReadDef *const sd_reader, const int flags)
     // Nothing to do.
     return;
   }
+  if (flags & kShaDaDeferData) {
+    sd_reader->raw_flags = srni_flags & (kSDReadHistory | kSDReadRegisters);
+  }
+  const bool read_history = ((srni_flags & kSDReadHistory)
+                             && !(sd_reader->raw_flags & kSDReadHistory));
   HistoryMergerState hms[HIST_COUNT];
-  if (srni_flags & kSDReadHistory) {
+  if (read_history) {
     for (uint8_t i = 0; i < HIST_COUNT; i++) {
       hms_init(&hms[i], i, (size_t) p_hi, true, true);
     }
   }
   ShadaEntry cur_entry;
+  // Parts of the file appended by shada_append() each have their own buffer
+  // list, numbered marks and order of files, these are merged below.
+  ShadaEntry buflist = { .type = kSDItemMissing };
+  xfmark_T numbered_marks[EXTRA_MARKS];
+  memset(numbered_marks, 0, sizeof(numbered_marks));
   khash_t(bufset) cl_bufs = KHASH_EMPTY_TABLE(bufset);
   khash_t(fnamebufs) fname_bufs = KHASH_EMPTY_TABLE(fnamebufs);
-  khash_t(strset) oldfiles_set = KHASH_EMPTY_TABLE(strset);
+  khash_t(fnameidx) oldfiles_idx = KHASH_EMPTY_TABLE(fnameidx);
+  kvec_t(OldFile) oldfiles = KV_INITIAL_VALUE;
   if (get_old_files && (oldfiles_list == NULL || force)) {
     oldfiles_list = tv_list_alloc(kListLenUnknown);
     set_vim_var_list(VV_OLDFILES, oldfiles_list);
@@ -1239,6 +1405,12 @@ static void shada_read(ShaDaReadDef *const sd_reader, const int flags)
         abort();
       }
       case kSDItemUnknown: {
+        // History and registers not decoded because of kShaDaDeferData.
+        if (cur_entry.data.unknown_item.type == kSDItemHistoryEntry
+            || cur_entry.data.unknown_item.type == kSDItemRegister) {
+          shada_defer_entry(&cur_entry);
+        }
+        shada_free_shada_entry(&cur_entry);
         break;
       }
       case kSDItemHeader: {
@@ -1362,7 +1534,10 @@ static void shada_read(ShaDaReadDef *const sd_reader, const int flags)
             .additional_data = cur_entry.data.filemark.additional_data,
           },
         };
-        if (cur_entry.type == kSDItemGlobalMark) {
+        if (cur_entry.type == kSDItemGlobalMark
+            && ascii_isdigit(cur_entry.data.filemark.name)) {
+          add_numbered_mark(numbered_marks, fm);
+        } else if (cur_entry.type == kSDItemGlobalMark) {
           if (!mark_set_global(cur_entry.data.filemark.name, fm, !force)) {
             shada_free_shada_entry(&cur_entry);
             break;
@@ -1390,42 +1565,46 @@ static void shada_read(ShaDaReadDef *const sd_reader, const int flags)
         break;
       }
       case kSDItemBufferList: {
-        for (size_t i = 0; i < cur_entry.data.buffer_list.size; i++) {
-          char *const sfname = path_try_shorten_fname(
-              cur_entry.data.buffer_list.buffers[i].fname);
-          buf_T *const buf = buflist_new(
-              cur_entry.data.buffer_list.buffers[i].fname, sfname, 0,
-              BLN_LISTED);
-          if (buf != NULL) {
-            RESET_FMARK(&buf->b_last_cursor,
-                        cur_entry.data.buffer_list.buffers[i].pos, 0);
-            buflist_setfpos(buf, curwin, buf->b_last_cursor.mark.lnum,
-                            buf->b_last_cursor.mark.col, false);
-            buf->additional_data =
-                cur_entry.data.buffer_list.buffers[i].additional_data;
-            cur_entry.data.buffer_list.buffers[i].additional_data = NULL;
-          }
+        if (buflist.type == kSDItemMissing
+            || cur_entry.timestamp >= buflist.timestamp) {
+          shada_free_shada_entry(&buflist);
+          buflist = cur_entry;
+        } else {
+          shada_free_shada_entry(&cur_entry);
         }
-        shada_free_shada_entry(&cur_entry);
         break;
       }
       case kSDItemChange:
       case kSDItemLocalMark: {
-        if (get_old_files && !in_strset(&oldfiles_set,
-                                        cur_entry.data.filemark.fname)) {
-          char *fname = cur_entry.data.filemark.fname;
-          if (want_marks) {
-            // Do not bother with allocating memory for the string if already
-            // allocated string from cur_entry can be used. It cannot be used if
-            // want_marks is set because this way it may be used for a mark.
-            fname = xstrdup(fname);
-          }
+        if (get_old_files) {
           int kh_ret;
-          (void)kh_put(strset, &oldfiles_set, fname, &kh_ret);
-          tv_list_append_allocated_string(oldfiles_list, fname);
-          if (!want_marks) {
-            // Avoid free because this string was already used.
-            cur_entry.data.filemark.fname = NULL;
+          const khiter_t k = kh_put(fnameidx, &oldfiles_idx,
+                                    cur_entry.data.filemark.fname, &kh_ret);
+          if (kh_ret > 0) {
+            char *fname = cur_entry.data.filemark.fname;
+            if (want_marks) {
+              // Do not bother with allocating memory for the string if already
+              // allocated string from cur_entry can be used. It cannot be used
+              // if want_marks is set because this way it may be used for
+              // a mark.
+              fname = xstrdup(fname);
+            }
+            kh_key(&oldfiles_idx, k) = fname;
+            kh_val(&oldfiles_idx, k) = kv_size(oldfiles);
+            kv_push(oldfiles, ((OldFile) {
+              .fname = fname,
+              .timestamp = cur_entry.timestamp,
+              .idx = kv_size(oldfiles),
+            }));
+            if (!want_marks) {
+              // Avoid free because this string was already used.
+              cur_entry.data.filemark.fname = NULL;
+            }
+          } else {
+            OldFile *const oldfile = &kv_A(oldfiles, kh_val(&oldfiles_idx, k));
+            if (cur_entry.timestamp > oldfile->timestamp) {
+              oldfile->timestamp = cur_entry.timestamp;
+            }
           }
         }
         if (!want_marks) {
@@ -1469,13 +1648,46 @@ static void shada_read(ShaDaReadDef *const sd_reader, const int flags)
     }
   }
 shada_read_main_cycle_end:
+  if (buflist.type == kSDItemBufferList) {
+    for (size_t i = 0; i < buflist.data.buffer_list.size; i++) {
+      char *const sfname = path_try_shorten_fname(
+          buflist.data.buffer_list.buffers[i].fname);
+      buf_T *const buf = buflist_new(
+          buflist.data.buffer_list.buffers[i].fname, sfname, 0,
+          BLN_LISTED);
+      if (buf != NULL) {
+        RESET_FMARK(&buf->b_last_cursor,
+                    buflist.data.buffer_list.buffers[i].pos, 0);
+        buflist_setfpos(buf, curwin, buf->b_last_cursor.mark.lnum,
+                        buf->b_last_cursor.mark.col, false);
+        buf->additional_data =
+            buflist.data.buffer_list.buffers[i].additional_data;
+        buflist.data.buffer_list.buffers[i].additional_data = NULL;
+      }
+    }
+    shada_free_shada_entry(&buflist);
+  }
+  for (size_t i = 0; i < EXTRA_MARKS; i++) {
+    if (numbered_marks[i].fmark.mark.lnum != 0
+        && !mark_set_global((char)('0' + (int)i), numbered_marks[i], !force)) {
+      free_xfmark(numbered_marks[i]);
+    }
+  }
+  if (get_old_files) {
+    // Files are listed most recently used first.
+    qsort(oldfiles.items, kv_size(oldfiles), sizeof(oldfiles.items[0]),
+          &compare_oldfiles);
+    for (size_t i = 0; i < kv_size(oldfiles); i++) {
+      tv_list_append_allocated_string(oldfiles_list, kv_A(oldfiles, i).fname);
+    }
+  }
   // Warning: shada_hist_iter returns ShadaEntry elements which use strings from
   //          original history list. This means that once such entry is removed
   //          from the history Neovim array will no longer be valid. To reduce
   //          amount of memory allocations ShaDa file reader allocates enough
   //          memory for the history string itself and separator character which
   //          may be assigned right away.
-  if (srni_flags & kSDReadHistory) {
+  if (read_history) {
     for (uint8_t i = 0; i < HIST_COUNT; i++) {
       hms_insert_whole_neovim_history(&hms[i]);
       clr_history(i);
@@ -1502,7 +1714,8 @@ shada_read_main_cycle_end:
     xfree((void *) key);
   })
   kh_dealloc(fnamebufs, &fname_bufs);
-  kh_dealloc(strset, &oldfiles_set);
+  kh_dealloc(fnameidx, &oldfiles_idx);
+  kv_destroy(oldfiles);
 }
 
 /// Default shada file location: cached path
@@ -2566,8 +2779,11 @@ static inline void find_removable_bufs(khash_t(bufset) *removable_bufs)
 /// @param[in]  sd_reader  Structure containing file reader definition. If it is
 ///                        not NULL then contents of this file will be merged
 ///                        with current Neovim runtime.
+/// @param[in]  since      Skip entries older than this, except for the header,
+///                        buffer list and variables.
 static ShaDaWriteResult shada_write(ShaDaWriteDef *const sd_writer,
-                                    ShaDaReadDef *const sd_reader)
+                                    ShaDaReadDef *const sd_reader,
+                                    const Timestamp since)
   FUNC_ATTR_NONNULL_ARG(1)
 {
   ShaDaWriteResult ret = kSDWriteSuccessfull;
@@ -2593,13 +2809,20 @@ static ShaDaWriteResult shada_write(ShaDaWriteDef *const sd_writer,
   const bool dump_global_marks = get_shada_parameter('f') != 0;
   bool dump_history = false;
 
+  // History and registers which were not loaded yet were not used, so when
+  // only writing what changed they have nothing to write.
+  const bool history_deferred = (since != 0
+                                 && sd_deferred_history.data != NULL);
+  const bool registers_deferred = (since != 0
+                                   && sd_deferred_registers.data != NULL);
+
   // Initialize history merger
   for (uint8_t i = 0; i < HIST_COUNT; i++) {
     long num_saved = get_shada_parameter(hist_type2char(i));
     if (num_saved == -1) {
       num_saved = p_hi;
     }
-    if (num_saved > 0) {
+    if (num_saved > 0 && !history_deferred) {
       dump_history = true;
       dump_one_history[i] = true;
       hms_init(&wms->hms[i], i, (size_t) num_saved, sd_reader != NULL, false);
@@ -2824,7 +3047,7 @@ static ShaDaWriteResult shada_write(ShaDaWriteDef *const sd_writer,
   }
 
   // Initialize registers
-  if (dump_registers) {
+  if (dump_registers && !registers_deferred) {
     shada_initialize_registers(wms, max_reg_lines);
   }
 
@@ -2925,7 +3148,8 @@ static ShaDaWriteResult shada_write(ShaDaWriteDef *const sd_writer,
 #define PACK_WMS_ARRAY(wms_array) \
   do { \
     for (size_t i_ = 0; i_ < ARRAY_SIZE(wms_array); i_++) { \
-      if (wms_array[i_].data.type != kSDItemMissing) { \
+      if (wms_array[i_].data.type != kSDItemMissing \
+          && wms_array[i_].data.timestamp >= since) { \
         if (shada_pack_pfreed_entry(packer, wms_array[i_], max_kbyte) \
             == kSDWriteFailed) { \
           ret = kSDWriteFailed; \
@@ -2938,6 +3162,9 @@ static ShaDaWriteResult shada_write(ShaDaWriteDef *const sd_writer,
   PACK_WMS_ARRAY(wms->numbered_marks);
   PACK_WMS_ARRAY(wms->registers);
   for (size_t i = 0; i < wms->jumps_size; i++) {
+    if (wms->jumps[i].data.timestamp < since) {
+      continue;
+    }
     if (shada_pack_pfreed_entry(packer, wms->jumps[i], max_kbyte)
         == kSDWriteFailed) {
       ret = kSDWriteFailed;
@@ -2946,7 +3173,8 @@ static ShaDaWriteResult shada_write(ShaDaWriteDef *const sd_writer,
   }
 #define PACK_WMS_ENTRY(wms_entry) \
   do { \
-    if (wms_entry.data.type != kSDItemMissing) { \
+    if (wms_entry.data.type != kSDItemMissing \
+        && wms_entry.data.timestamp >= since) { \
       if (shada_pack_pfreed_entry(packer, wms_entry, max_kbyte) \
           == kSDWriteFailed) { \
         ret = kSDWriteFailed; \
@@ -2975,6 +3203,9 @@ static ShaDaWriteResult shada_write(ShaDaWriteDef *const sd_writer,
   for (size_t i = 0; i < file_markss_to_dump; i++) {
     PACK_WMS_ARRAY(all_file_markss[i]->marks);
     for (size_t j = 0; j < all_file_markss[i]->changes_size; j++) {
+      if (all_file_markss[i]->changes[j].data.timestamp < since) {
+        continue;
+      }
       if (shada_pack_pfreed_entry(packer, all_file_markss[i]->changes[j],
                                   max_kbyte) == kSDWriteFailed) {
         ret = kSDWriteFailed;
@@ -3000,6 +3231,9 @@ static ShaDaWriteResult shada_write(ShaDaWriteDef *const sd_writer,
       if (dump_one_history[i]) {
         hms_insert_whole_neovim_history(&wms->hms[i]);
         HMS_ITER(&wms->hms[i], cur_entry, {
+          if (cur_entry->data.timestamp < since) {
+            continue;
+          }
           if (shada_pack_pfreed_entry(
               packer, (PossiblyFreedShadaEntry) {
                 .data = cur_entry->data,
@@ -3045,6 +3279,9 @@ int shada_write_file(const char *const file, bool nomerge)
   if (shada_disabled()) {
     return FAIL;
   }
+  // Deferred entries may be from another file, or be dropped by nomerge.
+  shada_load_history();
+  shada_load_registers();
 
   char *const fname = shada_filename(file);
   char *tempname = NULL;
@@ -3054,9 +3291,11 @@ int shada_write_file(const char *const file, bool nomerge)
     .error = NULL,
   };
   ShaDaReadDef sd_reader = { .close = NULL };
+  const Timestamp start_time = os_time();
 
   if (!nomerge) {
     int error;
+shada_write_file_reopen:
     if ((error = open_shada_file_for_reading(fname, &sd_reader)) != 0) {
       if (error != UV_ENOENT) {
         emsgf(_(SERR "System error while opening ShaDa file %s for reading "
@@ -3068,6 +3307,14 @@ int shada_write_file(const char *const file, bool nomerge)
       nomerge = true;
       goto shada_write_file_nomerge;
     }
+#ifdef UNIX
+    // Hold the lock until the file is replaced, instances appending to it
+    // wait and then append to the new file, see shada_append().
+    if (!shada_lock(file_fd(sd_reader.cookie), fname)) {
+      sd_reader.close(&sd_reader);
+      goto shada_write_file_reopen;
+    }
+#endif
     tempname = modname(fname, ".tmp.a", false);
     if (tempname == NULL) {
       nomerge = true;
@@ -3155,10 +3402,13 @@ shada_write_file_nomerge: {}
 
   const ShaDaWriteResult sw_ret = shada_write(&sd_writer, (nomerge
                                                            ? NULL
-                                                           : &sd_reader));
+                                                           : &sd_reader), 0);
   assert(sw_ret != kSDWriteIgnError);
+  bool did_write = (sw_ret == kSDWriteSuccessfull);
   if (!nomerge) {
+#ifndef UNIX
     sd_reader.close(&sd_reader);
+#endif
     bool did_remove = false;
     if (sw_ret == kSDWriteSuccessfull) {
 #ifdef UNIX
@@ -3193,6 +3443,7 @@ shada_write_file_nomerge: {}
       if (vim_rename(tempname, fname) == -1) {
         EMSG3(_(RNERR "Can't rename ShaDa file from %s to %s!"),
               tempname, fname);
+        did_write = false;
       } else {
         did_remove = true;
         os_remove(tempname);
@@ -3212,15 +3463,136 @@ shada_write_file_did_not_remove:
 #endif
       EMSG3(_(RNERR "Do not forget to remove %s or rename it manually to %s."),
             tempname, fname);
+      did_write = false;
     }
+#ifdef UNIX
+    sd_reader.close(&sd_reader);
+#endif
     xfree(tempname);
   }
   sd_writer.close(&sd_writer);
 
+  FileInfo info;
+  if (did_write && os_fileinfo(fname, &info)) {
+    shada_set_synced(fname, start_time, os_fileinfo_size(&info));
+  }
   xfree(fname);
   return OK;
 }
 
+/// Append to ShaDa file what changed since it was read or written
+///
+/// Entries are merged by their timestamps when reading, so the new ones can be
+/// added to the end of the file without reading it, and concurrent instances
+/// can append without replacing each other's changes. When the file has grown
+/// by more than its size when it was read, FAIL is returned and the caller
+/// compacts it with shada_write_file().
+///
+/// @param[in]  fname  File to append to.
+///
+/// @return OK if the file was written to or an error was given, FAIL if the
+///         file has to be merged.
+static int shada_append(const char *const fname)
+  FUNC_ATTR_NONNULL_ALL FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  if (sd_sync_time == 0 || sd_sync_fname == NULL
+      || !strequal(fname, sd_sync_fname)) {
+    return FAIL;
+  }
+  const Timestamp start_time = os_time();
+  int fd;
+  FileInfo info;
+shada_append_reopen:
+  fd = os_open(fname, O_RDWR|O_APPEND, 0);
+  if (fd < 0) {
+    return FAIL;
+  }
+#ifdef UNIX
+  if (!shada_lock(fd, fname)) {
+    os_close(fd);
+    goto shada_append_reopen;
+  }
+#endif
+  char first_byte = NUL;
+  bool eof;
+  if (!os_fileinfo_fd(fd, &info)
+      || os_read(fd, &eof, &first_byte, 1, false) != 1
+      || first_byte != kSDItemHeader) {
+    os_close(fd);
+    return FAIL;
+  }
+  const uint64_t size = os_fileinfo_size(&info);
+  if (size - MIN(size, sd_sync_size)
+      > MAX(sd_sync_size, SHADA_APPEND_MIN_GROWTH)) {
+    os_close(fd);
+    return FAIL;
+  }
+
+  msgpack_sbuffer sbuf;
+  msgpack_sbuffer_init(&sbuf);
+  ShaDaWriteDef sd_writer = {
+    .write = &write_sbuf,
+    .close = NULL,
+    .cookie = &sbuf,
+    .error = NULL,
+  };
+  const ShaDaWriteResult sw_ret = shada_write(&sd_writer, NULL, sd_sync_time);
+  if (sw_ret != kSDWriteSuccessfull || sbuf.size == 0) {
+    // Error was already given, or &shada has s0 and the file needs to be
+    // emptied.
+    msgpack_sbuffer_destroy(&sbuf);
+    os_close(fd);
+    return sw_ret != kSDWriteSuccessfull ? OK : FAIL;
+  }
+
+  if (p_verbose > 0) {
+    verbose_enter();
+    smsg(_("Writing ShaDa file \"%s\""), fname);
+    verbose_leave();
+  }
+
+  const ptrdiff_t written = os_write(fd, sbuf.data, sbuf.size, false);
+  int error = 0;
+  if (written < 0) {
+    error = (int)written;
+  } else if ((size_t)written != sbuf.size) {
+    error = UV_ENOSPC;
+  } else if (p_fs) {
+    error = os_fsync(fd);
+  }
+  if (error != 0) {
+    emsgf(_(SERR "System error while writing ShaDa file: %s"),
+          os_strerror(error));
+    // Do not leave an incomplete entry at the end of the file.
+    (void)os_ftruncate(fd, size);
+  } else {
+    sd_sync_time = start_time;
+  }
+  msgpack_sbuffer_destroy(&sbuf);
+  os_close(fd);
+  return OK;
+}
+
+/// Write ShaDa file when exiting
+///
+/// Appends to the file when possible, see shada_append().
+///
+/// @return OK if writing was successful, FAIL otherwise.
+int shada_write_file_on_exit(void)
+{
+  if (shada_disabled()) {
+    return FAIL;
+  }
+
+  char *const fname = shada_filename(NULL);
+  const int ret = shada_append(fname);
+  xfree(fname);
+  if (ret == OK) {
+    return OK;
+  }
+  return shada_write_file(NULL, false);
+}
+
 /// Read marks information from ShaDa file
 ///
 /// @return OK in case of success, FAIL otherwise.
@@ -3246,6 +3618,85 @@ int shada_read_everything(const char *const fname, const bool forceit,
                          |(missing_ok?0:kShaDaMissingError));
 }
 
+/// Read ShaDa file at startup
+///
+/// Like shada_read_everything(), but history and registers are only copied
+/// and decoded when they are first used, see shada_load_history() and
+/// shada_load_registers().
+///
+/// @return FAIL if reading failed for some reason and OK otherwise.
+int shada_read_startup(void)
+{
+  return shada_read_file(NULL, (kShaDaWantInfo|kShaDaWantMarks
+                                |kShaDaGetOldfiles|kShaDaDeferData));
+}
+
+/// Keep undecoded entry read with kShaDaDeferData until it is used
+///
+/// @param[in]  entry  Entry returned undecoded by shada_read_next_item().
+static void shada_defer_entry(const ShadaEntry *const entry)
+  FUNC_ATTR_NONNULL_ALL
+{
+  msgpack_sbuffer *const sbuf = (
+      entry->data.unknown_item.type == kSDItemHistoryEntry
+      ? &sd_deferred_history
+      : &sd_deferred_registers);
+  if (sbuf->data == NULL) {
+    msgpack_sbuffer_init(sbuf);
+  }
+  msgpack_packer packer;
+  msgpack_packer_init(&packer, sbuf, &msgpack_sbuffer_write);
+  msgpack_pack_uint64(&packer, entry->data.unknown_item.type);
+  msgpack_pack_uint64(&packer, (uint64_t)entry->timestamp);
+  msgpack_pack_uint64(&packer, (uint64_t)entry->data.unknown_item.size);
+  msgpack_sbuffer_write(sbuf, entry->data.unknown_item.contents,
+                        entry->data.unknown_item.size);
+}
+
+/// Decode entries kept by shada_defer_entry()
+///
+/// @param[in,out]  deferred  Buffer with entries, emptied.
+static void shada_load_deferred(msgpack_sbuffer *const deferred)
+  FUNC_ATTR_NONNULL_ALL
+{
+  if (deferred->data == NULL) {
+    return;
+  }
+  // Take the buffer first: using history or registers while reading must not
+  // read it again.
+  msgpack_sbuffer sbuf = *deferred;
+  *deferred = (msgpack_sbuffer) { .data = NULL };
+  ShaDaReadDef sd_reader;
+  open_shada_sbuf_for_reading(&sbuf, &sd_reader);
+  shada_read(&sd_reader, kShaDaWantInfo);
+  msgpack_sbuffer_destroy(&sbuf);
+}
+
+/// Decode history read by shada_read_startup(), if not done yet
+///
+/// Must be called before history is accessed.
+void shada_load_history(void)
+{
+  shada_load_deferred(&sd_deferred_history);
+}
+
+/// Decode registers read by shada_read_startup(), if not done yet
+///
+/// Must be called before registers are accessed.
+void shada_load_registers(void)
+{
+  shada_load_deferred(&sd_deferred_registers);
+}
+
+#if defined(EXITFREE)
+void shada_free_all_mem(void)
+{
+  msgpack_sbuffer_destroy(&sd_deferred_history);
+  msgpack_sbuffer_destroy(&sd_deferred_registers);
+  XFREE_CLEAR(sd_sync_fname);
+}
+#endif
+
 static void shada_free_shada_entry(ShadaEntry *const entry)
 {
   if (entry == NULL) {
@@ -3645,6 +4096,22 @@ shada_read_next_item_start:
     return kSDReadStatusNotShaDa;
   }
 
+  if (type_u64 <= SHADA_LAST_ENTRY
+      && ((unsigned) (1 << type_u64) & flags & sd_reader->raw_flags)
+      && !(max_kbyte && length > max_kbyte * 1024)) {
+    entry->type = kSDItemUnknown;
+    entry->data.unknown_item.size = length;
+    entry->data.unknown_item.type = type_u64;
+    entry->data.unknown_item.contents = xmalloc(length);
+    const ShaDaReadResult fl_ret = fread_len(
+        sd_reader, entry->data.unknown_item.contents, length);
+    if (fl_ret != kSDReadStatusSuccess) {
+      shada_free_shada_entry(entry);
+      entry->type = kSDItemMissing;
+    }
+    return fl_ret;
+  }
+
   if ((type_u64 > SHADA_LAST_ENTRY
        ? !(flags & kSDReadUnknown)
        : !((unsigned) (1 << type_u64) & flags))
@@ -4342,7 +4809,13 @@ void shada_read_sbuf(msgpack_sbuffer *const sbuf, const int flags)
   if (sbuf->data == NULL) {
     return;
   }
+  if (flags & kShaDaWantInfo) {
+    shada_load_history();
+    shada_load_registers();
+  }
   ShaDaReadDef sd_reader;
   open_shada_sbuf_for_reading(sbuf, &sd_reader);
   shada_read(&sd_reader, flags);
+  // Restored entries may be older than the last write, write everything.
+  sd_sync_time = 0;
 }
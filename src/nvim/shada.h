@@ -10,6 +10,7 @@ typedef enum {
   kShaDaForceit = 4,        ///< Overwrite info already read
   kShaDaGetOldfiles = 8,    ///< Load v:oldfiles.
   kShaDaMissingError = 16,  ///< Error out when os_open returns -ENOENT.
+  kShaDaDeferData = 32,     ///< Load history and registers on first use.
 } ShaDaReadFileFlags;
 
 #ifdef INCLUDE_GENERATED_DECLARATIONS
@@ -6,6 +6,7 @@
 #include "nvim/lib/kvec.h"
 
 #include "nvim/ascii.h"
+#include "nvim/latency.h"
 #include "nvim/log.h"
 #include "nvim/state.h"
 #include "nvim/vim.h"
@@ -66,7 +67,9 @@ getkey:
     log_key(DEBUG_LOG_LEVEL, key);
 #endif
 
+    const LatencySpan span = latency_begin(kLatencyExecute);
     int execute_result = s->execute(s, key);
+    latency_end(&span);
     if (!execute_result) {
       break;
     } else if (execute_result == -1) {
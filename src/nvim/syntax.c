@@ -20,6 +20,8 @@
 #include "nvim/cursor_shape.h"
 #include "nvim/eval.h"
 #include "nvim/ex_cmds2.h"
+#include "nvim/event/loop.h"
+#include "nvim/event/time.h"
 #include "nvim/ex_docmd.h"
 #include "nvim/fileio.h"
 #include "nvim/fold.h"
@@ -37,14 +39,17 @@
 #include "nvim/os_unix.h"
 #include "nvim/path.h"
 #include "nvim/macros.h"
+#include "nvim/main.h"
 #include "nvim/regexp.h"
 #include "nvim/screen.h"
 #include "nvim/sign.h"
 #include "nvim/strings.h"
 #include "nvim/syntax_defs.h"
 #include "nvim/terminal.h"
+#include "nvim/trace.h"
 #include "nvim/ui.h"
 #include "nvim/os/os.h"
+#include "nvim/os/input.h"
 #include "nvim/os/time.h"
 #include "nvim/buffer.h"
 
@@ -382,6 +387,15 @@ static int current_line_id = 0;             // unique number for current line
 #define CUR_STATE(idx)  ((stateitem_T *)(current_state.ga_data))[idx]
 
 static int syn_time_on = FALSE;
+
+// Parsing syntax in the background, see syntax_idle_schedule().
+#define SYN_IDLE_DELAY 200     // msec after a redraw before starting
+#define SYN_IDLE_INTERVAL 10   // msec between two slices
+#define SYN_IDLE_SLICE 5       // msec of parsing in one slice
+static TimeWatcher syn_idle_timer;
+static bool syn_idle_active = false;      // syn_idle_parse() is running
+static linenr_T syn_idle_timeout_lnum = 0;  // line where a pattern timed out
+                                            // in syn_idle_parse(), or zero
 # define IF_SYN_TIME(p) (p)
 
 // Set the timeout used for syntax highlighting.
@@ -461,19 +475,22 @@ void syntax_start(win_T *wp, linenr_T lnum)
    * Only do this if lnum is not before and not to far beyond a saved state.
    */
   if (INVALID_STATE(&current_state) && syn_block->b_sst_array != NULL) {
-    /* Find last valid saved state before start_lnum. */
-    for (p = syn_block->b_sst_first; p != NULL; p = p->sst_next) {
-      if (p->sst_lnum > lnum) {
-        break;
-      }
+    // Find last valid saved state before start_lnum.
+    for (int i = syn_stack_index_find(syn_block, lnum); i >= 0; i--) {
+      p = syn_block->b_sst_index[i];
       if (p->sst_change_lnum == 0) {
         last_valid = p;
-        if (p->sst_lnum >= lnum - syn_block->b_syn_sync_minlines)
+        if (p->sst_lnum >= lnum - syn_block->b_syn_sync_minlines) {
           last_min_valid = p;
+        }
+        break;
       }
     }
-    if (last_min_valid != NULL)
+    if (last_min_valid != NULL) {
+      // Used now, keep it when cleaning up.
+      last_min_valid->sst_tick = display_tick;
       load_current_state(last_min_valid);
+    }
   }
 
   /*
@@ -557,6 +574,142 @@ void syntax_start(win_T *wp, linenr_T lnum)
   syn_start_line();
 }
 
+/// Sets up the timer for parsing syntax in the background.
+void syntax_idle_init(void)
+{
+  time_watcher_init(&main_loop, &syn_idle_timer, NULL);
+  // syn_idle_timer_cb changes the current syntax state, it must not run in
+  // the middle of a redraw.
+  syn_idle_timer.events = multiqueue_new_child(main_loop.events);
+}
+
+void syntax_idle_teardown(void)
+{
+  time_watcher_stop(&syn_idle_timer);
+  multiqueue_free(syn_idle_timer.events);
+  time_watcher_close(&syn_idle_timer, NULL);
+}
+
+/// Schedules parsing the syntax of the lines below the window in the
+/// background, so that the states are there when the user jumps further down.
+/// Called after the screen was updated: the timer is restarted on every
+/// redraw, thus parsing is postponed while the user is typing.
+void syntax_idle_schedule(void)
+{
+  if (syn_idle_timer.events == NULL) {
+    return;  // not initialized (unit tests)
+  }
+  if (!syn_idle_needed(curwin)) {
+    time_watcher_stop(&syn_idle_timer);
+    return;
+  }
+  time_watcher_start(&syn_idle_timer, syn_idle_timer_cb, SYN_IDLE_DELAY, 0);
+}
+
+/// Checks if there are lines in the buffer of "wp" which were not parsed in
+/// the background yet.
+static bool syn_idle_needed(win_T *wp)
+{
+  synblock_T *const block = wp->w_s;
+  return syntax_present(wp)
+         && !block->b_syn_error
+         && !block->b_syn_slow
+         && block->b_sst_idle_lnum < wp->w_buffer->b_ml.ml_line_count;
+}
+
+static void syn_idle_timer_cb(TimeWatcher *watcher, void *data)
+{
+  if (updating_screen || !syn_idle_needed(curwin)) {
+    return;
+  }
+  if (ex_nesting_level > 0 || textlock > 0 || ex_normal_busy > 0) {
+    // Events are also handled in :sleep, getchar(), etc.: only parse while
+    // waiting for the user, try again later.
+    time_watcher_start(&syn_idle_timer, syn_idle_timer_cb, SYN_IDLE_DELAY, 0);
+    return;
+  }
+  syn_idle_parse(curwin, os_hrtime() + SYN_IDLE_SLICE * 1000000);
+  if (syn_idle_needed(curwin)) {
+    time_watcher_start(&syn_idle_timer, syn_idle_timer_cb, SYN_IDLE_INTERVAL,
+                       0);
+  }
+}
+
+/// Parses lines from wp->w_s->b_sst_idle_lnum onwards, storing states in the
+/// state stack the same way as syntax_start() does, until the end of the
+/// buffer, time "deadline" (in os_hrtime() units) or until input is
+/// available.
+///
+/// "deadline" is also the timeout for matching patterns, also when syncing.
+/// States after a line where that timeout was hit are dropped, they may be
+/// wrong. When not a single line could be parsed, parsing in the background is
+/// given up until the buffer changes.
+static void syn_idle_parse(win_T *wp, uint64_t deadline)
+{
+  synblock_T *const block = wp->w_s;
+  const linenr_T line_count = wp->w_buffer->b_ml.ml_line_count;
+  const linenr_T start = MAX(block->b_sst_idle_lnum, 1);
+  const TraceSpan trace_span = trace_begin();
+  proftime_T tm = deadline;
+
+  syn_set_timeout(&tm);
+  syn_idle_active = true;
+  syn_idle_timeout_lnum = 0;
+  syntax_start(wp, start);
+  if (block->b_sst_array == NULL || INVALID_STATE(&current_state)
+      || syn_idle_timeout_lnum != 0) {
+    syn_idle_parse_end(block, start);
+    return;
+  }
+  const int dist = (int)(block->b_sst_len <= Rows
+                   ? 999999
+                   : line_count / (block->b_sst_len - Rows) + 1);
+  synstate_T *prev = syn_stack_find_entry(current_lnum);
+  while (current_lnum < line_count) {
+    (void)syn_finish_line(false);
+    if (syn_idle_timeout_lnum != 0) {
+      break;
+    }
+    current_lnum++;
+    if (prev == NULL || current_lnum >= prev->sst_lnum + dist) {
+      prev = store_current_state();
+    }
+    syn_start_line();
+    if ((current_lnum & 0x1f) == 0
+        && (os_hrtime() >= deadline || input_available())) {
+      break;
+    }
+  }
+  if (syn_idle_timeout_lnum == 0) {
+    // Store the state where we stopped, to continue from there next time.
+    if (!current_state_stored) {
+      (void)store_current_state();
+    }
+    block->b_sst_idle_lnum = current_lnum;
+  }
+  syn_idle_parse_end(block, start);
+  trace_end(trace_span, "syntax", "idle", NULL);
+}
+
+/// Cleans up after syn_idle_parse(), which started at line "start".
+static void syn_idle_parse_end(synblock_T *block, linenr_T start)
+{
+  if (syn_idle_timeout_lnum != 0) {
+    syn_stack_free_after(block, syn_idle_timeout_lnum);
+    if (syn_idle_timeout_lnum > start) {
+      // Continue from the last state before the timeout next time.
+      block->b_sst_idle_lnum = syn_idle_timeout_lnum;
+    } else {
+      block->b_sst_idle_lnum = MAXLNUM;
+    }
+  }
+  syn_set_timeout(NULL);
+  syn_idle_active = false;
+  syn_idle_timeout_lnum = 0;
+  // Redraw must not continue from this state, it's not at its line.
+  invalidate_current_state();
+}
+
 /*
  * We cannot simply discard growarrays full of state_items or buf_states; we
  * have to manually release their extmatch pointers first.
@@ -993,6 +1146,13 @@ static void syn_update_ends(int startofline)
  * entries depends on the number of lines in the buffer.  For small buffers
  * the distance is fixed at SST_DIST, for large buffers there is a fixed
  * number of entries SST_MAX_ENTRIES, and the distance is computed.
+ *
+ * When there are no free entries, the least recently used entries (by display
+ * tick) that are closer together than the distance are removed, so a sparse
+ * set of entries over the whole buffer is kept.
+ *
+ * b_sst_index[] has pointers to the used entries, sorted on line number, so
+ * that the entry for a line can be found with a binary search.
  */
 
 static void syn_stack_free_block(synblock_T *block)
@@ -1004,9 +1164,12 @@ static void syn_stack_free_block(synblock_T *block)
       clear_syn_state(p);
     }
     XFREE_CLEAR(block->b_sst_array);
+    XFREE_CLEAR(block->b_sst_index);
     block->b_sst_first = NULL;
     block->b_sst_len = 0;
+    block->b_sst_index_len = 0;
   }
+  block->b_sst_idle_lnum = 0;
 }
 /*
  * Free b_sst_array[] for buffer "buf".
@@ -1091,6 +1254,9 @@ static void syn_stack_alloc(void)
     xfree(syn_block->b_sst_array);
     syn_block->b_sst_array = sstp;
     syn_block->b_sst_len = len;
+    syn_block->b_sst_index = xrealloc(syn_block->b_sst_index,
+                                      (size_t)len * sizeof(synstate_T *));
+    syn_stack_index_rebuild(syn_block);
   }
 }
 
@@ -1149,6 +1315,32 @@ static void syn_stack_apply_changes_block(synblock_T *block, buf_T *buf)
     prev = p;
     p = p->sst_next;
   }
+  syn_stack_index_rebuild(block);
+  if (block->b_sst_idle_lnum > buf->b_mod_top) {
+    block->b_sst_idle_lnum = buf->b_mod_top;
+  }
+}
+
+/// Removes the entries of the state stack after line "lnum".
+static void syn_stack_free_after(synblock_T *block, linenr_T lnum)
+{
+  synstate_T *prev = NULL;
+  for (synstate_T *p = block->b_sst_first; p != NULL; ) {
+    if (p->sst_lnum > lnum) {
+      synstate_T *const np = p->sst_next;
+      if (prev == NULL) {
+        block->b_sst_first = np;
+      } else {
+        prev->sst_next = np;
+      }
+      syn_stack_free_entry(block, p);
+      p = np;
+      continue;
+    }
+    prev = p;
+    p = p->sst_next;
+  }
+  syn_stack_index_rebuild(block);
 }
 
 /*
@@ -1206,6 +1398,9 @@ static int syn_stack_cleanup(void)
       retval = TRUE;
     }
   }
+  if (retval) {
+    syn_stack_index_rebuild(syn_block);
+  }
   return retval;
 }
 
@@ -1221,22 +1416,64 @@ static void syn_stack_free_entry(synblock_T *block, synstate_T *p)
   ++block->b_sst_freecount;
 }
 
+/// Rebuild b_sst_index[] from the list of used entries.
+static void syn_stack_index_rebuild(synblock_T *block)
+{
+  int n = 0;
+  for (synstate_T *p = block->b_sst_first; p != NULL; p = p->sst_next) {
+    assert(n < block->b_sst_len);
+    block->b_sst_index[n++] = p;
+  }
+  block->b_sst_index_len = n;
+}
+
+/// Find the last entry in b_sst_index[] at or before "lnum".
+///
+/// @return index in b_sst_index[] or -1 when the first entry is after "lnum".
+static int syn_stack_index_find(synblock_T *block, linenr_T lnum)
+{
+  int lo = 0;
+  int hi = block->b_sst_index_len;
+  while (lo < hi) {
+    const int mid = lo + (hi - lo) / 2;
+    if (block->b_sst_index[mid]->sst_lnum <= lnum) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo - 1;
+}
+
+/// Add used entry "p" to b_sst_index[].
+static void syn_stack_index_insert(synblock_T *block, synstate_T *p)
+{
+  const int i = syn_stack_index_find(block, p->sst_lnum) + 1;
+  assert(block->b_sst_index_len < block->b_sst_len);
+  memmove(block->b_sst_index + i + 1, block->b_sst_index + i,
+          (size_t)(block->b_sst_index_len - i) * sizeof(synstate_T *));
+  block->b_sst_index[i] = p;
+  block->b_sst_index_len++;
+}
+
+/// Remove used entry "p" from b_sst_index[].
+static void syn_stack_index_remove(synblock_T *block, synstate_T *p)
+{
+  const int i = syn_stack_index_find(block, p->sst_lnum);
+  assert(i >= 0 && block->b_sst_index[i] == p);
+  memmove(block->b_sst_index + i, block->b_sst_index + i + 1,
+          (size_t)(block->b_sst_index_len - i - 1) * sizeof(synstate_T *));
+  block->b_sst_index_len--;
+}
+
 /*
  * Find an entry in the list of state stacks at or before "lnum".
  * Returns NULL when there is no entry or the first entry is after "lnum".
  */
 static synstate_T *syn_stack_find_entry(linenr_T lnum)
 {
-  synstate_T  *p, *prev;
-
-  prev = NULL;
-  for (p = syn_block->b_sst_first; p != NULL; prev = p, p = p->sst_next) {
-    if (p->sst_lnum == lnum)
-      return p;
-    if (p->sst_lnum > lnum)
-      break;
-  }
-  return prev;
+  const int i = syn_stack_index_find(syn_block, lnum);
+  return i < 0 ? NULL : syn_block->b_sst_index[i];
 }
 
 /*
@@ -1271,13 +1508,14 @@ static synstate_T *store_current_state(void)
         /* it's the first entry */
         syn_block->b_sst_first = sp->sst_next;
       else {
-        /* find the entry just before this one to adjust sst_next */
-        for (p = syn_block->b_sst_first; p != NULL; p = p->sst_next)
-          if (p->sst_next == sp)
-            break;
-        if (p != NULL)          /* just in case */
+        // the entry just before this one, to adjust sst_next
+        const int idx = syn_stack_index_find(syn_block, sp->sst_lnum - 1);
+        p = idx < 0 ? NULL : syn_block->b_sst_index[idx];
+        if (p != NULL && p->sst_next == sp) {  // just in case
           p->sst_next = sp->sst_next;
+        }
       }
+      syn_stack_index_remove(syn_block, sp);
       syn_stack_free_entry(syn_block, sp);
       sp = NULL;
     }
@@ -1312,6 +1550,7 @@ static synstate_T *store_current_state(void)
       sp = p;
       sp->sst_stacksize = 0;
       sp->sst_lnum = current_lnum;
+      syn_stack_index_insert(syn_block, sp);
     }
   }
   if (sp != NULL) {
@@ -2929,7 +3168,12 @@ static int syn_regexec(regmmatch_T *rmp, linenr_T lnum, colnr_T col, syn_time_T
     if (r > 0)
       ++st->match;
   }
-  if (timed_out && !syn_win->w_s->b_syn_slow) {
+  if (timed_out && syn_idle_active) {
+    // The slice of background parsing is over, not 'redrawtime'.
+    if (syn_idle_timeout_lnum == 0) {
+      syn_idle_timeout_lnum = lnum;
+    }
+  } else if (timed_out && !syn_win->w_s->b_syn_slow) {
     syn_win->w_s->b_syn_slow = true;
     MSG(_("'redrawtime' exceeded, syntax highlighting disabled"));
   }
@@ -2961,7 +3205,9 @@ static int check_keyword_id(
   // checked.
   char_u *const kwp = line + startcol;
   int kwlen = 0;
+  bool ascii = true;
   do {
+    ascii &= kwp[kwlen] < 0x80;
     kwlen += utfc_ptr2len(kwp + kwlen);
   } while (vim_iswordp_buf(kwp + kwlen, syn_buf));
 
@@ -2969,22 +3215,33 @@ static int check_keyword_id(
     return 0;
   }
 
-  // Must make a copy of the keyword, so we can add a NUL and make it
-  // lowercase.
-  char_u keyword[MAXKEYWLEN + 1];         // assume max. keyword len is 80
-  STRLCPY(keyword, kwp, kwlen + 1);
+  if (syn_block->b_keywindex == NULL) {
+    syn_keywindex_build(syn_block);
+  }
 
   keyentry_T *kp = NULL;
 
   // matching case
   if (syn_block->b_keywtab.ht_used != 0) {
-    kp = match_keyword(keyword, &syn_block->b_keywtab, cur_si);
+    kp = match_keyword(syn_keywindex_find(&syn_block->b_keywindex[0],
+                                          kwp, kwlen, false), cur_si);
   }
 
   // ignoring case
   if (kp == NULL && syn_block->b_keywtab_ic.ht_used != 0) {
-    str_foldcase(kwp, kwlen, keyword, MAXKEYWLEN + 1);
-    kp = match_keyword(keyword, &syn_block->b_keywtab_ic, cur_si);
+    if (ascii) {
+      kp = match_keyword(syn_keywindex_find(&syn_block->b_keywindex[1],
+                                            kwp, kwlen, true), cur_si);
+    } else {
+      // Folding multi-byte characters may change the length, must make a
+      // copy of the keyword.
+      char_u keyword[MAXKEYWLEN + 1];     // assume max. keyword len is 80
+      str_foldcase(kwp, kwlen, keyword, MAXKEYWLEN + 1);
+      hashitem_T *hi = hash_find(&syn_block->b_keywtab_ic, keyword);
+      if (!HASHITEM_EMPTY(hi)) {
+        kp = match_keyword(HI2KE(hi), cur_si);
+      }
+    }
   }
 
   if (kp != NULL) {
@@ -3003,21 +3260,115 @@ static int check_keyword_id(
 /// When current_next_list is non-zero accept only that group, otherwise:
 ///  Accept a not-contained keyword at toplevel.
 ///  Accept a keyword at other levels only if it is in the contains list.
-static keyentry_T *match_keyword(char_u *keyword, hashtab_T *ht,
-                                 stateitem_T *cur_si)
-{
-  hashitem_T *hi = hash_find(ht, keyword);
-  if (!HASHITEM_EMPTY(hi))
-    for (keyentry_T *kp = HI2KE(hi); kp != NULL; kp = kp->ke_next) {
-      if (current_next_list != 0
-          ? in_id_list(NULL, current_next_list, &kp->k_syn, 0)
-          : (cur_si == NULL
-            ? !(kp->flags & HL_CONTAINED)
-            : in_id_list(cur_si, cur_si->si_cont_list,
-                         &kp->k_syn, kp->flags & HL_CONTAINED))) {
-        return kp;
+///
+/// @param  kp  First entry for the keyword or NULL.
+static keyentry_T *match_keyword(keyentry_T *kp, stateitem_T *cur_si)
+{
+  for (; kp != NULL; kp = kp->ke_next) {
+    if (current_next_list != 0
+        ? in_id_list(NULL, current_next_list, &kp->k_syn, 0)
+        : (cur_si == NULL
+           ? !(kp->flags & HL_CONTAINED)
+           : in_id_list(cur_si, cur_si->si_cont_list,
+                        &kp->k_syn, kp->flags & HL_CONTAINED))) {
+      return kp;
+    }
+  }
+  return NULL;
+}
+
+/// Hashes a keyword for the keyword index, folding ASCII case when "ic".
+static inline uint32_t syn_keyw_hash(const char_u *p, int len, bool ic)
+{
+  uint32_t hash = 2166136261U;  // FNV-1a
+  for (int i = 0; i < len; i++) {
+    hash = (hash ^ (ic ? (uint8_t)TOLOWER_ASC(p[i]) : p[i])) * 16777619U;
+  }
+  return hash;
+}
+
+/// Indexes the keywords in "ht" for syn_keywindex_find().
+static void syn_keywindex_init(keywindex_T *kwi, hashtab_T *ht, bool ic)
+{
+  uint32_t size = 8;
+  while (size < ht->ht_used * 2) {
+    size <<= 1;
+  }
+  kwi->kwi_slots = xcalloc(size, sizeof(*kwi->kwi_slots));
+  kwi->kwi_mask = size - 1;
+  HASHTAB_ITER(ht, hi, {
+    const int len = (int)STRLEN(hi->hi_key);
+    if (len == 0 || len > MAXKEYWLEN) {
+      continue;  // can never match
+    }
+    const uint32_t hash = syn_keyw_hash(hi->hi_key, len, ic);
+    uint32_t i = hash & kwi->kwi_mask;
+    while (kwi->kwi_slots[i].kws_kp != NULL) {
+      i = (i + 1) & kwi->kwi_mask;
+    }
+    kwi->kwi_slots[i].kws_kp = HI2KE(hi);
+    kwi->kwi_slots[i].kws_hash = hash;
+    kwi->kwi_slots[i].kws_len = len;
+    kwi->kwi_lens[len >> 6] |= 1ULL << (len & 63);
+    kwi->kwi_first[hi->hi_key[0] >> 3] |= (uint8_t)(1 << (hi->hi_key[0] & 7));
+  });
+}
+
+/// Builds the keyword index of "block", used until the keywords change.
+static void syn_keywindex_build(synblock_T *block)
+{
+  block->b_keywindex = xcalloc(2, sizeof(*block->b_keywindex));
+  syn_keywindex_init(&block->b_keywindex[0], &block->b_keywtab, false);
+  syn_keywindex_init(&block->b_keywindex[1], &block->b_keywtab_ic, true);
+}
+
+/// Frees the keyword index of "block", must be called when the keywords
+/// change.
+static void syn_keywindex_free(synblock_T *block)
+{
+  if (block->b_keywindex != NULL) {
+    xfree(block->b_keywindex[0].kwi_slots);
+    xfree(block->b_keywindex[1].kwi_slots);
+    XFREE_CLEAR(block->b_keywindex);
+  }
+}
+
+/// Finds the keyword "len" bytes at "p" in the keyword index "kwi".
+///
+/// @param  ic  ignore case, "p" must not contain multi-byte characters then
+///
+/// @return the first entry for the keyword or NULL
+static keyentry_T *syn_keywindex_find(const keywindex_T *kwi, const char_u *p,
+                                      int len, bool ic)
+{
+  // Most words are not a keyword, quickly check the first byte and length.
+  const uint8_t c = ic ? (uint8_t)TOLOWER_ASC(*p) : *p;
+  if (!(kwi->kwi_first[c >> 3] & (1 << (c & 7)))
+      || !(kwi->kwi_lens[len >> 6] & (1ULL << (len & 63)))) {
+    return NULL;
+  }
+  const uint32_t hash = syn_keyw_hash(p, len, ic);
+  for (uint32_t i = hash & kwi->kwi_mask; kwi->kwi_slots[i].kws_kp != NULL;
+       i = (i + 1) & kwi->kwi_mask) {
+    const keywslot_T *const slot = &kwi->kwi_slots[i];
+    if (slot->kws_hash != hash || slot->kws_len != len) {
+      continue;
+    }
+    const char_u *const key = slot->kws_kp->keyword;
+    int j = 0;
+    if (ic) {
+      while (j < len && (char_u)TOLOWER_ASC(p[j]) == key[j]) {
+        j++;
+      }
+    } else {
+      while (j < len && p[j] == key[j]) {
+        j++;
       }
     }
+    if (j == len) {
+      return slot->kws_kp;
+    }
+  }
   return NULL;
 }
 
@@ -3204,6 +3555,7 @@ void syntax_clear(synblock_T *block)
   /* free the keywords */
   clear_keywtab(&block->b_keywtab);
   clear_keywtab(&block->b_keywtab_ic);
+  syn_keywindex_free(block);
 
   /* free the syntax patterns */
   for (int i = block->b_syn_patterns.ga_len; --i >= 0; ) {
@@ -3397,6 +3749,7 @@ static void syn_clear_one(const int id, const bool syncing)
   if (!syncing) {
     syn_clear_keyword(id, &curwin->w_s->b_keywtab);
     syn_clear_keyword(id, &curwin->w_s->b_keywtab_ic);
+    syn_keywindex_free(curwin->w_s);
   }
 
   /* clear the patterns for "id" */
@@ -4018,6 +4371,7 @@ static void add_keyword(char_u *const name,
   }
   kp->next_list = copy_id_list(next_list);
 
+  syn_keywindex_free(curwin->w_s);
   const hash_T hash = hash_hash(kp->keyword);
   hashtab_T *const ht = (curwin->w_s->b_syn_ic)
       ? &curwin->w_s->b_keywtab_ic
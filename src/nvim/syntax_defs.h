@@ -1,15 +1,21 @@
 #ifndef NVIM_SYNTAX_DEFS_H
 #define NVIM_SYNTAX_DEFS_H
 
+#include <stdint.h>
+
 #include "nvim/highlight_defs.h"
 
 # define SST_MIN_ENTRIES 150    /* minimal size for state stack array */
-# define SST_MAX_ENTRIES 1000   /* maximal size for state stack array */
+// Memory used for the state stack array at most (not counting long stacks).
+# define SST_MAX_MEMORY (1024 * 1024)
+// maximal size for state stack array
+# define SST_MAX_ENTRIES ((int)(SST_MAX_MEMORY / sizeof(synstate_T)))
 # define SST_FIX_STATES  7      /* size of sst_stack[]. */
 # define SST_DIST        16     /* normal distance between entries */
 # define SST_INVALID    (synstate_T *)-1        /* invalid syn_state pointer */
 
 typedef struct syn_state synstate_T;
+typedef struct keywindex keywindex_T;
 
 #include "nvim/buffer_defs.h"
 #include "nvim/regexp_defs.h"
@@ -35,6 +41,23 @@ struct keyentry {
   char_u keyword[1];            // actually longer
 };
 
+/*
+ * The keywords of one hashtab, indexed for matching directly on the text of a
+ * line without copying and case folding the word first.
+ */
+typedef struct {
+  keyentry_T  *kws_kp;          // first entry for the keyword, NULL if unused
+  uint32_t kws_hash;            // hash of the keyword
+  int kws_len;                  // length of the keyword in bytes
+} keywslot_T;
+
+struct keywindex {
+  keywslot_T  *kwi_slots;       // open addressing table
+  uint32_t kwi_mask;            // number of slots minus one
+  uint64_t kwi_lens[2];         // bit set of keyword lengths
+  uint8_t kwi_first[32];        // bit set of first bytes of keywords
+};
+
 /*
  * Struct used to store one state of the state stack.
  */
@@ -30,6 +30,45 @@ func Test_nested_global()
   bwipe!
 endfunc
 
+func Test_global_large_buffer()
+  " Big enough for the lines to be matched on worker threads.
+  new
+  call setline(1, map(range(1, 30000), '"line " .. v:val'))
+  for re in [0, 1, 2, 3]
+    exe 'set regexpengine=' .. re
+    let g:count = 0
+    g/\<\d*77\>$/let g:count += 1
+    call assert_equal(300, g:count)
+    let g:count = 0
+    v/[02468]$/let g:count += 1
+    call assert_equal(15000, g:count)
+    " Patterns using the line number and the cursor.
+    let g:count = 0
+    g/\%>29990l\d$/let g:count += 1
+    call assert_equal(10, g:count)
+    call cursor(12345, 1)
+    let g:count = 0
+    g/\%#line/let g:count += 1
+    call assert_equal(1, g:count)
+  endfor
+  set regexpengine&
+
+  " Substituting moves the lines below.
+  %s/\d*7\zs7$/&\r+/
+  call assert_equal(30300, line('$'))
+  call assert_equal(['line 77', '+', 'line 78'], getline(77, 79))
+  call assert_equal(['line 177', '+', 'line 178'], getline(178, 180))
+  call assert_equal(['line 29977', '+', 'line 29978'], getline(30276, 30278))
+  call assert_equal('line 30000', getline('$'))
+
+  " "~" is the previous replacement string, not the one of this command.
+  call setline(1, map(range(1, line('$')), 'v:val % 100 ? "x" : "one"'))
+  1s/x/one/
+  %s/~/two/
+  call assert_equal(304, len(filter(getline(1, '$'), 'v:val ==# "two"')))
+  bwipe!
+endfunc
+
 func Test_global_error()
   call assert_fails('g\\a', 'E10:')
   call assert_fails('g', 'E148:')
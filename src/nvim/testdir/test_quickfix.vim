@@ -2830,6 +2830,60 @@ func Test_vimgrep_existing_swapfile()
   unlet g:ignoreSwapExists
 endfunc
 
+" Test for :vimgrep with the 'j' flag searching files read in advance
+func Test_vimgrep_prefetch()
+  call writefile(['one apple', 'two', 'apple apple'], 'Xprefetch1')
+  call writefile(["apple\r", "pie\r"], 'Xprefetch2')
+  call writefile(["caf\xe9 apple"], 'Xprefetch3')
+  call writefile(["nul\napple", "apple"], 'Xprefetch4')
+  call writefile([], 'Xprefetch5')
+  let files = 'Xprefetch1 Xprefetch2 Xprefetch3 Xprefetch4 Xprefetch5'
+  let cmds = ['vimgrep /apple/gj ', 'vimgrep /^$/j ', '2vimgrep /apple/j ',
+        \ 'vimgrep /apple\nt/j ', 'vimgrep /e$/j ', 'vimgrep /\<APPLE\>/gij ',
+        \ 'vimgrep /\%>1lapple/j ', 'vimgrep /\(p\)\1/j ']
+
+  for cmd in cmds
+    set vimgrepprefetch=0
+    exe cmd .. files
+    let expected = map(getqflist(), {_, v -> [bufname(v.bufnr), v.lnum,
+          \ v.col, v.text]})
+    set vimgrepprefetch&
+    exe cmd .. files
+    let actual = map(getqflist(), {_, v -> [bufname(v.bufnr), v.lnum,
+          \ v.col, v.text]})
+    call assert_equal(expected, actual, cmd)
+  endfor
+
+  " Autocommands for reading the file are still triggered.
+  let g:prefetch_read = 0
+  augroup prefetch
+    au BufReadPost Xprefetch1 let g:prefetch_read += 1
+  augroup END
+  exe 'vimgrep /apple/j ' .. files
+  call assert_equal(1, g:prefetch_read)
+  augroup prefetch
+    au!
+  augroup END
+  augroup! prefetch
+
+  " The filetype detection autocommands don't matter.
+  let g:prefetch_read = 0
+  augroup filetypedetect
+    au BufRead Xprefetch[14] let g:prefetch_read += 1
+  augroup END
+  exe 'vimgrep /apple/j ' .. files
+  call assert_equal(0, g:prefetch_read)
+  augroup filetypedetect
+    au! BufRead Xprefetch[14]
+  augroup END
+  unlet g:prefetch_read
+
+  %bwipe!
+  for i in range(1, 5)
+    call delete('Xprefetch' .. i)
+  endfor
+endfunc
+
 func XfreeTests(cchar)
   call s:setup_commands(a:cchar)
 
@@ -569,8 +569,8 @@ func Test_regexp_single_line_pat()
     let pat = t[1]
     let text = t[2]
     let matchidx = 3
-    for engine in [0, 1, 2]
-      if engine == 2 && re == 0 || engine == 1 && re == 1
+    for engine in [0, 1, 2, 3]
+      if engine >= 2 && re == 0 || engine == 1 && re == 1
         continue
       endif
       let &regexpengine = engine
@@ -645,8 +645,8 @@ func Test_regexp_multiline_pat()
     let pat = t[1]
     let before = t[2]
     let after = t[3]
-    for engine in [0, 1, 2]
-      if engine == 2 && re == 0 || engine == 1 && re ==1
+    for engine in [0, 1, 2, 3]
+      if engine >= 2 && re == 0 || engine == 1 && re ==1
         continue
       endif
       let &regexpengine = engine
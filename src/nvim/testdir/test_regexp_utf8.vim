@@ -590,4 +590,52 @@ func Test_match_char_class_upper()
   bwipe!
 endfunc
 
+" Lines without the literal text in a pattern are skipped before matching.
+func Test_regexp_required_text()
+  let save_re = &regexpengine
+  for re in [1, 2, 3]
+    let &regexpengine = re
+    call assert_equal('foo.bar', matchstr('xx foo.bar', '\w\+\.bar'))
+    call assert_equal('', matchstr('xx foo.baz', '\w\+\.bar'))
+    call assert_equal('FOO.bar', matchstr('xx FOO.bar', '\cx \zsfoo\.\a\+'))
+    call assert_equal(-1, match('foo.bar x', '[a-z]o\.bar', 3))
+    call assert_equal('aaafoo', matchstr('x aaafoo', 'a\{-}foo'))
+    call assert_equal('', matchstr('aaa fo', '\(a\|b\)*foo'))
+    call assert_equal('ba', matchstr('ba aaa fo', '\(a\|b\)\+'))
+    " Zero-width items inside the literal text.
+    call assert_equal('foobar', matchstr('x foobar', '\(foo\)bar'))
+    call assert_equal('foobar', matchstr('x foobar', '\%(foo\)\@>bar'))
+    call assert_equal('bar', matchstr('x foobar', 'foo\zsbar'))
+    call assert_equal('foo', matchstr('x foobar', 'foo\zebar'))
+    call assert_equal('foo bar', matchstr('x foo bar', '\<foo\> bar'))
+    call assert_equal(-1, match('x foobar', '\<foo\>bar'))
+    call assert_equal('fooxybar', matchstr('x fooxybar', 'foo\%[xyz]bar'))
+    call assert_equal('afoob', matchstr('x afoob', 'a\%[xyz]foo\%[xyz]b'))
+    call assert_equal('BAR', matchstr('x FOOBAR', '\c\(foo\)\zsbar'))
+    if re != 1
+      " The Kelvin sign folds to "k".
+      call assert_equal(0, match("\u212aey1", '\ckey\d'))
+    endif
+  endfor
+  let &regexpengine = save_re
+endfunc
+
+" Lines with more different multibyte characters than the DFA caches, without
+" composing characters, which the DFA leaves to the NFA.
+func Test_regexp_dfa_multibyte()
+  let save_re = &regexpengine
+  let line = join(map(range(0x4e00, 0x4e00 + 2000), 'nr2char(v:val)'), '')
+  let last = nr2char(0x4e00 + 2000)
+  for re in [2, 3]
+    let &regexpengine = re
+    for _ in range(3)
+      call assert_equal(-1, match(line, 'ab\+c'))
+      call assert_equal(-1, match(line, "\u4e00\u4e01\u4e02\\{2}"))
+      call assert_equal(0, match(line, "\u4e00\u4e01\\+\u4e02"))
+      call assert_equal(last . 'x', matchstr(line . 'x', last . 'x'))
+    endfor
+  endfor
+  let &regexpengine = save_re
+endfunc
+
 " vim: shiftwidth=2 sts=2 expandtab
@@ -549,6 +549,35 @@ func Test_undo_0()
   bwipe!
 endfunc
 
+" Undo and redo a change of all lines in a big buffer, with empty lines and
+" lines containing a NUL.
+func Test_undo_many_lines()
+  new
+  set ul=100
+  let lines = map(range(1, 20000), 'v:val % 7 == 0 ? "" : "line " .. v:val')
+  let lines[5] = "with\nnul"
+  call setline(1, lines)
+  let before = getline(1, '$')
+  " Setting 'undolevels' starts a new undo block.
+  set ul=100
+  %s/line/LINE/
+  set ul=100
+  sort
+  let after = getline(1, '$')
+  undo
+  undo
+  call assert_equal(before, getline(1, '$'))
+  redo
+  redo
+  call assert_equal(after, getline(1, '$'))
+  undo 0
+  call assert_equal([''], getline(1, '$'))
+  redo
+  call assert_equal(before, getline(1, '$'))
+  bwipe!
+  set ul&
+endfunc
+
 " Tests for the undo file
 " Explicitly break changes up in undo-able pieces by setting 'undolevels'.
 func Test_undofile_2()
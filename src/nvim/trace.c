@@ -0,0 +1,299 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check
+// it. PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+// Tracing of nested spans (sourcing, autocommands, redraw, RPC requests, ...)
+// into a ring buffer, dumped in the Chrome trace-event format so it can be
+// loaded in chrome://tracing or https://ui.perfetto.dev.
+//
+// Spans are recorded as "complete" events when they end. Nesting is implied by
+// the start time and duration of the events, so no stack has to be kept and
+// spans may be recorded from any thread.
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <uv.h>
+
+#include "nvim/trace.h"
+#include "nvim/ascii.h"
+#include "nvim/memory.h"
+#include "nvim/os/os.h"
+#include "nvim/os/time.h"
+
+/// Maximum length of the detail string stored with an event.
+#define TRACE_ARG_LEN 96
+
+typedef struct {
+  const char *cat;         ///< category, must be a static string
+  const char *name;        ///< name, must be a static string
+  uint64_t start;          ///< start time in nanoseconds since trace_epoch
+  uint64_t dur;            ///< duration in nanoseconds
+  uint32_t tid;            ///< thread id, as assigned by trace_tid()
+  char arg[TRACE_ARG_LEN];  ///< detail (file name, pattern, ...)
+} TraceEvent;
+
+/// Whether spans are being recorded. Set with trace_mutex held, but checked by
+/// trace_begin() on any thread without locking, thus only accessed with
+/// TRACE_ACTIVE_GET() and TRACE_ACTIVE_SET(). A span started just before
+/// tracing is stopped is dropped by trace_end().
+static bool trace_active = false;
+
+#if defined(__GNUC__) || defined(__clang__)
+# define TRACE_ACTIVE_GET() __atomic_load_n(&trace_active, __ATOMIC_RELAXED)
+# define TRACE_ACTIVE_SET(v) \
+  __atomic_store_n(&trace_active, (v), __ATOMIC_RELAXED)
+#else
+// MSVC: volatile accesses of a bool are atomic.
+# define TRACE_ACTIVE_GET() (*(volatile bool *)&trace_active)
+# define TRACE_ACTIVE_SET(v) (*(volatile bool *)&trace_active = (v))
+#endif
+
+static uv_once_t trace_once = UV_ONCE_INIT;
+static uv_mutex_t trace_mutex;
+static uv_key_t trace_tid_key;
+static uint32_t trace_last_tid = 0;
+
+static TraceEvent *trace_events = NULL;  ///< ring buffer
+static size_t trace_size = 0;            ///< capacity of trace_events
+static size_t trace_count = 0;           ///< number of recorded events
+static uint64_t trace_epoch = 0;         ///< time when tracing was started
+
+static char *trace_startup_fname = NULL;  ///< "--startuptime {fname}.json"
+static uint64_t trace_phase_start = 0;    ///< end of the previous TIME_MSG()
+
+#ifdef INCLUDE_GENERATED_DECLARATIONS
+# include "trace.c.generated.h"
+#endif
+
+static void trace_init_once(void)
+{
+  uv_mutex_init(&trace_mutex);
+  if (uv_key_create(&trace_tid_key) != 0) {
+    abort();
+  }
+}
+
+/// Gets a small number identifying the current thread. The thread which
+/// started tracing first gets 1.
+///
+/// Must be called with trace_mutex held.
+static uint32_t trace_tid(void)
+{
+  uintptr_t tid = (uintptr_t)uv_key_get(&trace_tid_key);
+  if (tid == 0) {
+    tid = ++trace_last_tid;
+    uv_key_set(&trace_tid_key, (void *)tid);
+  }
+  return (uint32_t)tid;
+}
+
+/// Starts recording spans, discarding previously recorded ones.
+///
+/// @param size  Number of events to keep, older ones are overwritten.
+void trace_start(size_t size)
+{
+  assert(size > 0);
+  uv_once(&trace_once, trace_init_once);
+  uv_mutex_lock(&trace_mutex);
+  xfree(trace_events);
+  trace_events = xcalloc(size, sizeof(*trace_events));
+  trace_size = size;
+  trace_count = 0;
+  trace_epoch = os_hrtime();
+  (void)trace_tid();
+  TRACE_ACTIVE_SET(true);
+  uv_mutex_unlock(&trace_mutex);
+}
+
+/// Stops recording spans and frees the recorded ones.
+void trace_stop(void)
+{
+  trace_phase_start = 0;
+  uv_once(&trace_once, trace_init_once);
+  uv_mutex_lock(&trace_mutex);
+  if (trace_events != NULL) {
+    TRACE_ACTIVE_SET(false);
+    XFREE_CLEAR(trace_events);
+    trace_size = 0;
+    trace_count = 0;
+  }
+  uv_mutex_unlock(&trace_mutex);
+}
+
+/// Marks the start of a span.
+///
+/// @return Value to pass to trace_end().
+TraceSpan trace_begin(void)
+  FUNC_ATTR_WARN_UNUSED_RESULT
+{
+  return TRACE_ACTIVE_GET() ? os_hrtime() : 0;
+}
+
+/// Records a span which started at `start` and ends now.
+///
+/// May be called from any thread.
+///
+/// @param  start  Value returned by trace_begin().
+/// @param  cat  Category of the span. Must be a static string.
+/// @param  name  Name of the span. Must be a static string.
+/// @param  arg  Detail about the span, copied. May be NULL.
+void trace_end(TraceSpan start, const char *cat, const char *name,
+               const char *arg)
+  FUNC_ATTR_NONNULL_ARG(2, 3)
+{
+  if (start == 0) {
+    return;
+  }
+  uint64_t now = os_hrtime();
+
+  uv_mutex_lock(&trace_mutex);
+  if (trace_events != NULL && start >= trace_epoch) {
+    TraceEvent *ev = &trace_events[trace_count++ % trace_size];
+    ev->cat = cat;
+    ev->name = name;
+    ev->start = start - trace_epoch;
+    ev->dur = now - start;
+    ev->tid = trace_tid();
+    trace_copy_arg(ev->arg, arg);
+  }
+  uv_mutex_unlock(&trace_mutex);
+}
+
+/// Copies `arg` to the fixed size buffer of an event. Long values (usually
+/// file names) keep their tail, which is the interesting part.
+static void trace_copy_arg(char *dest, const char *arg)
+{
+  if (arg == NULL) {
+    *dest = NUL;
+    return;
+  }
+  size_t len = strlen(arg);
+  if (len < TRACE_ARG_LEN) {
+    memcpy(dest, arg, len + 1);
+    return;
+  }
+  const char *tail = arg + len - (TRACE_ARG_LEN - 4);
+  // Do not start in the middle of a UTF-8 sequence.
+  while ((*tail & 0xC0) == 0x80) {
+    tail++;
+  }
+  memcpy(dest, "...", 3);
+  memcpy(dest + 3, tail, strlen(tail) + 1);
+}
+
+/// Starts tracing for "--startuptime {fname}" when {fname} ends in ".json".
+/// The trace is written by trace_startup_done().
+void trace_startup(const char *fname)
+  FUNC_ATTR_NONNULL_ALL
+{
+  trace_start(TRACE_DEFAULT_SIZE);
+  trace_startup_fname = xstrdup(fname);
+  trace_phase_start = trace_epoch;
+}
+
+/// Records a startup phase, from the previous TIME_MSG() until now.
+///
+/// @param  name  Name of the phase. Must be a static string.
+void trace_phase(const char *name)
+  FUNC_ATTR_NONNULL_ALL
+{
+  if (trace_phase_start == 0) {
+    return;
+  }
+  uint64_t now = os_hrtime();
+  trace_end(trace_phase_start, "startup", name, NULL);
+  trace_phase_start = now;
+}
+
+/// Writes the startup trace started by trace_startup() and stops tracing.
+void trace_startup_done(void)
+{
+  if (trace_startup_fname == NULL) {
+    return;
+  }
+  trace_phase("first screen update");
+  trace_end(trace_epoch, "startup", "--- NVIM STARTED ---", NULL);
+  (void)trace_dump(trace_startup_fname);
+  trace_stop();
+  XFREE_CLEAR(trace_startup_fname);
+}
+
+/// Writes a JSON string.
+static void trace_write_string(FILE *fd, const char *s)
+{
+  putc('"', fd);
+  for (; *s != NUL; s++) {
+    const uint8_t c = (uint8_t)(*s);
+    if (c == '"' || c == '\\') {
+      putc('\\', fd);
+      putc(c, fd);
+    } else if (c < 0x20) {
+      fprintf(fd, "\\u%04x", c);
+    } else {
+      putc(c, fd);
+    }
+  }
+  putc('"', fd);
+}
+
+/// Writes the recorded spans as Chrome trace-event JSON.
+///
+/// Tracing is not stopped, spans ending while the file is written wait for it.
+///
+/// @param  fname  File to write.
+///
+/// @return Number of events written or -1 if the file could not be opened.
+int64_t trace_dump(const char *fname)
+  FUNC_ATTR_NONNULL_ALL
+{
+  FILE *fd = os_fopen(fname, "w");
+  if (fd == NULL) {
+    return -1;
+  }
+  const int64_t pid = os_get_pid();
+
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", fd);
+  fprintf(fd, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%" PRId64
+          ",\"tid\":1,\"args\":{\"name\":\"nvim\"}}", pid);
+
+  int64_t written = 0;
+  uv_once(&trace_once, trace_init_once);
+  uv_mutex_lock(&trace_mutex);
+  for (uint32_t tid = 1; tid <= trace_last_tid; tid++) {
+    fprintf(fd, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%" PRId64
+            ",\"tid\":%" PRIu32 ",\"args\":{\"name\":\"%s\"}}",
+            pid, tid, tid == 1 ? "main" : "worker");
+  }
+  const size_t n = trace_count < trace_size ? trace_count : trace_size;
+  for (size_t i = trace_count - n; i < trace_count; i++) {
+    const TraceEvent *ev = &trace_events[i % trace_size];
+    fputs(",\n{\"ph\":\"X\",\"cat\":", fd);
+    trace_write_string(fd, ev->cat);
+    fputs(",\"name\":", fd);
+    trace_write_string(fd, ev->name);
+    // Timestamps are in microseconds.
+    fprintf(fd, ",\"pid\":%" PRId64 ",\"tid\":%" PRIu32
+            ",\"ts\":%.3f,\"dur\":%.3f",
+            pid, ev->tid, (double)ev->start / 1e3, (double)ev->dur / 1e3);
+    if (*ev->arg != NUL) {
+      fputs(",\"args\":{\"detail\":", fd);
+      trace_write_string(fd, ev->arg);
+      putc('}', fd);
+    }
+    putc('}', fd);
+    written++;
+  }
+  uv_mutex_unlock(&trace_mutex);
+
+  fputs("\n]}\n", fd);
+  fclose(fd);
+  return written;
+}
+
+void trace_free_all_mem(void)
+{
+  trace_stop();
+  XFREE_CLEAR(trace_startup_fname);
+}
@@ -0,0 +1,19 @@
+#ifndef NVIM_TRACE_H
+#define NVIM_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// Start time of a traced span, as returned by trace_begin().
+///
+/// Zero when tracing was not active at the start of the span, trace_end() then
+/// records nothing.
+typedef uint64_t TraceSpan;
+
+/// Default number of events kept in the ring buffer.
+#define TRACE_DEFAULT_SIZE 16384
+
+#ifdef INCLUDE_GENERATED_DECLARATIONS
+# include "trace.h.generated.h"
+#endif
+#endif  // NVIM_TRACE_H
@@ -8,6 +8,7 @@
 #include <limits.h>
 
 #include "nvim/vim.h"
+#include "nvim/latency.h"
 #include "nvim/log.h"
 #include "nvim/aucmd.h"
 #include "nvim/ui.h"
@@ -443,6 +444,7 @@ int ui_current_col(void)
 
 void ui_flush(void)
 {
+  const LatencySpan span = latency_begin(kLatencyFlush);
   cmdline_ui_flush();
   win_ui_flush();
   msg_ext_ui_flush();
@@ -469,6 +471,8 @@ void ui_flush(void)
     pending_has_mouse = has_mouse;
   }
   ui_call_flush();
+  latency_end(&span);
+  latency_ui_flushed(input_available());
 }
 
 
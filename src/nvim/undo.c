@@ -284,6 +284,10 @@ bool undo_allowed(void)
     return false;
   }
 
+  // The buffer is locked while writing it in the background, wait for that
+  // to finish.
+  buf_write_bg_wait(curbuf, false);
+
   // In the sandbox it's not allowed to change the text.
   if (sandbox != 0) {
     EMSG(_(e_sandbox));
@@ -567,14 +571,10 @@ int u_savecommon(linenr_T top, linenr_T bot, linenr_T newbot, int reload)
   }
 
   if (size > 0) {
-    uep->ue_array = xmalloc(sizeof(char_u *) * (size_t)size);
-    for (i = 0, lnum = top + 1; i < size; ++i) {
-      fast_breakcheck();
-      if (got_int) {
-        u_freeentry(uep, i);
-        return FAIL;
-      }
-      uep->ue_array[i] = u_save_line(lnum++);
+    uep->ue_array = u_save_lines(top + 1, size, true, &uep->ue_text);
+    if (uep->ue_array == NULL) {
+      u_freeentry(uep, 0);
+      return FAIL;
     }
   } else
     uep->ue_array = NULL;
@@ -615,6 +615,10 @@ int u_savecommon(linenr_T top, linenr_T bot, linenr_T newbot, int reload)
 /* extra fields for uhp */
 # define UHP_SAVE_NR            1
 
+/// Size of the buffer for reading and writing an undo file.  Most items are a
+/// few bytes, going through stdio for each of them is slow.
+#define UNDO_BUFSIZE (64 * 1024)
+
 static char_u e_not_open[] = N_("E828: Cannot open undo file for writing: %s");
 
 /*
@@ -761,10 +765,9 @@ static bool serialize_header(bufinfo_T *bi, char_u *hash)
   FUNC_ATTR_NONNULL_ALL
 {
   buf_T *buf = bi->bi_buf;
-  FILE *fp = bi->bi_fp;
 
   // Start writing, first the magic marker and undo info version.
-  if (fwrite(UF_START_MAGIC, UF_START_MAGIC_LEN, 1, fp) != 1) {
+  if (!undo_write(bi, (uint8_t *)UF_START_MAGIC, UF_START_MAGIC_LEN)) {
     return false;
   }
 
@@ -1289,6 +1292,9 @@ void u_write_undo(const char *const name, const bool forceit, buf_T *const buf,
    */
   bi.bi_buf = buf;
   bi.bi_fp = fp;
+  bi.bi_buffer = xmalloc(UNDO_BUFSIZE);
+  bi.bi_used = 0;
+  bi.bi_avail = 0;
   if (!serialize_header(&bi, hash)) {
     goto write_error;
   }
@@ -1325,7 +1331,8 @@ void u_write_undo(const char *const name, const bool forceit, buf_T *const buf,
       uhp = uhp->uh_next.ptr;
   }
 
-  if (undo_write_bytes(&bi, (uintmax_t)UF_HEADER_END_MAGIC, 2)) {
+  if (undo_write_bytes(&bi, (uintmax_t)UF_HEADER_END_MAGIC, 2)
+      && undo_flush(&bi)) {
     write_ok = true;
   }
 #ifdef U_DEBUG
@@ -1336,6 +1343,7 @@ void u_write_undo(const char *const name, const bool forceit, buf_T *const buf,
 #endif
 
 write_error:
+  xfree(bi.bi_buffer);
   fclose(fp);
   if (!write_ok)
     EMSG2(_("E829: write error in undo file: %s"), file_name);
@@ -1367,6 +1375,7 @@ void u_read_undo(char *name, const char_u *hash,
 {
   u_header_T **uhp_table = NULL;
   char_u *line_ptr = NULL;
+  bufinfo_T bi = { .bi_buffer = NULL };
 
   char *file_name;
   if (name == NULL) {
@@ -1411,18 +1420,20 @@ void u_read_undo(char *name, const char_u *hash,
     goto error;
   }
 
-  bufinfo_T bi;
   bi.bi_buf = curbuf;
   bi.bi_fp = fp;
+  bi.bi_buffer = xmalloc(UNDO_BUFSIZE);
+  bi.bi_used = 0;
+  bi.bi_avail = 0;
 
   // Read the undo file header.
   char_u magic_buf[UF_START_MAGIC_LEN];
-  if (fread(magic_buf, UF_START_MAGIC_LEN, 1, fp) != 1
+  if (!undo_read(&bi, magic_buf, UF_START_MAGIC_LEN)
       || memcmp(magic_buf, UF_START_MAGIC, UF_START_MAGIC_LEN) != 0) {
     EMSG2(_("E823: Not an undo file: %s"), file_name);
     goto error;
   }
-  int version = get2c(fp);
+  int version = undo_read_2c(&bi);
   if (version != UF_VERSION) {
     EMSG2(_("E824: Incompatible undo file: %s"), file_name);
     goto error;
@@ -1540,70 +1551,54 @@ void u_read_undo(char *name, const char_u *hash,
 # define SET_FLAG(j)
 #endif
 
-  // We have put all of the headers into a table. Now we iterate through the
-  // table and swizzle each sequence number we have stored in uh_*_seq into
-  // a pointer corresponding to the header with that sequence number.
-  short old_idx = -1, new_idx = -1, cur_idx = -1;
+  // We have put all of the headers into a table. Sort it by sequence number,
+  // so that each sequence number we have stored in uh_*_seq can be swizzled
+  // into a pointer to the header with that sequence number quickly.
+  if (num_head > 0) {
+    qsort(uhp_table, (size_t)num_head, sizeof(*uhp_table), uhp_seq_cmp);
+  }
+  for (int i = 0; i + 1 < num_head; i++) {
+    if (uhp_table[i]->uh_seq == uhp_table[i + 1]->uh_seq) {
+      corruption_error("duplicate uh_seq", file_name);
+      goto error;
+    }
+  }
+  int j;
   for (int i = 0; i < num_head; i++) {
     u_header_T *uhp = uhp_table[i];
-    if (uhp == NULL) {
-      continue;
-    }
-    for (int j = 0; j < num_head; j++) {
-      if (uhp_table[j] != NULL && i != j
-          && uhp_table[i]->uh_seq == uhp_table[j]->uh_seq) {
-        corruption_error("duplicate uh_seq", file_name);
-        goto error;
-      }
-    }
-    for (int j = 0; j < num_head; j++) {
-      if (uhp_table[j] != NULL
-          && uhp_table[j]->uh_seq == uhp->uh_next.seq) {
-        uhp->uh_next.ptr = uhp_table[j];
-        SET_FLAG(j);
-        break;
-      }
-    }
-    for (int j = 0; j < num_head; j++) {
-      if (uhp_table[j] != NULL
-          && uhp_table[j]->uh_seq == uhp->uh_prev.seq) {
-        uhp->uh_prev.ptr = uhp_table[j];
-        SET_FLAG(j);
-        break;
-      }
-    }
-    for (int j = 0; j < num_head; j++) {
-      if (uhp_table[j] != NULL
-          && uhp_table[j]->uh_seq == uhp->uh_alt_next.seq) {
-        uhp->uh_alt_next.ptr = uhp_table[j];
-        SET_FLAG(j);
-        break;
-      }
-    }
-    for (int j = 0; j < num_head; j++) {
-      if (uhp_table[j] != NULL
-          && uhp_table[j]->uh_seq == uhp->uh_alt_prev.seq) {
-        uhp->uh_alt_prev.ptr = uhp_table[j];
-        SET_FLAG(j);
-        break;
-      }
+    if ((j = uhp_table_find(uhp_table, num_head, uhp->uh_next.seq)) >= 0) {
+      uhp->uh_next.ptr = uhp_table[j];
+      SET_FLAG(j);
     }
-    if (old_header_seq > 0 && old_idx < 0 && uhp->uh_seq == old_header_seq) {
-      assert(i <= SHRT_MAX);
-      old_idx = (short)i;
-      SET_FLAG(i);
+    if ((j = uhp_table_find(uhp_table, num_head, uhp->uh_prev.seq)) >= 0) {
+      uhp->uh_prev.ptr = uhp_table[j];
+      SET_FLAG(j);
     }
-    if (new_header_seq > 0 && new_idx < 0 && uhp->uh_seq == new_header_seq) {
-      assert(i <= SHRT_MAX);
-      new_idx = (short)i;
-      SET_FLAG(i);
+    if ((j = uhp_table_find(uhp_table, num_head,
+                            uhp->uh_alt_next.seq)) >= 0) {
+      uhp->uh_alt_next.ptr = uhp_table[j];
+      SET_FLAG(j);
     }
-    if (cur_header_seq > 0 && cur_idx < 0 && uhp->uh_seq == cur_header_seq) {
-      assert(i <= SHRT_MAX);
-      cur_idx = (short)i;
-      SET_FLAG(i);
+    if ((j = uhp_table_find(uhp_table, num_head,
+                            uhp->uh_alt_prev.seq)) >= 0) {
+      uhp->uh_alt_prev.ptr = uhp_table[j];
+      SET_FLAG(j);
     }
   }
+  const int old_idx = uhp_table_find(uhp_table, num_head, old_header_seq);
+  const int new_idx = uhp_table_find(uhp_table, num_head, new_header_seq);
+  const int cur_idx = uhp_table_find(uhp_table, num_head, cur_header_seq);
+#ifdef U_DEBUG
+  if (old_idx >= 0) {
+    SET_FLAG(old_idx);
+  }
+  if (new_idx >= 0) {
+    SET_FLAG(new_idx);
+  }
+  if (cur_idx >= 0) {
+    SET_FLAG(cur_idx);
+  }
+#endif
 
   // Now that we have read the undo info successfully, free the current undo
   // info and use the info from the file.
@@ -1650,6 +1645,7 @@ error:
   }
 
 theend:
+  xfree(bi.bi_buffer);
   if (fp != NULL) {
     fclose(fp);
   }
@@ -1658,6 +1654,38 @@ theend:
   }
 }
 
+/// Compares undo headers by sequence number, for qsort().
+static int uhp_seq_cmp(const void *a, const void *b)
+{
+  const long seq_a = (*(const u_header_T *const *)a)->uh_seq;
+  const long seq_b = (*(const u_header_T *const *)b)->uh_seq;
+  return seq_a < seq_b ? -1 : seq_a > seq_b;
+}
+
+/// Finds the header with sequence number "seq" in "table" sorted by
+/// uhp_seq_cmp().
+///
+/// @return index in "table" or -1 when not found.
+static int uhp_table_find(u_header_T **table, int size, long seq)
+{
+  if (seq <= 0) {
+    return -1;
+  }
+  int lo = 0;
+  int hi = size - 1;
+  while (lo <= hi) {
+    const int mid = lo + (hi - lo) / 2;
+    if (table[mid]->uh_seq == seq) {
+      return mid;
+    } else if (table[mid]->uh_seq < seq) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return -1;
+}
+
 /// Writes a sequence of bytes to the undo file.
 ///
 /// @param bi  The buffer info
@@ -1668,7 +1696,29 @@ theend:
 static bool undo_write(bufinfo_T *bi, uint8_t *ptr, size_t len)
   FUNC_ATTR_NONNULL_ARG(1)
 {
-  return fwrite(ptr, len, 1, bi->bi_fp) == 1;
+  if (bi->bi_used + len > UNDO_BUFSIZE && !undo_flush(bi)) {
+    return false;
+  }
+  if (len >= UNDO_BUFSIZE) {
+    return fwrite(ptr, len, 1, bi->bi_fp) == 1;
+  }
+  memcpy(bi->bi_buffer + bi->bi_used, ptr, len);
+  bi->bi_used += len;
+  return true;
+}
+
+/// Writes the data buffered by undo_write() to the undo file.
+///
+/// @returns false in case of an error.
+static bool undo_flush(bufinfo_T *bi)
+  FUNC_ATTR_NONNULL_ALL
+{
+  if (bi->bi_used == 0) {
+    return true;
+  }
+  const bool ok = fwrite(bi->bi_buffer, bi->bi_used, 1, bi->bi_fp) == 1;
+  bi->bi_used = 0;
+  return ok;
 }
 
 /// Writes a number, most significant bit first, in "len" bytes.
@@ -1701,24 +1751,63 @@ static void put_header_ptr(bufinfo_T *bi, u_header_T *uhp)
   undo_write_bytes(bi, (uint64_t)(uhp != NULL ? uhp->uh_seq : 0), 4);
 }
 
+/// Reads a number of "len" bytes, most significant bit first, like get4c().
+///
+/// @returns -1 when encountering EOF.
+static int64_t undo_read_nc(bufinfo_T *bi, size_t len)
+{
+  uint64_t n = 0;
+  if (bi->bi_avail - bi->bi_used >= len) {
+    const uint8_t *const p = bi->bi_buffer + bi->bi_used;
+    for (size_t i = 0; i < len; i++) {
+      n = (n << 8) + p[i];
+    }
+    bi->bi_used += len;
+    return (int64_t)n;
+  }
+  for (size_t i = 0; i < len; i++) {
+    const int c = undo_read_byte(bi);
+    if (c == EOF) {
+      return -1;
+    }
+    n = (n << 8) + (uint64_t)c;
+  }
+  return (int64_t)n;
+}
+
 static int undo_read_4c(bufinfo_T *bi)
 {
-  return get4c(bi->bi_fp);
+  const int64_t n = undo_read_nc(bi, 4);
+  return n < 0 ? -1 : (int)(uint32_t)n;
 }
 
 static int undo_read_2c(bufinfo_T *bi)
 {
-  return get2c(bi->bi_fp);
+  return (int)undo_read_nc(bi, 2);
 }
 
 static int undo_read_byte(bufinfo_T *bi)
 {
-  return getc(bi->bi_fp);
+  if (bi->bi_used == bi->bi_avail && !undo_fill(bi)) {
+    return EOF;
+  }
+  return bi->bi_buffer[bi->bi_used++];
 }
 
 static time_t undo_read_time(bufinfo_T *bi)
 {
-  return get8ctime(bi->bi_fp);
+  return (time_t)undo_read_nc(bi, 8);
+}
+
+/// Reads the next part of the undo file into bi->bi_buffer, which must have
+/// been used up.
+///
+/// @returns false at the end of the file or in case of an error.
+static bool undo_fill(bufinfo_T *bi)
+{
+  bi->bi_used = 0;
+  bi->bi_avail = fread(bi->bi_buffer, 1, UNDO_BUFSIZE, bi->bi_fp);
+  return bi->bi_avail > 0;
 }
 
 /// Reads "buffer[size]" from the undo file.
@@ -1731,7 +1820,24 @@ static time_t undo_read_time(bufinfo_T *bi)
 static bool undo_read(bufinfo_T *bi, uint8_t *buffer, size_t size)
   FUNC_ATTR_NONNULL_ARG(1)
 {
-  const bool retval = fread(buffer, size, 1, bi->bi_fp) == 1;
+  size_t done = MIN(size, bi->bi_avail - bi->bi_used);
+  memcpy(buffer, bi->bi_buffer + bi->bi_used, done);
+  bi->bi_used += done;
+  bool retval = true;
+  while (retval && done < size) {
+    if (size - done >= UNDO_BUFSIZE) {
+      // Big chunk: read it directly.
+      retval = fread(buffer + done, size - done, 1, bi->bi_fp) == 1;
+      done = size;
+    } else if (undo_fill(bi)) {
+      const size_t n = MIN(size - done, bi->bi_avail);
+      memcpy(buffer + done, bi->bi_buffer, n);
+      bi->bi_used = n;
+      done += n;
+    } else {
+      retval = false;
+    }
+  }
   if (!retval) {
     // Error may be checked for only later.  Fill with zeros,
     // so that the reader won't use garbage.
@@ -2238,6 +2344,7 @@ target_zero:
 static void u_undoredo(int undo, bool do_buf_event)
 {
   char_u      **newarray = NULL;
+  char_u      *newtext = NULL;
   linenr_T oldsize;
   linenr_T newsize;
   linenr_T top, bot;
@@ -2322,11 +2429,9 @@ static void u_undoredo(int undo, bool do_buf_event)
 
     /* delete the lines between top and bot and save them in newarray */
     if (oldsize > 0) {
-      newarray = xmalloc(sizeof(char_u *) * (size_t)oldsize);
+      newarray = u_save_lines(top + 1, oldsize, false, &newtext);
       /* delete backwards, it goes faster in most cases */
       for (lnum = bot - 1, i = oldsize; --i >= 0; --lnum) {
-        /* what can we do when we run out of memory? */
-        newarray[i] = u_save_line(lnum);
         /* remember we deleted the last line in the buffer, and a
          * dummy empty line will be inserted */
         if (curbuf->b_ml.ml_line_count == 1) {
@@ -2334,8 +2439,10 @@ static void u_undoredo(int undo, bool do_buf_event)
         }
         ml_delete(lnum, false);
       }
-    } else
+    } else {
       newarray = NULL;
+      newtext = NULL;
+    }
 
     /* insert the lines in u_array between top and bot */
     if (newsize) {
@@ -2349,8 +2456,11 @@ static void u_undoredo(int undo, bool do_buf_event)
         } else {
           ml_append(lnum, uep->ue_array[i], (colnr_T)0, false);
         }
-        xfree(uep->ue_array[i]);
+        if (uep->ue_text == NULL) {
+          xfree(uep->ue_array[i]);
+        }
       }
+      xfree(uep->ue_text);
       xfree((char_u *)uep->ue_array);
     }
 
@@ -2380,6 +2490,7 @@ static void u_undoredo(int undo, bool do_buf_event)
     u_oldcount += oldsize;
     uep->ue_size = oldsize;
     uep->ue_array = newarray;
+    uep->ue_text = newtext;
     uep->ue_bot = top + newsize + 1;
 
     /*
@@ -2946,8 +3057,12 @@ u_freeentries(
  */
 static void u_freeentry(u_entry_T *uep, long n)
 {
+  if (uep->ue_text != NULL) {
+    n = 0;  // lines are in ue_text
+  }
   while (n > 0)
     xfree(uep->ue_array[--n]);
+  xfree(uep->ue_text);
   xfree((char_u *)uep->ue_array);
 #ifdef U_DEBUG
   uep->ue_magic = 0;
@@ -3056,6 +3171,54 @@ static char_u *u_save_line(linenr_T lnum)
   return vim_strsave(ml_get(lnum));
 }
 
+/// Copy "size" lines from line "lnum" into one block of memory.  Much faster
+/// and smaller than allocating each line when a big change is saved.
+///
+/// @param  interrupt  Stop when CTRL-C was typed.
+/// @param[out]  textp  Set to the block, to be freed with xfree().
+///
+/// @return Array with a pointer into the block for each line, NULL when
+///         interrupted.
+static char_u **u_save_lines(linenr_T lnum, long size, bool interrupt,
+                             char_u **textp)
+{
+  size_t len = 0;
+  size_t cap = 0;
+  char_u *text = NULL;
+
+  for (long i = 0; i < size; i++) {
+    if (interrupt) {
+      fast_breakcheck();
+      if (got_int) {
+        xfree(text);
+        *textp = NULL;
+        return NULL;
+      }
+    }
+    const char_u *const line = ml_get(lnum + (linenr_T)i);
+    const size_t n = STRLEN(line) + 1;
+    if (len + n > cap) {
+      cap = MAX(cap * 2, len + n);
+      text = xrealloc(text, cap);
+    }
+    memcpy(text + len, line, n);
+    len += n;
+  }
+  if (len < cap) {
+    text = xrealloc(text, len);
+  }
+
+  // Lines don't contain a NUL, it is stored as NL.
+  char_u **const array = xmalloc(sizeof(char_u *) * (size_t)size);
+  char_u *p = text;
+  for (long i = 0; i < size; i++) {
+    array[i] = p;
+    p += STRLEN(p) + 1;
+  }
+  *textp = text;
+  return array;
+}
+
 /// Check if the 'modified' flag is set, or 'ff' has changed (only need to
 /// check the first character, because it can only be "dos", "unix" or "mac").
 /// "nofile" and "scratch" type buffers are considered to always be unchanged.
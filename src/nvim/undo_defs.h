@@ -1,6 +1,7 @@
 #ifndef NVIM_UNDO_DEFS_H
 #define NVIM_UNDO_DEFS_H
 
+#include <stdint.h>
 #include <time.h>  // for time_t
 
 #include "nvim/pos.h"
@@ -27,6 +28,8 @@ struct u_entry {
   linenr_T ue_lcount;           /* linecount when u_save called */
   char_u      **ue_array;       /* array of lines in undo block */
   long ue_size;                 /* number of lines in ue_array */
+  char_u      *ue_text;         // when not NULL: text of all lines in
+                                // ue_array, they are not allocated each
 #ifdef U_DEBUG
   int ue_magic;                 /* magic number to check allocation */
 #endif
@@ -78,6 +81,9 @@ struct u_header {
 typedef struct {
   buf_T *bi_buf;
   FILE *bi_fp;
+  uint8_t *bi_buffer;  ///< buffered data, UNDO_BUFSIZE bytes
+  size_t bi_used;      ///< writing: bytes in bi_buffer, reading: bytes used
+  size_t bi_avail;     ///< reading: bytes in bi_buffer
 } bufinfo_T;
 
 #endif // NVIM_UNDO_DEFS_H
@@ -0,0 +1,52 @@
+-- Test for benchmarking json_decode() on large LSP-like payloads.
+
+local helpers = require('test.functional.helpers')(after_each)
+local clear, source, eval = helpers.clear, helpers.source, helpers.eval
+
+-- Vim script code that builds the payload and measures decoding it.
+local measure_script = [[
+    func! MakePayload(n)
+      let items = []
+      for i in range(a:n)
+        call add(items, {
+              \ 'label': 'completion_item_' . i,
+              \ 'kind': i % 25,
+              \ 'detail': 'fun(a: string, b: number): table<string, any>',
+              \ 'documentation': {'kind': 'markdown',
+              \                   'value': "Some\n\"escaped\"\tdocs " . i},
+              \ 'textEdit': {'range': {'start': {'line': i, 'character': 0},
+              \                        'end': {'line': i, 'character': 10}},
+              \              'newText': 'completion_item_' . i},
+              \ 'sortText': printf('%08d', i),
+              \ 'deprecated': v:false,
+              \ })
+      endfor
+      return json_encode({'jsonrpc': '2.0', 'id': 1,
+            \             'result': {'isIncomplete': v:false, 'items': items}})
+    endfunc
+
+    func! Measure(payload, count)
+      let start = reltime()
+      for _ in range(a:count)
+        call json_decode(a:payload)
+      endfor
+      return printf('size: %d bytes, decodes: %d, time: %s',
+            \ len(a:payload), a:count, reltimestr(reltime(start)))
+    endfunc]]
+
+describe('json_decode()', function()
+  setup(function()
+    clear()
+    source(measure_script)
+  end)
+
+  it('decodes a 1MB payload', function()
+    source('let g:payload = MakePayload(3000)')
+    print('\n' .. eval('Measure(g:payload, 10)'))
+  end)
+
+  it('decodes a 10MB payload', function()
+    source('let g:payload = MakePayload(30000)')
+    print('\n' .. eval('Measure(g:payload, 3)'))
+  end)
+end)
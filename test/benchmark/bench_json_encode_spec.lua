@@ -0,0 +1,48 @@
+-- Test for benchmarking json_encode() on large nested dictionaries.
+
+local helpers = require('test.functional.helpers')(after_each)
+local clear, source, eval = helpers.clear, helpers.source, helpers.eval
+
+-- Vim script code that builds the values and measures encoding them.
+local measure_script = [[
+    func! MakeValue(n, ascii)
+      let text = a:ascii ? 'plain ascii text' : "téxt with \"escapes\"\n"
+      let items = []
+      for i in range(a:n)
+        call add(items, {
+              \ 'uri': 'file:///home/user/project/src/file_' . i . '.c',
+              \ 'range': {'start': {'line': i, 'character': 1},
+              \           'end': {'line': i + 1, 'character': 0}},
+              \ 'message': text . i,
+              \ 'tags': [1, 2],
+              \ 'data': {'nested': {'deeper': {'value': 0.5, 'flag': v:true}}},
+              \ })
+      endfor
+      return {'diagnostics': items}
+    endfunc
+
+    func! Measure(value, count)
+      let start = reltime()
+      for _ in range(a:count)
+        let s = json_encode(a:value)
+      endfor
+      return printf('size: %d bytes, encodes: %d, time: %s',
+            \ len(s), a:count, reltimestr(reltime(start)))
+    endfunc]]
+
+describe('json_encode()', function()
+  setup(function()
+    clear()
+    source(measure_script)
+  end)
+
+  it('encodes ASCII-only values', function()
+    source('let g:value = MakeValue(50000, 1)')
+    print('\n' .. eval('Measure(g:value, 5)'))
+  end)
+
+  it('encodes values with escapes and non-ASCII text', function()
+    source('let g:value = MakeValue(50000, 0)')
+    print('\n' .. eval('Measure(g:value, 5)'))
+  end)
+end)
@@ -0,0 +1,48 @@
+-- Test for benchmarking overhead of calling VimL functions from lua.
+
+local helpers = require('test.functional.helpers')(after_each)
+local clear, exec_lua = helpers.clear, helpers.exec_lua
+
+-- Lua code that does the work and measures it, returns a report line.
+local measure = function(name, count, code)
+  local time = exec_lua([[
+    local count, code = ...
+    local f = assert(loadstring(code))
+    local start = vim.loop.hrtime()
+    for _ = 1, count do
+      f()
+    end
+    return (vim.loop.hrtime() - start) / 1e6
+  ]], count, code)
+  print(('\n%s: %d calls, %.1f ms'):format(name, count, time))
+end
+
+describe('vim.fn', function()
+  setup(function()
+    clear()
+    exec_lua([[
+      local lines = {}
+      for i = 1, 100000 do
+        lines[i] = ('line %d with some text in it'):format(i)
+      end
+      _G.lines = lines
+      vim.api.nvim_buf_set_lines(0, 0, -1, true, lines)
+    ]])
+  end)
+
+  it('calls a function with scalar arguments', function()
+    measure('strlen()', 100000, [[vim.fn.strlen('some string')]])
+  end)
+
+  it('calls getline() on a single line', function()
+    measure('getline(n)', 100000, [[vim.fn.getline(50000)]])
+  end)
+
+  it('returns a large list of strings', function()
+    measure("getline(1, '$')", 20, [[vim.fn.getline(1, '$')]])
+  end)
+
+  it('passes a large list of strings', function()
+    measure('setline(1, lines)', 20, [[vim.fn.setline(1, _G.lines)]])
+  end)
+end)
@@ -12,6 +12,10 @@ local sample_file = 'test/benchmark/samples/re.freeze.txt'
 -- Vim script code that does both the work and the benchmarking of that work.
 local measure_cmd =
     [[call Measure(%d, ']] .. sample_file .. [[', '\s\+\%%#\@<!$', '+5')]]
+-- Pattern without look-around which does not match, the DFA can be used.
+local measure_dfa_cmd =
+    [[call Measure(%d, ']] .. sample_file
+    .. [[', '<\(td\|font\) [a-z]\+=\(#\x\+\|"[^"]*"\)\s*\/>', '+5')]]
 local measure_script = [[
     func! Measure(re, file, pattern, arg)
       let sstart=reltime()
@@ -61,4 +65,18 @@ describe('regexp search', function()
     command(string.format(measure_cmd, regexpengine))
     command('write')
   end)
+
+  it('is working with regexpengine=3', function()
+    local regexpengine = 3
+    command(string.format(measure_cmd, regexpengine))
+    command('write')
+  end)
+
+  for _, regexpengine in ipairs({1, 2, 3}) do
+    it('is working without a match with regexpengine=' .. regexpengine,
+       function()
+      command(string.format(measure_dfa_cmd, regexpengine))
+      command('write')
+    end)
+  end
 end)
@@ -0,0 +1,69 @@
+-- Test for benchmarking startup and runtime file lookups with many packages.
+
+local helpers = require('test.functional.helpers')(after_each)
+local luv = require('luv')
+local clear, eval, exec = helpers.clear, helpers.eval, helpers.exec
+local mkdir_p, rmdir = helpers.mkdir_p, helpers.rmdir
+local write_file = helpers.write_file
+
+local pack_dir = luv.cwd() .. '/Xbench_pack'
+local startuptime_file = 'Xbench_startuptime'
+local npackages = 150
+
+-- Returns the time it took to start Nvim, in milliseconds.
+local function startup_time()
+  local time
+  for line in io.lines(startuptime_file) do
+    time = line:match('^(%d+%.%d+).*NVIM STARTED') or time
+  end
+  return tonumber(time)
+end
+
+describe('runtime files', function()
+  setup(function()
+    for i = 1, npackages do
+      local plug = ('%s/pack/bench/start/plugin_%d'):format(pack_dir, i)
+      for _, sub in ipairs({'plugin', 'ftplugin', 'syntax', 'autoload'}) do
+        mkdir_p(plug .. '/' .. sub)
+      end
+      write_file(plug .. '/plugin/plugin_' .. i .. '.vim',
+                 'let g:loaded_plugin_' .. i .. ' = 1')
+      write_file(plug .. '/ftplugin/ft' .. (i % 10) .. '.vim',
+                 'let b:ftplugin_' .. i .. ' = 1')
+    end
+  end)
+
+  teardown(function()
+    rmdir(pack_dir)
+    os.remove(startuptime_file)
+  end)
+
+  it('starts with ' .. npackages .. ' packages', function()
+    local times = {}
+    for i = 1, 5 do
+      os.remove(startuptime_file)
+      clear{args = {'--startuptime', startuptime_file,
+                    '--cmd', 'set packpath^=' .. pack_dir,
+                    '--cmd', 'filetype plugin indent on',
+                    '--cmd', 'syntax on'}}
+      times[i] = startup_time()
+    end
+    table.sort(times)
+    print(('\nstartup: median %.1f ms, min %.1f ms'):format(times[3], times[1]))
+  end)
+
+  it('sets filetype with ' .. npackages .. ' packages', function()
+    clear{args = {'--cmd', 'set packpath^=' .. pack_dir,
+                  '--cmd', 'filetype plugin indent on',
+                  '--cmd', 'syntax on'}}
+    exec([[
+      let g:start = reltime()
+      for i in range(200)
+        enew
+        let &filetype = 'ft' . (i % 10)
+      endfor
+      let g:elapsed = reltimestr(reltime(g:start))
+    ]])
+    print('\n200 filetype changes: ' .. eval('g:elapsed') .. ' s')
+  end)
+end)
@@ -0,0 +1,46 @@
+-- Test for benchmarking :g, :s and / in a large buffer, where most lines do
+-- not contain the text the pattern requires.  With the NFA engine :g and :s
+-- match the lines on worker threads.
+
+local helpers = require('test.functional.helpers')(after_each)
+local clear, command, eval = helpers.clear, helpers.command, helpers.eval
+local exec_lua = helpers.exec_lua
+
+local nlines = 1000000
+
+local function run(name, cmd)
+  command('let g:start = reltime()')
+  command(cmd)
+  print(('\n%s: %s'):format(name, eval('reltimestr(reltime(g:start))')))
+end
+
+describe('search in a large buffer', function()
+  before_each(function()
+    clear()
+    exec_lua([[
+      local nlines = ...
+      local lines = {}
+      for i = 1, nlines do
+        if i % 1000 == 0 then
+          lines[i] = '  call_function(' .. i .. ', "needle");'
+        else
+          lines[i] = '  other_function(' .. i .. ', "haystack");'
+        end
+      end
+      vim.api.nvim_buf_set_lines(0, 0, -1, true, lines)
+    ]], nlines)
+  end)
+
+  for _, re in ipairs({1, 2, 3}) do
+    it('with regexpengine=' .. re, function()
+      command('set regexpengine=' .. re)
+      run(':g re=' .. re, [[silent g/\w\+(\d\+, "needle"/]])
+      run(':s re=' .. re, [[silent %s/(\zs\d\+\ze, "needle"/0/e]])
+      -- No text every match contains, each line needs the full matcher.
+      run(':g no required text re=' .. re,
+          [[silent g/\v^\s+\w+_\w+\(\d*000, "[a-z]+"/]])
+      run('/ re=' .. re,
+          [[silent! call search('\<\w*_function(\d\+, "pin"', 'W')]])
+    end)
+  end
+end)
@@ -0,0 +1,69 @@
+-- Test for benchmarking startup with a large ShaDa file.
+
+local helpers = require('test.functional.helpers')(after_each)
+local clear, command, eval = helpers.clear, helpers.command, helpers.eval
+local exec_lua = helpers.exec_lua
+
+local shada_file = 'Xbench_shada'
+local startuptime_file = 'Xbench_startuptime'
+local nhistory = 10000
+
+-- Returns the times it took to start Nvim and to read the ShaDa file, in
+-- milliseconds.
+local function startup_time()
+  local time, shada
+  for line in io.lines(startuptime_file) do
+    time = line:match('^(%d+%.%d+).*NVIM STARTED') or time
+    shada = line:match('^%d+%.%d+%s+(%d+%.%d+).*reading ShaDa') or shada
+  end
+  return tonumber(time), tonumber(shada)
+end
+
+describe('ShaDa', function()
+  setup(function()
+    clear{args_rm = {'-i'}, args = {'-i', shada_file}}
+    command('set shada=!,\'100,<1000,s100,h history=' .. nhistory)
+    exec_lua([[
+      local nhistory = ...
+      for i = 1, nhistory do
+        for _, t in ipairs({'cmd', 'search', 'expr', 'input'}) do
+          vim.fn.histadd(t, ('%s history entry number %d'):format(t, i))
+        end
+      end
+      for c in ('abcdefghijklmnopqrstuvwxyz'):gmatch('.') do
+        local lines = {}
+        for i = 1, 200 do
+          lines[i] = ('line %d of register %s'):format(i, c)
+        end
+        vim.fn.setreg(c, lines, 'l')
+      end
+    ]], nhistory)
+    command('wshada!')
+    print(('\nShaDa file size: %d'):format(
+          eval(("getfsize('%s')"):format(shada_file))))
+  end)
+
+  teardown(function()
+    os.remove(shada_file)
+    os.remove(startuptime_file)
+  end)
+
+  it('starts with ' .. nhistory .. ' history entries', function()
+    local times, shada_times = {}, {}
+    for i = 1, 5 do
+      os.remove(startuptime_file)
+      clear{args_rm = {'-i'},
+            args = {'-i', shada_file, '--startuptime', startuptime_file,
+                    '--cmd', 'set history=' .. nhistory}}
+      times[i], shada_times[i] = startup_time()
+    end
+    table.sort(times)
+    table.sort(shada_times)
+    print(('\nstartup: median %.1f ms, reading ShaDa: median %.1f ms'):format(
+          times[3], shada_times[3]))
+    -- First use of history and registers, which decodes them.
+    command('let g:start = reltime()')
+    eval('histget(":", -1) . getreg("a")')
+    print('\nfirst use: ' .. eval('reltimestr(reltime(g:start))') .. ' s')
+  end)
+end)
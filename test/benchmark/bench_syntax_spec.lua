@@ -0,0 +1,101 @@
+-- Test for benchmarking syntax highlighting when jumping around in a large
+-- buffer.
+
+local helpers = require('test.functional.helpers')(after_each)
+local Screen = require('test.functional.ui.screen')
+local clear, command, eval = helpers.clear, helpers.command, helpers.eval
+local exec_lua, source = helpers.exec_lua, helpers.source
+local sleep = helpers.sleep
+
+local nlines = 100000
+
+-- Vim script code that jumps around and measures it.
+local measure_script = [[
+    func! Measure(cmds, count)
+      let start = reltime()
+      for _ in range(a:count)
+        for cmd in a:cmds
+          exe 'normal!' cmd
+          redraw
+        endfor
+      endfor
+      return printf('%d jumps, time: %s', len(a:cmds) * a:count,
+            \ reltimestr(reltime(start)))
+    endfunc]]
+
+describe('syntax highlighting', function()
+  before_each(function()
+    clear()
+    local screen = Screen.new(100, 50)
+    screen:attach()
+    source(measure_script)
+    exec_lua([[
+      local nlines = ...
+      local lines = {}
+      for i = 1, nlines, 10 do
+        lines[i] = '/* comment for function ' .. i .. ' */'
+        lines[i + 1] = 'static int function_' .. i .. '(int a, char *b)'
+        lines[i + 2] = '{'
+        lines[i + 3] = '  if (a > ' .. i .. ') {'
+        lines[i + 4] = '    return printf("%s: %d\\n", b, a);'
+        lines[i + 5] = '  }'
+        lines[i + 6] = '  /* a comment'
+        lines[i + 7] = '   * spanning lines */'
+        lines[i + 8] = '  return 0;'
+        lines[i + 9] = '}'
+      end
+      vim.api.nvim_buf_set_lines(0, 0, -1, true, lines)
+    ]], nlines)
+    command('syntax on')
+    command('set filetype=c')
+    command('redraw')
+  end)
+
+  local function run(name, cmds, count)
+    local list = "['" .. table.concat(cmds, "', '") .. "']"
+    print(('\n%s: %s'):format(name, eval(('Measure(%s, %d)'):format(list,
+                                                                  count))))
+  end
+
+  it('jumps between the first and last line', function()
+    run('G/gg', {'G', 'gg'}, 50)
+  end)
+
+  it('jumps between the first and last line with sync fromstart', function()
+    command('syntax sync fromstart')
+    run('G/gg fromstart', {'G', 'gg'}, 50)
+  end)
+
+  it('jumps to the last line after being idle with sync fromstart',
+     function()
+    command('syntax sync fromstart')
+    command('redraw')
+    -- Give the background parsing time to reach the end of the buffer. Not
+    -- with :sleep, background parsing waits until it is done.
+    sleep(3000)
+    run('G idle fromstart', {'G'}, 1)
+  end)
+
+  it('jumps around with many keywords', function()
+    -- Keywords which are in the text, and many which are not.
+    command('syntax keyword Function function_1 function_11 function_21')
+    command('syntax case ignore')
+    for i = 1, 500 do
+      command(('syntax keyword Keyword kw%d KW_%d_x'):format(i, i))
+    end
+    local cmds = {}
+    for i = 1, 9 do
+      cmds[#cmds + 1] = (i * 11 % 100) .. '%'
+    end
+    run('N% keywords', cmds, 20)
+  end)
+
+  it('jumps all over the buffer with sync fromstart', function()
+    command('syntax sync fromstart')
+    local cmds = {}
+    for i = 1, 9 do
+      cmds[#cmds + 1] = (i * 11 % 100) .. '%'
+    end
+    run('N% fromstart', cmds, 20)
+  end)
+end)
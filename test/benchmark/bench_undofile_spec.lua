@@ -0,0 +1,54 @@
+-- Test for benchmarking writing and reading an undo file with a long history
+-- of changes to a large buffer.
+
+local helpers = require('test.functional.helpers')(after_each)
+local clear, command, eval = helpers.clear, helpers.command, helpers.eval
+local exec_lua = helpers.exec_lua
+
+local nlines = 100000
+local nchanges = 1000
+
+local function run(name, cmd)
+  command('let g:start = reltime()')
+  command(cmd)
+  print(('\n%s: %s'):format(name, eval('reltimestr(reltime(g:start))')))
+end
+
+describe('undo file', function()
+  local undofile = 'Xtest_bench_undofile'
+
+  before_each(function()
+    clear()
+    command('set undolevels=' .. nchanges * 2)
+    exec_lua([[
+      local nlines, nchanges = ...
+      local lines = {}
+      for i = 1, nlines do
+        lines[i] = ('line %d of the buffer with some text'):format(i)
+      end
+      vim.api.nvim_buf_set_lines(0, 0, -1, true, lines)
+      -- Many small changes, a few which change every line.
+      for i = 1, nchanges do
+        vim.cmd('let &undolevels = &undolevels')
+        if i % 100 == 0 then
+          vim.cmd('silent %s/text/TEXT' .. i .. '/')
+        else
+          local l = (i * 97) % nlines
+          vim.api.nvim_buf_set_lines(0, l, l + 1, true, {'changed ' .. i})
+        end
+      end
+    ]], nlines, nchanges)
+  end)
+
+  after_each(function()
+    os.remove(undofile)
+  end)
+
+  it('write and read', function()
+    run('wundo', 'wundo! ' .. undofile)
+    run('rundo', 'rundo ' .. undofile)
+    print(('\nundo states: %d, file size: %d'):format(
+          eval('len(undotree().entries)'),
+          eval(("getfsize('%s')"):format(undofile))))
+  end)
+end)
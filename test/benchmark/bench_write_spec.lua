@@ -0,0 +1,43 @@
+-- Test for benchmarking writing a large buffer and getting its lines.
+
+local helpers = require('test.functional.helpers')(after_each)
+local clear, command, eval = helpers.clear, helpers.command, helpers.eval
+local exec_lua = helpers.exec_lua
+
+local fname = 'Xtest_bench_write'
+local nlines = 500000
+
+local function run(name, cmd)
+  command('let g:start = reltime()')
+  command(cmd)
+  print(('\n%s: %s'):format(name, eval('reltimestr(reltime(g:start))')))
+end
+
+describe('writing a buffer', function()
+  before_each(function()
+    clear()
+    exec_lua([[
+      local nlines = ...
+      local lines = {}
+      for i = 1, nlines do
+        lines[i] = ('line %d of the buffer with some text'):format(i)
+      end
+      vim.api.nvim_buf_set_lines(0, 0, -1, true, lines)
+    ]], nlines)
+  end)
+
+  after_each(function()
+    os.remove(fname)
+  end)
+
+  it('with :write', function()
+    run(':write', 'write! ' .. fname)
+    run(':write ff=dos', 'set ff=dos | write! ' .. fname)
+    run(':write !cat', 'set noshelltemp | silent write !cat > /dev/null')
+  end)
+
+  it('with nvim_buf_get_lines()', function()
+    run('nvim_buf_get_lines()',
+        'lua for _ = 1, 5 do vim.api.nvim_buf_get_lines(0, 0, -1, true) end')
+  end)
+end)
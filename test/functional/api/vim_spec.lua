@@ -2195,4 +2195,98 @@ describe('API', function()
       ]]}
     end)
   end)
+
+  describe('nvim__latency', function()
+    it('collects latency statistics', function()
+      feed('ihello<esc>')
+      eq('hello', meths.get_current_line())
+      local stats = meths._latency(false)
+      for _, phase in ipairs({'key', 'input', 'vgetc', 'execute', 'rpc'}) do
+        local s = stats[phase]
+        ok(s ~= nil, phase)
+        ok(s.count > 0)
+        ok(s.min <= s.p50 and s.p50 <= s.p90 and s.p90 <= s.p99
+           and s.p99 <= s.p999 and s.p999 <= s.max)
+      end
+    end)
+
+    it('resets the statistics', function()
+      feed('ihello<esc>')
+      ok(meths._latency(true).key ~= nil)
+      eq(nil, meths._latency(false).key)
+    end)
+  end)
+
+  describe('nvim__stats', function()
+    it('counts regexp cache hits', function()
+      local before = meths._stats()
+      eq(1, funcs.match('xfooy', [[f\%(o\)\+y]]))
+      eq(-1, funcs.match('xfoy', [[f\%(o\)\{2}y]]))
+      eq(1, funcs.match('xfooy', [[f\%(o\)\+y]]))
+      local after = meths._stats()
+      ok(after.regexp_cache_miss >= before.regexp_cache_miss + 2)
+      ok(after.regexp_cache_hit >= before.regexp_cache_hit + 1)
+      -- "~" depends on the previous substitute string, never cached.
+      command('s/^/bar/')
+      command('s/^/foo/')
+      eq('foobar', meths.get_current_line())
+      eq(0, funcs.match('foobar', '~'))
+      command('s/^/baz/')
+      eq(-1, funcs.match('foobar', '~'))
+    end)
+  end)
+
+  describe('nvim__trace_dump', function()
+    local fname, script
+    before_each(function()
+      fname = tmpname()
+      script = tmpname()
+    end)
+    after_each(function()
+      os.remove(fname)
+      os.remove(script)
+    end)
+
+    local function read_spans()
+      local trace = funcs.json_decode(funcs.readfile(fname))
+      local spans = {}
+      for _, ev in ipairs(trace.traceEvents) do
+        if ev.ph == 'X' then
+          spans[ev.cat..':'..ev.name] = ev.args and ev.args.detail or ''
+        end
+      end
+      return spans
+    end
+
+    it('writes the recorded spans in trace-event format', function()
+      write_file(script, 'let g:sourced = 1\n')
+      meths._trace_start(0)
+      command('autocmd User TraceTest let g:fired = 1')
+      command('source '..script)
+      command('doautocmd User TraceTest')
+      eq({1, 1}, eval('[g:sourced, g:fired]'))
+      ok(meths._trace_dump(fname) >= 3)
+
+      local spans = read_spans()
+      ok(endswith(spans['vim:source'], script:match('[^/\\]*$')))
+      eq('TraceTest', spans['autocmd:User'])
+      eq('', spans['rpc:nvim_command'])
+    end)
+
+    it('keeps only the last spans', function()
+      meths._trace_start(2)
+      for i = 1, 5 do
+        command('let g:x = '..i)
+      end
+      eq(2, meths._trace_dump(fname))
+      meths._trace_stop()
+      eq(0, meths._trace_dump(fname))
+      eq({}, read_spans())
+    end)
+
+    it('fails for a file which cannot be written', function()
+      eq('Failed to open Xnonexistent/trace.json',
+         pcall_err(meths._trace_dump, 'Xnonexistent/trace.json'))
+    end)
+  end)
 end)
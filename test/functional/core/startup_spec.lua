@@ -545,6 +545,55 @@ describe('runtime:', function()
     rmdir(plugin_path)
   end)
 
+  it('sources start plugins in order while reading them in advance', function()
+    local pack_path = table.concat({xconfig, 'nvim', 'pack', 'order', 'start'}, pathsep)
+    local profiler_file = 'test_startuptime.log'
+    for _, name in ipairs({'a', 'b', 'c'}) do
+      local plugin_folder = table.concat({pack_path, name, 'plugin'}, pathsep)
+      mkdir_p(plugin_folder)
+      write_file(plugin_folder .. pathsep .. name .. '.vim',
+                 "call add(g:order, '" .. name .. "')")
+      write_file(plugin_folder .. pathsep .. name .. '.lua',
+                 "local order = vim.g.order_lua; table.insert(order, '" .. name
+                 .. "'); vim.g.order_lua = order")
+    end
+    -- A plugin changing a plugin sourced after it: the new contents are used.
+    local c_file = table.concat({pack_path, 'c', 'plugin', 'c.vim'}, pathsep)
+    write_file(table.concat({pack_path, 'a', 'plugin', 'a.vim'}, pathsep),
+               "call add(g:order, 'a')\n"
+               .. "call writefile(['call add(g:order, \"c2\")'], '" .. c_file .. "')")
+
+    clear{ args_rm={'-u'}, args={'--startuptime', profiler_file,
+                                 '--cmd', 'let g:order = [] | let g:order_lua = []'},
+           env={ XDG_CONFIG_HOME=xconfig }}
+
+    eq({'a', 'b', 'c2'}, eval('g:order'))
+    eq({'a', 'b', 'c'}, eval('g:order_lua'))
+    local profile_reader = io.open(profiler_file, 'r')
+    local profile_log = profile_reader:read('*a')
+    profile_reader:close()
+    assert.Truthy(profile_log:find('read in background'))
+
+    os.remove(profiler_file)
+    rmdir(table.concat({xconfig, 'nvim', 'pack'}, pathsep))
+  end)
+
+  it('sources Lua plugins in a directory added by a Vim plugin', function()
+    local after_folder = table.concat({xconfig, 'nvim', 'after', 'plugin'}, pathsep)
+    local extra_path = table.concat({xconfig, 'extra'}, pathsep)
+    local extra_folder = table.concat({extra_path, 'after', 'plugin'}, pathsep)
+    mkdir_p(after_folder)
+    mkdir_p(extra_folder)
+    write_file(after_folder .. pathsep .. 'add.vim', 'set rtp+=' .. extra_path)
+    write_file(extra_folder .. pathsep .. 'extra.lua', 'vim.g.extra_lua = 1')
+
+    clear{ args_rm={'-u'}, env={ XDG_CONFIG_HOME=xconfig }}
+    eq(1, eval('get(g:, "extra_lua")'))
+
+    rmdir(table.concat({xconfig, 'nvim', 'after'}, pathsep))
+    rmdir(extra_path)
+  end)
+
   it('loads ftdetect/*.lua', function()
     local ftdetect_folder = table.concat({xconfig, 'nvim', 'ftdetect'}, pathsep)
     local ftdetect_file = table.concat({ftdetect_folder , 'new-ft.lua'}, pathsep)
@@ -3,6 +3,7 @@ local clear = helpers.clear
 local funcs = helpers.funcs
 local meths = helpers.meths
 local eq = helpers.eq
+local ok = helpers.ok
 local eval = helpers.eval
 local command = helpers.command
 local exc_exec = helpers.exc_exec
@@ -315,6 +316,21 @@ describe('json_decode() function', function()
        funcs.json_decode('{"1": 2, "3": [{"4": {"5": [[], 1]}}]}'))
   end)
 
+  it('parses many dictionaries sharing keys', function()
+    local stats = meths._stats()
+    eq({{a=1, b={a=2}}, {b=3, a=4}, {a={a={a=5}}}},
+       funcs.json_decode('[{"a": 1, "b": {"a": 2}}, {"b": 3, "a": 4}, '
+                         .. '{"a": {"a": {"a": 5}}}]'))
+    local new_stats = meths._stats()
+    -- "a" is decoded six times and "b" twice, each is interned once.
+    ok(new_stats.intern_hit >= stats.intern_hit + 6)
+    ok(new_stats.intern_keys <= stats.intern_keys + 2)
+    local long_key = ('k'):rep(1000)
+    eq({{[long_key]=1}, {[long_key]=2}},
+       funcs.json_decode('[{"' .. long_key .. '": 1}, {"' .. long_key
+                         .. '": 2}]'))
+  end)
+
   it('fails to parse incomplete strings', function()
     eq('Vim(call):E474: Expected string end: \t"',
        exc_exec('call json_decode("\\t\\"")'))
@@ -536,6 +552,7 @@ describe('json_encode() function', function()
     eq('"\\n"', funcs.json_encode('\n'))
     eq('"\\u001B"', funcs.json_encode('\27'))
     eq('"þÿþ"', funcs.json_encode('þÿþ'))
+    eq('"ab\\"cd\\\\ef\\tþg"', funcs.json_encode('ab"cd\\ef\tþg'))
   end)
 
   it('dumps numbers', function()
@@ -689,6 +706,14 @@ describe('json_encode() function', function()
        exc_exec('call json_encode(todump)'))
   end)
 
+  it('fails to dump a recursive list with more items', function()
+    command('let todump = []')
+    command('call add(todump, todump)')
+    command('call extend(todump, range(10))')
+    eq('Vim(call):E724: unable to correctly dump variable with self-referencing container',
+       exc_exec('call json_encode(todump)'))
+  end)
+
   it('fails to dump a recursive dict', function()
     command('let todump = {"d": {"d": {}}}')
     command('call extend(todump.d.d, {"d": todump})')
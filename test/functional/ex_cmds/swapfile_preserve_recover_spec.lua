@@ -6,6 +6,7 @@ local eq, eval, expect, source =
 local clear = helpers.clear
 local command = helpers.command
 local feed = helpers.feed
+local meths = helpers.meths
 local nvim_prog = helpers.nvim_prog
 local ok = helpers.ok
 local rmdir = helpers.rmdir
@@ -174,3 +175,84 @@ describe('swapfile detection', function()
     feed('<cr>')
   end)
 end)
+
+describe("'swapcache'", function()
+  local swapdir = lfs.currentdir()..'/Xtest_swapcache_dir'
+  before_each(function()
+    clear()
+    rmdir(swapdir)
+    lfs.mkdir(swapdir)
+  end)
+  after_each(function()
+    command('%bwipeout!')
+    rmdir(swapdir)
+  end)
+
+  it('keeps buffer text within the limit using the swap file', function()
+    source([[
+      set directory^=]]..swapdir:gsub([[\]], [[\\]])..[[//
+      set swapfile undolevels=-1 hidden
+    ]])
+    command('edit! Xtest_swapcache_file1')
+    local lines = {}
+    for i = 1, 20000 do
+      lines[i] = ('line %d with some text to fill the blocks'):format(i)
+    end
+    meths.buf_set_lines(0, 0, -1, true, lines)
+    ok(meths._stats().memfile_cache_bytes > 256 * 1024)
+    command('set swapcache=256')
+    local stats = meths._stats()
+    ok(stats.memfile_cache_bytes <= 256 * 1024)
+    ok(stats.memfile_cache_evict > 0)
+    eq(lines, meths.buf_get_lines(0, 0, -1, true))
+    stats = meths._stats()
+    ok(stats.memfile_cache_bytes <= 256 * 1024)
+    ok(stats.memfile_cache_miss > 0)
+    command('$')
+    command('1')
+    ok(meths._stats().memfile_cache_hit > stats.memfile_cache_hit)
+  end)
+end)
+
+describe('swapfile writes', function()
+  local swapdir = lfs.currentdir()..'/Xtest_swapwrite_dir'
+  before_each(function()
+    clear()
+    rmdir(swapdir)
+    lfs.mkdir(swapdir)
+  end)
+  after_each(function()
+    command('%bwipeout!')
+    rmdir(swapdir)
+  end)
+
+  it('are done in the background when idle', function()
+    source([[
+      set directory^=]]..swapdir:gsub([[\]], [[\\]])..[[//
+      set swapfile updatetime=20
+    ]])
+    command('edit! Xtest_swapwrite_file1')
+    local written = meths._stats().memfile_async_write
+    feed('isometext_in_the_swapfile<esc>')
+    local swapname = eval('swapname("%")')
+    helpers.retry(nil, 5000, function()
+      -- Only the writer thread counts its writes.
+      ok(meths._stats().memfile_async_write > written)
+      local f = assert(io.open(swapname, 'rb'))
+      local data = f:read('*a')
+      f:close()
+      ok(data:find('sometext_in_the_swapfile', 1, true) ~= nil)
+    end)
+    -- Recovering in another instance finds the text, without a :preserve.
+    local nvim2 = spawn({nvim_prog, '-u', 'NONE', '-i', 'NONE', '--embed'},
+                        true)
+    set_session(nvim2)
+    source([[
+      set directory^=]]..swapdir:gsub([[\]], [[\\]])..[[//
+      set swapfile
+      autocmd SwapExists * let v:swapchoice = 'r'
+    ]])
+    command('silent edit! Xtest_swapwrite_file1')
+    expect('sometext_in_the_swapfile')
+  end)
+end)
@@ -14,6 +14,14 @@ local iswin = helpers.iswin
 local fname = 'Xtest-functional-ex_cmds-write'
 local fname_bak = fname .. '~'
 local fname_broken = fname_bak .. 'broken'
+local fname_filter = fname .. '-filter'
+
+local function read_file(name)
+  local file = io.open(name, 'rb')
+  local ret = file:read('*a')
+  file:close()
+  return ret
+end
 
 describe(':write', function()
   local function cleanup()
@@ -23,6 +31,7 @@ describe(':write', function()
     os.remove(fname)
     os.remove(fname_bak)
     os.remove(fname_broken)
+    os.remove(fname_filter)
   end
   before_each(function()
     clear()
@@ -91,6 +100,38 @@ describe(':write', function()
     fifo:close()
   end)
 
+  it('writes many lines, long lines and NULs', function()
+    local lines = {}
+    for i = 1, 3000 do
+      lines[i] = ('line %d'):format(i)
+    end
+    lines[10] = ('x'):rep(20000)
+    lines[20] = 'NUL\0 and CR\r'
+    meths.buf_set_lines(0, 0, -1, true, lines)
+    -- Changed line which is not stored in its block yet.
+    funcs.setline(30, 'changed')
+    lines[30] = 'changed'
+    eq(lines, meths.buf_get_lines(0, 0, -1, true))
+    for ff, eol in pairs({unix = '\n', dos = '\r\n', mac = '\r'}) do
+      local text = {}
+      for i, line in ipairs(lines) do
+        -- Mac: CRs are written as NLs.
+        text[i] = ff == 'mac' and (line:gsub('\r', '\n')) or line
+      end
+      command('set fileformat=' .. ff)
+      command('write! ' .. fname)
+      eq(table.concat(text, eol) .. eol, read_file(fname))
+    end
+    command('set fileformat=unix nofixendofline noendofline')
+    command('write! ' .. fname)
+    eq(table.concat(lines, '\n'), read_file(fname))
+    if not iswin() then
+      command('set noshelltemp')
+      command('silent 5,$write !cat > ' .. fname_filter)
+      eq(table.concat(lines, '\n', 5), read_file(fname_filter))
+    end
+  end)
+
   it('errors out correctly', function()
     command('let $HOME=""')
     eq(funcs.fnamemodify('.', ':p:h'), funcs.fnamemodify('.', ':p:h:~'))
@@ -130,3 +171,84 @@ describe(':write', function()
        exc_exec('write!'))
   end)
 end)
+
+describe("'writebackground'", function()
+  local function cleanup()
+    os.remove('test_bkc_file.txt')
+    os.remove('test_bkc_link.txt')
+    os.remove(fname)
+  end
+  before_each(function()
+    clear()
+    cleanup()
+    command('set writebackground')
+  end)
+  after_each(function()
+    cleanup()
+  end)
+
+  it('writes the file and finishes the write when done', function()
+    write_file(fname, 'content0\n')
+    if not iswin() then
+      funcs.setfperm(fname, 'rw-r-----')
+    end
+    command('edit ' .. fname)
+    command('autocmd BufWritePost * let g:modified = &modified')
+    funcs.setline(1, {'line1', 'line2'})
+    command('write')
+    helpers.retry(nil, nil, function()
+      eq(0, eval('get(g:, "modified", -1)'))
+    end)
+    eq({'line1', 'line2'}, funcs.readfile(fname))
+    if not iswin() then
+      eq('rw-r-----', funcs.getfperm(fname))
+    end
+    helpers.ok(eval('execute("messages")'):find(
+      '"' .. fname .. '" 2L, 12B written', 1, true) ~= nil)
+    -- The temp file was renamed.
+    eq({}, funcs.glob('.' .. fname .. '.*~', false, true))
+  end)
+
+  it('changing the buffer waits for the write to finish', function()
+    write_file(fname, 'content0\n')
+    command('edit ' .. fname)
+    funcs.setline(1, 'line1')
+    command('write | call setline(1, "line2")')
+    eq({'line1'}, funcs.readfile(fname))
+    eq(1, eval('&modified'))
+    eq({'line2'}, meths.buf_get_lines(0, 0, -1, true))
+  end)
+
+  it('BufWritePost can wipe out the buffer', function()
+    write_file(fname, 'content0\n')
+    command('edit ' .. fname)
+    command('autocmd BufWritePost * ++once bwipe!')
+    funcs.setline(1, 'line1')
+    -- Changing the buffer waits for the write but doesn't execute
+    -- BufWritePost, that happens later.
+    command('write | call setline(1, "line2")')
+    eq({'line1'}, funcs.readfile(fname))
+    helpers.retry(nil, nil, function()
+      eq(0, funcs.bufexists(fname))
+    end)
+    eq(2, eval('1 + 1'))
+  end)
+
+  it('writes a symlink the usual way', function()
+    write_file('test_bkc_file.txt', 'content0')
+    if iswin() then
+      command("silent !mklink test_bkc_link.txt test_bkc_file.txt")
+    else
+      command("silent !ln -s test_bkc_file.txt test_bkc_link.txt")
+    end
+    if eval('v:shell_error') ~= 0 then
+      pending('Cannot create symlink')
+    end
+    command('edit test_bkc_link.txt')
+    funcs.setline(1, 'content1')
+    command('write')
+    eq(0, eval('&modified'))
+    eq('link', funcs.getftype('test_bkc_link.txt'))
+    eq({'content1'}, funcs.readfile('test_bkc_file.txt'))
+  end)
+end)
@@ -4,7 +4,9 @@ local clear = helpers.clear
 local eq = helpers.eq
 local eval = helpers.eval
 local exec = helpers.exec
+local exec_lua = helpers.exec_lua
 local mkdir_p = helpers.mkdir_p
+local retry = helpers.retry
 local rmdir = helpers.rmdir
 local write_file = helpers.write_file
 
@@ -137,5 +139,95 @@ describe('runtime:', function()
     end)
   end)
 
+  describe('file index', function()
+    it('finds files created after a search', function()
+      local dir = eval('getcwd()') .. sep .. 'Xrtp_index'
+      mkdir_p(dir)
+      exec('set rtp^=' .. dir)
+
+      exec('runtime! syntax/indexed.vim')
+      exec([[
+        call mkdir(']] .. dir .. [[/syntax', 'p')
+        call writefile(['let g:indexed = 1'], ']] .. dir .. [[/syntax/indexed.vim')
+        runtime! syntax/indexed.vim
+      ]])
+      eq(1, eval('g:indexed'))
+
+      -- Files created by another process are seen once the watcher fires.
+      write_file(dir .. sep .. 'syntax' .. sep .. 'other.vim', [[let g:other = 1]])
+      retry(nil, 1000, function()
+        exec('runtime! syntax/other.vim')
+        eq(1, eval('get(g:, "other")'))
+      end)
+
+      exec('set rtp-=' .. dir)
+      rmdir(dir)
+    end)
+
+    it('expands wildcards in a runtimepath entry', function()
+      local dir = eval('getcwd()') .. sep .. 'Xrtp_wild'
+      mkdir_p(dir .. sep .. 'bundle' .. sep .. 'one' .. sep .. 'syntax')
+      write_file(table.concat({dir, 'bundle', 'one', 'syntax', 'wild.vim'}, sep),
+                 [[let g:wild = 1]])
+      exec('set rtp^=' .. dir .. '/bundle/*')
+      exec('runtime! syntax/wild.vim')
+      eq(1, eval('get(g:, "wild")'))
+      exec('set rtp-=' .. dir .. '/bundle/*')
+      rmdir(dir)
+    end)
+  end)
+
+  describe('lua modules', function()
+    local lua_folder = table.concat({plug_dir, 'lua'}, sep)
+
+    it('are reloaded from cache after they change', function()
+      local module_file = table.concat({lua_folder, 'cached_mod.lua'}, sep)
+      mkdir_p(lua_folder)
+      write_file(module_file, [[return 1]])
+
+      exec_lua([[vim.luacache.clear()]])
+      exec_lua([[vim.luacache.enable()]])
+      local reload = [[
+        package.loaded.cached_mod = nil
+        return require('cached_mod')
+      ]]
+      eq(1, exec_lua(reload))
+      eq({chunk_hits = 0, index_hits = 0}, exec_lua([[return vim.luacache._stats()]]))
+      eq(1, exec_lua(reload))
+      eq({chunk_hits = 1, index_hits = 1}, exec_lua([[return vim.luacache._stats()]]))
+      write_file(module_file, [[return 'changed']])
+      eq('changed', exec_lua(reload))
+      exec_lua([[vim.luacache.clear()]])
+      eq('changed', exec_lua(reload))
+      exec_lua([[vim.luacache.disable()]])
+      rmdir(lua_folder)
+    end)
+
+    it('finds a module added before the remembered one', function()
+      local early = 'Xluacache_early'
+      mkdir_p(early)
+      mkdir_p(lua_folder)
+      write_file(table.concat({lua_folder, 'shadow_mod.lua'}, sep), [[return 'late']])
+      exec('set rtp^=' .. early)
+
+      exec_lua([[vim.luacache.enable()]])
+      eq('late', exec_lua([[return require('shadow_mod')]]))
+      exec_lua([[
+        vim.luacache._save_index()
+        vim.luacache.disable()
+        vim.fn.mkdir(']] .. early .. [[/lua', 'p')
+        vim.fn.writefile({"return 'early'"}, ']] .. early .. [[/lua/shadow_mod.lua')
+        package.loaded.shadow_mod = nil
+        vim.luacache.enable()
+      ]])
+      eq('early', exec_lua([[return require('shadow_mod')]]))
+
+      exec_lua([[vim.luacache.disable()]])
+      exec('set rtp-=' .. early)
+      rmdir(early)
+      rmdir(lua_folder)
+    end)
+  end)
+
 end)
 
@@ -711,6 +711,12 @@ describe('lua stdlib', function()
     ]]))
     eq({NIL, NIL}, exec_lua([[return vim.fn.Nilly()]]))
 
+    -- lists of strings, also mixed with other values
+    eq({'c', 'b', 'a'}, exec_lua([[return vim.fn.reverse({'a', 'b', 'c'})]]))
+    eq({'a', '', 1, {'b'}, 'c'},
+       exec_lua([[return vim.fn.copy({'a', '', 1, {'b'}, 'c'})]]))
+    eq({'a', 2}, exec_lua([[return vim.fn.copy({'a', 2})]]))
+
     -- error handling
     eq({false, 'Vim:E714: List required'}, exec_lua([[return {pcall(vim.fn.add, "aa", "bb")}]]))
   end)
@@ -61,13 +61,15 @@ describe(':set validation', function()
     should_fail('timeoutlen', -1, 'E487')
     should_fail('history', 1000000, 'E474')
     should_fail('regexpengine', -1, 'E474')
-    should_fail('regexpengine', 3, 'E474')
-    should_succeed('regexpengine', 2)
+    should_fail('regexpengine', 4, 'E474')
+    should_succeed('regexpengine', 3)
     should_fail('report', -1, 'E487')
     should_succeed('report', 0)
     should_fail('sidescroll', -1, 'E487')
     should_fail('cmdwinheight', 0, 'E487')
     should_fail('updatetime', -1, 'E487')
+    should_fail('vimgrepprefetch', -1, 'E487')
+    should_fail('swapcache', -1, 'E487')
 
     should_fail('foldlevel', -5, 'E487')
     should_fail('foldcolumn', '13', 'E474')
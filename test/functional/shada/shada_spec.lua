@@ -238,6 +238,77 @@ describe('ShaDa support code', function()
     eq('', meths.get_option('shada'))
   end)
 
+  it('appends to the file on exit', function()
+    local tmpname = meths.get_var('tmpname')
+    local count = function(typ)
+      local found = 0
+      for _, v in ipairs(read_shada_file(tmpname)) do
+        if v.type == typ then
+          found = found + 1
+        end
+      end
+      return found
+    end
+    funcs.setreg('a', 'foo')
+    nvim_command('qall')
+    eq(1, count(1))
+    reset()
+    funcs.setreg('b', 'bar')
+    nvim_command('qall')
+    -- Second header starts the appended part.
+    eq(2, count(1))
+    reset()
+    eq('foo', funcs.getreg('a'))
+    eq('bar', funcs.getreg('b'))
+    nvim_command('wshada')
+    eq(1, count(1))
+    reset()
+    eq('foo', funcs.getreg('a'))
+    eq('bar', funcs.getreg('b'))
+  end)
+
+  it('merges v:oldfiles and numbered marks from appended parts', function()
+    local fname1 = 'Xtest-functional-shada-shada-1'
+    local fname2 = 'Xtest-functional-shada-shada-2'
+    write_file(fname1, 'foo\n')
+    write_file(fname2, 'bar\n')
+    nvim_command('edit ' .. fname1)
+    nvim_command('qall')
+    -- Timestamps have a resolution of one second.
+    helpers.sleep(1100)
+    reset()
+    nvim_command('edit ' .. fname2)
+    nvim_command('qall')
+    reset()
+    local oldfiles = meths.get_vvar('oldfiles')
+    eq(funcs.fnamemodify(fname2, ':p'), oldfiles[1])
+    eq(funcs.fnamemodify(fname1, ':p'), oldfiles[2])
+    nvim_command('normal! `0')
+    eq(fname2, funcs.bufname('%'))
+    nvim_command('normal! `1')
+    eq(fname1, funcs.bufname('%'))
+    os.remove(fname1)
+    os.remove(fname2)
+  end)
+
+  it('keeps history and registers which were not used', function()
+    funcs.histadd(':', 'echo "foo"')
+    funcs.setreg('a', 'foo')
+    nvim_command('qall')
+    reset()
+    -- Neither is used before exiting, so they are not loaded.
+    nvim_command('qall')
+    reset()
+    eq('echo "foo"', funcs.histget(':', -1))
+    eq('foo', funcs.getreg('a'))
+    funcs.histadd(':', 'echo "bar"')
+    nvim_command('wshada')
+    reset()
+    eq('echo "foo"', funcs.histget(':', -2))
+    eq('echo "bar"', funcs.histget(':', -1))
+    eq('foo', funcs.getreg('a'))
+  end)
+
   it('does not crash when ShaDa file directory is not writable', function()
     if helpers.pending_win32(pending) then return end
 